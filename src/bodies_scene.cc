@@ -0,0 +1,170 @@
+// Scene of bodies simulated on an update thread.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "bodies_scene.hh"
+#include "gl_state.hh"
+#include "program_builder.hh"
+#include "shader.hh"
+#include "triple_buffer.hh"
+#include "vertices.hh"
+
+#include <algorithm>
+#include <ostream>
+#include <random>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+const char* vertex_shader_src =
+#include "shaders/instanced.vert"
+;
+
+const char* fragment_shader_src =
+#include "shaders/color.frag"
+;
+
+const char* vertex_shader_file = "instanced.vert";
+const char* fragment_shader_file = "color.frag";
+
+const float k_scale = 0.03f;
+const float k_gravity = -2.0f; // Viewport heights per second squared
+
+}; // namespace
+
+BodiesScene::~BodiesScene()
+{
+    GlState::current().delete_vertex_arrays(1, &vao);
+    GlState::current().delete_buffers(1, &instance_vbo);
+    GlState::current().delete_buffers(1, &vbo);
+}
+
+void BodiesScene::load(ProgramBuilder& programs)
+{
+    programs.add(vertex_shader_src, fragment_shader_src, program,
+                 vertex_shader_file, fragment_shader_file);
+
+    std::mt19937 random(0);
+    std::uniform_real_distribution<float> position(-1.0f + k_scale,
+                                                   1.0f - k_scale);
+    std::uniform_real_distribution<float> velocity(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    std::vector<Copies::Instance> data;
+    data.reserve(k_body_count);
+    bodies.resize(k_body_count);
+    for (Body& body : bodies)
+    {
+        body.position = {position(random), position(random)};
+        body.velocity = {velocity(random), velocity(random)};
+        data.emplace_back(Offset({body.position[0], body.position[1], 0.0f}),
+                          Tint({unit(random), unit(random), 1.0f}));
+    }
+    copies.reset(new Copies(std::move(data)));
+
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &instance_vbo);
+    glGenVertexArrays(1, &vao);
+    vertices_color_2d_triangle.use(vao, vbo);
+    copies->use(vao, instance_vbo, 2, GlUsage::STREAM_DRAW);
+}
+
+void BodiesScene::prepare()
+{
+    program->use();
+    program->set_uniform("uScale", k_scale);
+}
+
+void BodiesScene::draw(double time)
+{
+    const Snapshot& snapshot = snapshots.read();
+    if (snapshot.current.empty())
+        return;
+
+    ++frames;
+    if (snapshot.time != last_step_time)
+    {
+        ++steps_drawn;
+        last_step_time = snapshot.time;
+    }
+
+    /// Draw the state one step ago, so that frames between steps move
+    /// smoothly from the previous positions to the current ones
+    float alpha = std::clamp((time - snapshot.time) / snapshot.step, 0.0,
+                             1.0);
+    std::vector<Copies::Instance>& data = copies->get_data();
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        const Point& previous = snapshot.previous[i];
+        const Point& current = snapshot.current[i];
+        Offset::Data& offset = get<0>(data[i]).m_data;
+        offset.x = previous[0] + (current[0] - previous[0]) * alpha;
+        offset.y = previous[1] + (current[1] - previous[1]) * alpha;
+    }
+    copies->update(instance_vbo);
+
+    program->use();
+    GlState::current().bind_vertex_array(vao);
+    vertices_color_2d_triangle.draw(GL_TRIANGLES, copies->size());
+}
+
+void BodiesScene::update(double time, double step)
+{
+    Snapshot& snapshot = snapshots.write_buffer();
+    snapshot.previous.resize(bodies.size());
+    snapshot.current.resize(bodies.size());
+
+    const float dt = step;
+    const float limit = 1.0f - k_scale;
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        Body& body = bodies[i];
+        snapshot.previous[i] = body.position;
+
+        body.velocity[1] += k_gravity * dt;
+        for (int axis = 0; axis < 2; ++axis)
+        {
+            /// Reflect off the edges, keeping the energy of the bodies
+            float& position = body.position[axis];
+            float& velocity = body.velocity[axis];
+            position += velocity * dt;
+            if (position < -limit || position > limit)
+            {
+                position = std::clamp(position, -limit, limit);
+                velocity = -velocity;
+            }
+        }
+        snapshot.current[i] = body.position;
+    }
+
+    snapshot.time = time;
+    snapshot.step = step;
+    snapshots.publish();
+}
+
+void BodiesScene::report(std::ostream& os) const
+{
+    os << "Bodies: " << k_body_count << ", frames drawn per simulation step: "
+       << (steps_drawn ? static_cast<double>(frames) / steps_drawn : 0.0)
+       << std::endl;
+}
+
+}; // namespace demonia
@@ -0,0 +1,100 @@
+// Scene of bodies simulated on an update thread.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_BODIES_SCENE_HH_
+#define DEMONIA_SRC_BODIES_SCENE_HH_
+
+#include "program_builder.hh"
+#include "scene.hh"
+#include "shader.hh"
+#include "triple_buffer.hh"
+#include "vertices.hh"
+
+#include <array>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Draws k_body_count tinted copies of vertices_color_2d_triangle falling
+// under gravity and bouncing off the edges of the viewport. The bodies are
+// simulated at a fixed time step on the update thread, which publishes the
+// positions before and after each step through a triple buffer; each frame
+// draws the positions interpolated between the latest two, one step behind
+// the simulation.
+typedef class BodiesScene : public Scene
+{
+public:
+    static const unsigned int k_body_count = 4096;
+
+    ~BodiesScene() override;
+
+    void load(ProgramBuilder& programs) override;
+
+    void prepare() override;
+
+    void draw(double time) override;
+
+    bool is_simulated() const override
+    {
+        return true;
+    }
+
+    void update(double time, double step) override;
+
+    // Outputs the number of frames drawn from each simulation step.
+    void report(std::ostream& os) const override;
+
+private:
+    typedef Instances<Offset, Tint> Copies;
+    typedef std::array<GLfloat, 2> Point;
+
+    typedef struct Body
+    {
+        Point position;
+        Point velocity;
+    } Body;
+
+    // Positions of the bodies before and after the step ending at 'time'.
+    typedef struct Snapshot
+    {
+        double time = 0.0;
+        double step = 0.0;
+        std::vector<Point> previous;
+        std::vector<Point> current;
+    } Snapshot;
+
+    std::vector<Body> bodies; // Owned by the update thread once started
+    TripleBuffer<Snapshot> snapshots;
+
+    std::unique_ptr<ShaderProgram> program;
+    std::unique_ptr<Copies> copies;
+    GLuint vbo = 0;          // Vertex Buffer Object
+    GLuint instance_vbo = 0; // Vertex Buffer Object of the instances
+    GLuint vao = 0;          // Vertex Array Object
+
+    double last_step_time = -1.0;
+    unsigned long frames = 0;
+    unsigned long steps_drawn = 0;
+} BodiesScene;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_BODIES_SCENE_HH_
@@ -0,0 +1,88 @@
+// Axis-aligned bounding boxes and view frustums.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "bounds.hh"
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+// Returns the signed distance to a plane, scaled by the length of its
+// normal, of the corner of a box furthest along the normal if 'positive',
+// or furthest against it otherwise.
+inline GLfloat corner_distance(const Plane& plane, const Aabb& box,
+                               bool positive) noexcept
+{
+    GLfloat result = 0.0f;
+    for (int i = 0; i < 3; ++i)
+    {
+        bool use_max = (plane.normal[i] >= 0.0f) == positive;
+        result += plane.normal[i] * (use_max ? box.max[i] : box.min[i]);
+    }
+    return result + plane.distance;
+}
+
+}; // namespace
+
+Frustum Frustum::from_matrix(const GLfloat matrix[16]) noexcept
+{
+    // Rows of the matrix, as a point p is inside if -w <= x, y, z <= w for
+    // its clip coordinates (x, y, z, w) = (row0·p, row1·p, row2·p, row3·p)
+    GLfloat rows[4][4];
+    for (int row = 0; row < 4; ++row)
+    {
+        for (int column = 0; column < 4; ++column)
+            rows[row][column] = matrix[column * 4 + row];
+    }
+
+    Frustum frustum;
+    for (int i = 0; i < 6; ++i)
+    {
+        const GLfloat* axis = rows[i / 2];
+        GLfloat sign = i % 2 == 0 ? 1.0f : -1.0f;
+        Plane& plane = frustum.planes[i];
+        for (int j = 0; j < 3; ++j)
+            plane.normal[j] = rows[3][j] + sign * axis[j];
+        plane.distance = rows[3][3] + sign * axis[3];
+    }
+    return frustum;
+}
+
+bool Frustum::intersects(const Aabb& box) const noexcept
+{
+    for (const Plane& plane : planes)
+    {
+        if (corner_distance(plane, box, true) < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::contains(const Aabb& box) const noexcept
+{
+    for (const Plane& plane : planes)
+    {
+        if (corner_distance(plane, box, false) < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+}; // namespace demonia
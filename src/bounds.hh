@@ -0,0 +1,105 @@
+// Axis-aligned bounding boxes and view frustums.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_BOUNDS_HH_
+#define DEMONIA_SRC_BOUNDS_HH_
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Axis-aligned bounding box, empty when created.
+typedef struct Aabb
+{
+    /// An empty box has min > max; FLT_MAX rather than infinity keeps plane
+    /// tests against it free of NaNs
+    GLfloat min[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    GLfloat max[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+    // Returns whether the box contains no point.
+    inline bool is_empty() const noexcept
+    {
+        return min[0] > max[0] || min[1] > max[1] || min[2] > max[2];
+    }
+
+    // Grows the box to contain a point.
+    inline void extend(GLfloat x, GLfloat y, GLfloat z) noexcept
+    {
+        const GLfloat point[3] = {x, y, z};
+        for (int i = 0; i < 3; ++i)
+        {
+            min[i] = std::min(min[i], point[i]);
+            max[i] = std::max(max[i], point[i]);
+        }
+    }
+
+    // Grows the box to contain another box.
+    inline void extend(const Aabb& other) noexcept
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            min[i] = std::min(min[i], other.min[i]);
+            max[i] = std::max(max[i], other.max[i]);
+        }
+    }
+
+    // Returns the box moved by an offset.
+    inline Aabb translated(GLfloat x, GLfloat y, GLfloat z) const noexcept
+    {
+        if (is_empty())
+            return *this;
+        return {{min[0] + x, min[1] + y, min[2] + z},
+                {max[0] + x, max[1] + y, max[2] + z}};
+    }
+} Aabb;
+
+// Plane of points p where dot(normal, p) + distance = 0, facing the side
+// where it is positive.
+typedef struct Plane
+{
+    GLfloat normal[3];
+    GLfloat distance;
+} Plane;
+
+// Volume bounded by six planes facing inwards: left, right, bottom, top,
+// near and far.
+typedef struct Frustum
+{
+    std::array<Plane, 6> planes;
+
+    // Returns the frustum of a column-major view-projection matrix mapping
+    // world space to GL clip space, after Gribb and Hartmann. The planes are
+    // not normalized, which is enough for testing on which side a point
+    // lies.
+    static Frustum from_matrix(const GLfloat matrix[16]) noexcept;
+
+    // Returns whether a box lies at least partly inside the frustum. Boxes
+    // outside it but crossing several planes near a corner may be reported
+    // inside.
+    bool intersects(const Aabb& box) const noexcept;
+
+    // Returns whether a box lies entirely inside the frustum.
+    bool contains(const Aabb& box) const noexcept;
+} Frustum;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_BOUNDS_HH_
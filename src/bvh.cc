@@ -0,0 +1,477 @@
+// Flat bounding volume hierarchy for frustum culling.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "bounds.hh"
+#include "bvh.hh"
+#include "job_system.hh"
+#include "packing.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ios>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DEMONIA_BVH_X86
+#include <immintrin.h>
+#endif
+
+namespace demonia
+{
+
+namespace
+{
+
+// Objects in a hierarchy below which it is culled on the calling thread
+// only.
+const size_t k_parallel_threshold = 16384;
+
+// Subtrees culled in parallel per worker, so that the work can be balanced.
+const size_t k_subtrees_per_worker = 4;
+
+// Plane of a frustum prepared for testing nodes: the rows of the node bounds
+// holding the corner of each box furthest along the normal ('outer') and
+// against it ('inner').
+typedef struct NodePlane
+{
+    GLfloat normal[3];
+    GLfloat distance;
+    int outer[3];
+    int inner[3];
+} NodePlane;
+
+typedef GLfloat NodeBounds[6][Bvh::k_width];
+
+// Kernels testing the children of a node against the six planes of a
+// frustum. Each returns the mask of children at least partly inside, and
+// sets 'inside' to the mask of those entirely inside. They compute the
+// distances in the same order without fused multiply-adds, so that all
+// levels give identical results.
+typedef unsigned int (*NodeTest)(const NodeBounds& bounds,
+                                 const NodePlane* planes,
+                                 unsigned int& inside);
+
+// Returns the distance to a plane, scaled by the length of its normal, of
+// the corner of a child held in the given rows.
+inline GLfloat corner_distance(const NodeBounds& bounds,
+                               const NodePlane& plane, const int* rows,
+                               unsigned int lane) noexcept
+{
+    GLfloat result = plane.normal[0] * bounds[rows[0]][lane];
+    result += plane.normal[1] * bounds[rows[1]][lane];
+    result += plane.normal[2] * bounds[rows[2]][lane];
+    return result + plane.distance;
+}
+
+unsigned int test_node_scalar(const NodeBounds& bounds,
+                              const NodePlane* planes, unsigned int& inside)
+{
+    unsigned int visible = 0;
+    inside = 0;
+    for (unsigned int lane = 0; lane < Bvh::k_width; ++lane)
+    {
+        bool outside = false;
+        bool crossing = false;
+        for (int i = 0; i < 6; ++i)
+        {
+            const NodePlane& plane = planes[i];
+            outside |= corner_distance(bounds, plane, plane.outer, lane)
+                       < 0.0f;
+            crossing |= corner_distance(bounds, plane, plane.inner, lane)
+                        < 0.0f;
+        }
+        visible |= static_cast<unsigned int>(!outside) << lane;
+        inside |= static_cast<unsigned int>(!crossing) << lane;
+    }
+    return visible;
+}
+
+#ifdef DEMONIA_BVH_X86
+
+// Returns the distances of the corners of four children from 'lane'.
+__attribute__((target("sse4.1")))
+inline __m128 corner_distance_sse41(const NodeBounds& bounds,
+                                    const NodePlane& plane, const int* rows,
+                                    unsigned int lane) noexcept
+{
+    __m128 x = _mm_load_ps(&bounds[rows[0]][lane]);
+    __m128 y = _mm_load_ps(&bounds[rows[1]][lane]);
+    __m128 z = _mm_load_ps(&bounds[rows[2]][lane]);
+    __m128 result = _mm_mul_ps(_mm_set1_ps(plane.normal[0]), x);
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(plane.normal[1]), y));
+    result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(plane.normal[2]), z));
+    return _mm_add_ps(result, _mm_set1_ps(plane.distance));
+}
+
+__attribute__((target("sse4.1")))
+unsigned int test_node_sse41(const NodeBounds& bounds,
+                             const NodePlane* planes, unsigned int& inside)
+{
+    const __m128 zero = _mm_setzero_ps();
+    unsigned int visible = 0;
+    inside = 0;
+    for (unsigned int lane = 0; lane < Bvh::k_width; lane += 4)
+    {
+        __m128 outside = zero;
+        __m128 crossing = zero;
+        for (int i = 0; i < 6; ++i)
+        {
+            const NodePlane& plane = planes[i];
+            __m128 outer = corner_distance_sse41(bounds, plane, plane.outer,
+                                                 lane);
+            __m128 inner = corner_distance_sse41(bounds, plane, plane.inner,
+                                                 lane);
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(outer, zero));
+            crossing = _mm_or_ps(crossing, _mm_cmplt_ps(inner, zero));
+        }
+        visible |= (~_mm_movemask_ps(outside) & 0xf) << lane;
+        inside |= (~_mm_movemask_ps(crossing) & 0xf) << lane;
+    }
+    return visible;
+}
+
+// Returns the distances of the corners of all eight children.
+__attribute__((target("avx2")))
+inline __m256 corner_distance_avx2(const NodeBounds& bounds,
+                                   const NodePlane& plane, const int* rows)
+    noexcept
+{
+    __m256 x = _mm256_load_ps(bounds[rows[0]]);
+    __m256 y = _mm256_load_ps(bounds[rows[1]]);
+    __m256 z = _mm256_load_ps(bounds[rows[2]]);
+    __m256 result = _mm256_mul_ps(_mm256_set1_ps(plane.normal[0]), x);
+    result = _mm256_add_ps(result,
+                           _mm256_mul_ps(_mm256_set1_ps(plane.normal[1]), y));
+    result = _mm256_add_ps(result,
+                           _mm256_mul_ps(_mm256_set1_ps(plane.normal[2]), z));
+    return _mm256_add_ps(result, _mm256_set1_ps(plane.distance));
+}
+
+__attribute__((target("avx2")))
+unsigned int test_node_avx2(const NodeBounds& bounds,
+                            const NodePlane* planes, unsigned int& inside)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 outside = zero;
+    __m256 crossing = zero;
+    for (int i = 0; i < 6; ++i)
+    {
+        const NodePlane& plane = planes[i];
+        __m256 outer = corner_distance_avx2(bounds, plane, plane.outer);
+        __m256 inner = corner_distance_avx2(bounds, plane, plane.inner);
+        outside = _mm256_or_ps(outside,
+                               _mm256_cmp_ps(outer, zero, _CMP_LT_OQ));
+        crossing = _mm256_or_ps(crossing,
+                                _mm256_cmp_ps(inner, zero, _CMP_LT_OQ));
+    }
+    inside = ~_mm256_movemask_ps(crossing) & 0xff;
+    return ~_mm256_movemask_ps(outside) & 0xff;
+}
+
+#endif // DEMONIA_BVH_X86
+
+// Spreads the low 10 bits of a value to every third bit.
+inline uint32_t spread_bits(uint32_t value) noexcept
+{
+    value = (value * 0x00010001u) & 0xff0000ffu;
+    value = (value * 0x00000101u) & 0x0f00f00fu;
+    value = (value * 0x00000011u) & 0xc30c30c3u;
+    value = (value * 0x00000005u) & 0x49249249u;
+    return value;
+}
+
+// Returns the 30-bit Morton code of the centre of a box, quantized within
+// the bounds of the scene.
+uint32_t morton_code(const Aabb& box, const Aabb& bounds) noexcept
+{
+    uint32_t code = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        GLfloat extent = bounds.max[i] - bounds.min[i];
+        GLfloat center = box.min[i] * 0.5f + box.max[i] * 0.5f;
+        GLfloat t = extent > 0.0f ? (center - bounds.min[i]) / extent : 0.0f;
+        t = std::min(std::max(t, 0.0f), 1.0f);
+        code |= spread_bits(static_cast<uint32_t>(t * 1023.0f)) << (2 - i);
+    }
+    return code;
+}
+
+// Stores a box as a child of a node.
+inline void set_child(NodeBounds& bounds, unsigned int lane, const Aabb& box)
+    noexcept
+{
+    for (int i = 0; i < 3; ++i)
+    {
+        bounds[i][lane] = box.min[i];
+        bounds[3 + i][lane] = box.max[i];
+    }
+}
+
+// Returns the box containing every child of a node.
+inline Aabb node_bounds(const NodeBounds& bounds) noexcept
+{
+    Aabb result;
+    for (unsigned int lane = 0; lane < Bvh::k_width; ++lane)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            result.min[i] = std::min(result.min[i], bounds[i][lane]);
+            result.max[i] = std::max(result.max[i], bounds[3 + i][lane]);
+        }
+    }
+    return result;
+}
+
+}; // namespace
+
+// State of a traversal by one worker: the prepared planes, and the run of
+// visible objects not yet passed to the function, which is extended while
+// visible objects are adjacent in tree order.
+class Bvh::Traversal
+{
+public:
+    Traversal(const NodePlane* planes, NodeTest test, const uint32_t* order,
+              const VisibleFunction& function, unsigned int worker,
+              Counters& counters)
+            : planes{planes}, test{test}, counters{counters},
+              m_order{order}, m_function{function}, m_worker{worker}
+    {
+    }
+
+    // Adds the objects [begin, end) in tree order to the visible ones.
+    void accept(size_t begin, size_t end)
+    {
+        if (begin != m_end)
+        {
+            flush();
+            m_begin = begin;
+        }
+        m_end = end;
+    }
+
+    // Passes the pending run of visible objects to the function.
+    void flush()
+    {
+        if (m_end > m_begin)
+        {
+            m_function(m_order + m_begin, m_end - m_begin, m_worker);
+            counters.visible += m_end - m_begin;
+        }
+        m_begin = m_end;
+    }
+
+    const NodePlane* planes;
+    NodeTest test;
+    Counters& counters;
+
+private:
+    const uint32_t* m_order;
+    const VisibleFunction& m_function;
+    unsigned int m_worker;
+    size_t m_begin = 0;
+    size_t m_end = 0;
+};
+
+Bvh::Bvh(const std::vector<Aabb>& boxes)
+{
+    build(boxes);
+}
+
+void Bvh::build(const std::vector<Aabb>& boxes)
+{
+    m_nodes.clear();
+    m_levels.clear();
+    m_order.resize(boxes.size());
+    m_bounds = Aabb();
+    for (const Aabb& box : boxes)
+        m_bounds.extend(box);
+    if (boxes.empty())
+        return;
+
+    // Order the objects along a Morton curve, breaking ties by index so that
+    // the order is deterministic
+    std::vector<uint64_t> keys(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i)
+        keys[i] = static_cast<uint64_t>(morton_code(boxes[i], m_bounds)) << 32
+                  | i;
+    std::sort(keys.begin(), keys.end());
+    for (size_t i = 0; i < keys.size(); ++i)
+        m_order[i] = static_cast<uint32_t>(keys[i]);
+
+    // Group the objects into leaves, then each level's nodes into the level
+    // above, until one node remains
+    size_t children = boxes.size();
+    size_t span = 1;
+    while (true)
+    {
+        Level level{m_nodes.size(), children, span};
+        size_t count = (children + k_width - 1) / k_width;
+        m_nodes.resize(level.begin + count);
+        for (size_t i = 0; i < count * k_width; ++i)
+        {
+            Aabb box;
+            if (i < children && m_levels.empty())
+                box = boxes[m_order[i]];
+            else if (i < children)
+                box = node_bounds(m_nodes[m_levels.back().begin + i].bounds);
+            set_child(m_nodes[level.begin + i / k_width].bounds, i % k_width,
+                      box);
+        }
+        m_levels.push_back(level);
+        if (count == 1)
+            break;
+        children = count;
+        span *= k_width;
+    }
+}
+
+size_t Bvh::cull(const Frustum& frustum, const VisibleFunction& function,
+                 JobSystem* jobs, SimdLevel level)
+{
+    m_level = level > simd_level() ? simd_level() : level;
+    NodeTest test = test_node_scalar;
+#ifdef DEMONIA_BVH_X86
+    if (m_level == SimdLevel::AVX2)
+        test = test_node_avx2;
+    else if (m_level == SimdLevel::SSE41)
+        test = test_node_sse41;
+#endif
+
+    // Select the rows of the node bounds holding the outer and inner corners
+    NodePlane planes[6];
+    for (int i = 0; i < 6; ++i)
+    {
+        const Plane& plane = frustum.planes[i];
+        planes[i].distance = plane.distance;
+        for (int j = 0; j < 3; ++j)
+        {
+            bool positive = plane.normal[j] >= 0.0f;
+            planes[i].normal[j] = plane.normal[j];
+            planes[i].outer[j] = positive ? 3 + j : j;
+            planes[i].inner[j] = positive ? j : 3 + j;
+        }
+    }
+
+    unsigned int workers = jobs ? jobs->size() : 1;
+    m_counters.assign(workers, Counters{});
+    ++m_culls;
+
+    if (!m_levels.empty())
+    {
+        // Defer the subtrees of the highest level with enough of them to
+        // share between the workers
+        size_t root = m_levels.size() - 1;
+        size_t stop = 0;
+        bool parallel = workers > 1 && size() >= k_parallel_threshold;
+        if (parallel)
+        {
+            stop = root - 1;
+            while (stop > 0
+                   && m_levels[stop].children / k_width
+                      < workers * k_subtrees_per_worker)
+                --stop;
+        }
+
+        m_deferred.clear();
+        Traversal top(planes, test, m_order.data(), function, 0,
+                      m_counters[0]);
+        visit(root, 0, top, stop, parallel ? &m_deferred : nullptr);
+        top.flush();
+
+        if (!m_deferred.empty())
+        {
+            jobs->parallel_for(m_deferred.size(), 1,
+                [&](size_t begin, size_t end, unsigned int worker)
+                {
+                    Traversal traversal(planes, test, m_order.data(),
+                                        function, worker,
+                                        m_counters[worker]);
+                    for (size_t i = begin; i < end; ++i)
+                        visit(stop, m_deferred[i], traversal);
+                    traversal.flush();
+                });
+        }
+    }
+
+    size_t visible = 0;
+    for (const Counters& counters : m_counters)
+    {
+        m_objects_tested += counters.objects_tested;
+        m_nodes_tested += counters.nodes_tested;
+        visible += counters.visible;
+    }
+    m_culled += size() - visible;
+    return visible;
+}
+
+void Bvh::visit(size_t level, size_t node, Traversal& traversal, size_t stop,
+                std::vector<size_t>* deferred) const
+{
+    const Level& current = m_levels[level];
+    size_t first = node * k_width;
+    unsigned int count = std::min<size_t>(k_width, current.children - first);
+    unsigned int inside;
+    unsigned int visible = traversal.test(m_nodes[current.begin + node].bounds,
+                                          traversal.planes, inside)
+                           & ((1u << count) - 1);
+    if (level == 0)
+        traversal.counters.objects_tested += count;
+    else
+        traversal.counters.nodes_tested += count;
+
+    for (unsigned int lane = 0; lane < count; ++lane)
+    {
+        if (!(visible >> lane & 1))
+            continue;
+
+        size_t child = first + lane;
+        if (level == 0 || inside >> lane & 1)
+        {
+            /// Every object under a child inside the frustum is visible
+            traversal.accept(child * current.span,
+                             std::min((child + 1) * current.span, size()));
+        }
+        else if (deferred && level - 1 == stop)
+        {
+            deferred->push_back(child);
+        }
+        else
+        {
+            visit(level - 1, child, traversal, stop, deferred);
+        }
+    }
+}
+
+void Bvh::report(std::ostream& os) const
+{
+    double culls = m_culls ? static_cast<double>(m_culls) : 1.0;
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1)
+       << "Frustum culling (" << simd_level_name(m_level) << "): "
+       << size() << " objects in " << m_nodes.size() << " nodes, per frame "
+       << m_objects_tested / culls << " object and " << m_nodes_tested / culls
+       << " node boxes tested, " << m_culled / culls << " objects culled ("
+       << (size() && m_culls ? 100.0 * m_culled / (size() * culls) : 0.0)
+       << "%)" << std::endl;
+    os.flags(flags);
+}
+
+}; // namespace demonia
@@ -0,0 +1,140 @@
+// Flat bounding volume hierarchy for frustum culling.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_BVH_HH_
+#define DEMONIA_SRC_BVH_HH_
+
+#include "bounds.hh"
+#include "job_system.hh"
+#include "packing.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Hierarchy of the bounding boxes of a set of objects, culled against view
+// frustums. The objects are ordered along a Morton curve through the centres
+// of their boxes and grouped k_width at a time into leaf nodes, and the
+// nodes of each level k_width at a time into those of the level above, up
+// to a single root. The levels are stored one after another with the
+// children of a node adjacent, so the tree needs no pointers and the objects
+// under any node form a contiguous run. Each node holds the boxes of its
+// children as one array per coordinate, so that it is tested against a
+// plane with one AVX2 or two SSE comparisons.
+typedef class Bvh
+{
+public:
+    // Children of each node.
+    static const unsigned int k_width = 8;
+
+    // Function called with a run of indices of visible objects, into the
+    // vector of boxes the hierarchy was built from, by the worker of the
+    // given index.
+    typedef std::function<void(const uint32_t* objects, size_t count,
+                               unsigned int worker)> VisibleFunction;
+
+    // Creates an empty hierarchy.
+    Bvh() = default;
+
+    // Creates a hierarchy of the boxes of a set of objects.
+    explicit Bvh(const std::vector<Aabb>& boxes);
+
+    // Rebuilds the hierarchy for a new set of boxes.
+    void build(const std::vector<Aabb>& boxes);
+
+    // Calls 'function' on every object whose box intersects a frustum, and
+    // returns the number of them. The children of nodes inside the frustum
+    // are accepted without being tested. If a job system is given and the
+    // hierarchy is large enough, the subtrees below the top levels are
+    // culled in parallel on its workers, which may call 'function'
+    // concurrently; the call must then come from the thread which created
+    // the job system. A SIMD level higher than simd_level() is lowered to
+    // it.
+    size_t cull(const Frustum& frustum, const VisibleFunction& function,
+                JobSystem* jobs = nullptr, SimdLevel level = simd_level());
+
+    // Returns the number of objects.
+    inline size_t size() const noexcept
+    {
+        return m_order.size();
+    }
+
+    // Returns the box containing every object.
+    inline const Aabb& get_bounds() const noexcept
+    {
+        return m_bounds;
+    }
+
+    // Outputs the number of objects and nodes, and the mean number of
+    // object and node boxes tested and of objects culled per call to cull().
+    void report(std::ostream& os) const;
+
+private:
+    typedef struct alignas(32) Node
+    {
+        // Minimum x, y and z and maximum x, y and z of each child, empty for
+        // missing children.
+        GLfloat bounds[6][k_width];
+    } Node;
+
+    typedef struct Level
+    {
+        size_t begin;    // Index of the first node
+        size_t children; // Objects or nodes below the level
+        size_t span;     // Objects under each child
+    } Level;
+
+    // Per-worker statistics of a call to cull().
+    typedef struct alignas(64) Counters
+    {
+        uint64_t objects_tested;
+        uint64_t nodes_tested;
+        uint64_t visible;
+    } Counters;
+
+    class Traversal;
+
+    // Tests the children of a node of a level, visiting those crossing the
+    // frustum. Children in the level 'stop' are appended to 'deferred', if
+    // given, instead of being visited.
+    void visit(size_t level, size_t node, Traversal& traversal,
+               size_t stop = 0, std::vector<size_t>* deferred = nullptr)
+        const;
+
+    std::vector<Node> m_nodes;
+    std::vector<Level> m_levels; // From the leaves up to the root
+    std::vector<uint32_t> m_order; // Indices of the objects in tree order
+    Aabb m_bounds;
+
+    std::vector<Counters> m_counters; // Per worker
+    std::vector<size_t> m_deferred; // Subtrees culled in parallel
+    SimdLevel m_level = SimdLevel::SCALAR; // Of the latest call to cull()
+    uint64_t m_culls = 0;
+    uint64_t m_objects_tested = 0;
+    uint64_t m_nodes_tested = 0;
+    uint64_t m_culled = 0;
+} Bvh;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_BVH_HH_
@@ -0,0 +1,164 @@
+// Scene streaming per-vertex colours every frame.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "color_stream_scene.hh"
+#include "gl_state.hh"
+#include "program_builder.hh"
+#include "streaming_buffer.hh"
+#include "vertices.hh"
+
+#include <cmath>
+#include <ios>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+// Returns the colour of a vertex at a position at a time, cheap enough to
+// be recomputed for every vertex each frame.
+inline Color::Data shade(const Position::Data& position, float phase)
+    noexcept
+{
+    return {0.5f + 0.5f * position.x * phase,
+            0.5f + 0.5f * position.y * (1.0f - phase),
+            phase};
+}
+
+}; // namespace
+
+template<typename Storage>
+ColorStreamScene<Storage>::ColorStreamScene(bool streamed)
+        : m_streamed{streamed}
+{
+}
+
+template<typename Storage>
+ColorStreamScene<Storage>::~ColorStreamScene()
+{
+    GlState::current().delete_vertex_arrays(1, &vao);
+    GlState::current().delete_buffers(vbos.size(), vbos.data());
+}
+
+template<typename Storage>
+void ColorStreamScene<Storage>::load(ProgramBuilder& programs)
+{
+    typedef typename Mesh::Vertex Vertex;
+
+    const float step = 2.0f / k_grid_size;
+    std::vector<Vertex> data;
+    data.reserve(k_grid_size * k_grid_size * 6);
+    for (unsigned int row = 0; row < k_grid_size; ++row)
+    {
+        for (unsigned int column = 0; column < k_grid_size; ++column)
+        {
+            float x0 = -1.0f + column * step;
+            float y0 = -1.0f + row * step;
+            float x1 = x0 + step;
+            float y1 = y0 + step;
+            for (auto [x, y] : {std::pair{x0, y0}, std::pair{x1, y0},
+                                std::pair{x1, y1}, std::pair{x0, y0},
+                                std::pair{x1, y1}, std::pair{x0, y1}})
+                data.emplace_back(Position({x, y, 0.0f}),
+                                  Color({0.0f, 0.0f, 0.0f}));
+        }
+    }
+
+    mesh.reset(new Mesh(data));
+    glGenVertexArrays(1, &vao);
+    if constexpr (std::is_same<Storage, SeparateStorage>::value)
+    {
+        glGenBuffers(vbos.size(), vbos.data());
+        mesh->use(vao, vbos, {GlUsage::STATIC_DRAW, GlUsage::STREAM_DRAW});
+    }
+    else
+    {
+        glGenBuffers(1, vbos.data());
+        mesh->use(vao, vbos[0], GlUsage::STREAM_DRAW);
+    }
+
+    if (m_streamed)
+    {
+        GLsizeiptr frame_size =
+            std::is_same<Storage, SeparateStorage>::value
+            ? sizeof(Color) * mesh->size()
+            : sizeof(typename Mesh::Vertex) * mesh->size();
+        streaming_buffer.reset(new StreamingBuffer(GL_ARRAY_BUFFER,
+                                                   frame_size));
+    }
+}
+
+template<typename Storage>
+void ColorStreamScene<Storage>::draw(double time)
+{
+    float phase = 0.5f + 0.5f * std::sin(static_cast<float>(time));
+    if (streaming_buffer)
+        streaming_buffer->begin_frame();
+
+    if constexpr (std::is_same<Storage, SeparateStorage>::value)
+    {
+        auto& positions = mesh->template get_stream<0>();
+        auto& colors = mesh->template get_stream<1>();
+        for (std::size_t i = 0; i < colors.size(); ++i)
+            colors[i].m_data = shade(positions[i].m_data, phase);
+        if (streaming_buffer)
+            mesh->template stream<1>(vao, *streaming_buffer);
+        else
+            mesh->template update<1>(vbos[1]);
+        bytes_uploaded += sizeof(Color) * colors.size();
+    }
+    else
+    {
+        for (auto& vertex : mesh->get_data())
+            get<1>(vertex).m_data = shade(get<0>(vertex).m_data, phase);
+        if (streaming_buffer)
+            mesh->stream(vao, *streaming_buffer);
+        else
+            mesh->update(vbos[0]);
+        bytes_uploaded += sizeof(typename Mesh::Vertex) * mesh->size();
+    }
+    ++frames;
+
+    GlState::current().bind_vertex_array(vao);
+    glDrawArrays(GL_TRIANGLES, 0, mesh->size());
+    if (streaming_buffer)
+        streaming_buffer->end_frame();
+}
+
+template<typename Storage>
+void ColorStreamScene<Storage>::report(std::ostream& os) const
+{
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3) << "Uploaded per frame: "
+       << (frames ? bytes_uploaded / frames : 0) / (1024.0 * 1024.0)
+       << " MiB" << std::endl;
+    os.flags(flags);
+    if (streaming_buffer)
+        streaming_buffer->report(os);
+}
+
+template class ColorStreamScene<InterleavedStorage>;
+template class ColorStreamScene<SeparateStorage>;
+
+}; // namespace demonia
@@ -0,0 +1,82 @@
+// Scene streaming per-vertex colours every frame.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_COLOR_STREAM_SCENE_HH_
+#define DEMONIA_SRC_COLOR_STREAM_SCENE_HH_
+
+#include "program_builder.hh"
+#include "scene.hh"
+#include "streaming_buffer.hh"
+#include "vertices.hh"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Draws a grid of quads covering the viewport whose colours are recomputed
+// and uploaded every frame while their positions stay constant. With
+// InterleavedStorage every attribute is uploaded again each frame; with
+// SeparateStorage only the colour stream is, so that the two layouts can be
+// compared with the frame statistics. The updated data may be written
+// through a StreamingBuffer instead of being copied into its buffer object
+// again, to compare against implicit synchronisation.
+template<typename Storage>
+class ColorStreamScene : public Scene
+{
+public:
+    // Number of quads along each side of the grid.
+    static const unsigned int k_grid_size = 256;
+
+    // Creates the scene, streaming the updated data through a ring buffer if
+    // streamed is true.
+    explicit ColorStreamScene(bool streamed = false);
+
+    ~ColorStreamScene() override;
+
+    void load(ProgramBuilder& programs) override;
+
+    void draw(double time) override;
+
+    bool is_animated() const override
+    {
+        return true;
+    }
+
+    // Outputs the mean number of bytes uploaded per frame.
+    void report(std::ostream& os) const override;
+
+private:
+    typedef BasicVertices<Storage, Position, Color> Mesh;
+
+    bool m_streamed;
+    std::unique_ptr<Mesh> mesh;
+    std::unique_ptr<StreamingBuffer> streaming_buffer;
+    std::array<GLuint, 2> vbos{}; // One per stream; only the first if
+                                  // interleaved
+    GLuint vao = 0;
+    uint64_t bytes_uploaded = 0;
+    uint64_t frames = 0;
+};
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_COLOR_STREAM_SCENE_HH_
@@ -0,0 +1,91 @@
+// Tracks invalidation of the frame for on-demand rendering.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "damage_tracker.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <ios>
+#include <ostream>
+#include <utility>
+
+namespace demonia
+{
+
+DamageTracker::DamageTracker(std::function<void()> wake)
+        : m_wake{std::move(wake)}, m_start{Clock::now()},
+          m_start_cpu{std::clock()}
+{
+}
+
+void DamageTracker::invalidate() noexcept
+{
+    Clock::rep clean = 0;
+    Clock::rep now = Clock::now().time_since_epoch().count();
+    if (m_damaged_since.compare_exchange_strong(clean, now,
+                                                std::memory_order_acq_rel)
+        && m_wake)
+        m_wake();
+}
+
+void DamageTracker::begin_frame() noexcept
+{
+    m_frame_start = Clock::now();
+    Clock::rep since = m_damaged_since.exchange(0, std::memory_order_acq_rel);
+    m_frame_damaged = since ? Clock::time_point(Clock::duration(since))
+                            : m_frame_start;
+}
+
+void DamageTracker::end_frame() noexcept
+{
+    Clock::time_point now = Clock::now();
+    Clock::duration latency = now - m_frame_damaged;
+    m_busy += now - m_frame_start;
+    m_total_latency += latency;
+    m_max_latency = std::max(m_max_latency, latency);
+    ++m_frames;
+}
+
+void DamageTracker::report(std::ostream& os) const
+{
+    typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+    double wall = std::chrono::duration<double>(Clock::now() - m_start)
+        .count();
+    double cpu = static_cast<double>(std::clock() - m_start_cpu)
+        / CLOCKS_PER_SEC;
+    double idle = wall > 0.0
+        ? 1.0 - std::chrono::duration<double>(m_busy).count() / wall
+        : 0.0;
+    double mean_latency = m_frames
+        ? Milliseconds(m_total_latency).count() / m_frames
+        : 0.0;
+
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1)
+       << "On-demand frames: " << m_frames << ", idle " << 100.0 * idle
+       << "% of the time, CPU usage " << (wall > 0.0 ? 100.0 * cpu / wall
+                                                     : 0.0)
+       << "% of a core" << std::endl
+       << std::setprecision(3)
+       << "Invalidation to present latency (ms): mean " << mean_latency
+       << ", max " << Milliseconds(m_max_latency).count() << std::endl;
+    os.flags(flags);
+}
+
+}; // namespace demonia
@@ -0,0 +1,85 @@
+// Tracks invalidation of the frame for on-demand rendering.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_DAMAGE_TRACKER_HH_
+#define DEMONIA_SRC_DAMAGE_TRACKER_HH_
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <ostream>
+
+namespace demonia
+{
+
+// Records whether the frame has been invalidated since it was last drawn,
+// so that a render loop can sleep until something changes, and measures
+// the latency from the first invalidation of each frame to its
+// presentation, the time spent idle and the CPU time used.
+typedef class DamageTracker
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Creates a tracker which calls 'wake' when the frame is first
+    // invalidated after being drawn, to wake the render thread.
+    explicit DamageTracker(std::function<void()> wake = nullptr);
+
+    // Marks the frame as needing to be redrawn. May be called from any
+    // thread.
+    void invalidate() noexcept;
+
+    inline bool is_damaged() const noexcept
+    {
+        return m_damaged_since.load(std::memory_order_acquire) != 0;
+    }
+
+    // Clears the damage before drawing a frame. Invalidations while the
+    // frame is drawn damage the next one.
+    void begin_frame() noexcept;
+
+    // Records the latency from the first invalidation of the frame, or from
+    // begin_frame() if it was drawn without being invalidated, once it has
+    // been presented.
+    void end_frame() noexcept;
+
+    // Outputs the frames drawn, the latency from invalidation to
+    // presentation, the fraction of time spent idle between frames and the
+    // CPU usage of the process.
+    void report(std::ostream& os) const;
+
+private:
+    std::function<void()> m_wake;
+
+    /// Ticks of Clock since its epoch at the first invalidation, or 0 if
+    /// not damaged
+    std::atomic<Clock::rep> m_damaged_since{0};
+
+    Clock::time_point m_start;
+    std::clock_t m_start_cpu;
+    Clock::time_point m_frame_start;
+    Clock::time_point m_frame_damaged;
+
+    unsigned long m_frames = 0;
+    Clock::duration m_busy{0};
+    Clock::duration m_total_latency{0};
+    Clock::duration m_max_latency{0};
+} DamageTracker;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_DAMAGE_TRACKER_HH_
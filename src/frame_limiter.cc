@@ -0,0 +1,72 @@
+// Paces frames to a target rate on the CPU.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "frame_limiter.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace demonia
+{
+
+const FrameLimiter::Clock::duration FrameLimiter::k_min_spin =
+    std::chrono::microseconds(100);
+const FrameLimiter::Clock::duration FrameLimiter::k_max_spin =
+    std::chrono::milliseconds(4);
+
+FrameLimiter::FrameLimiter(double frame_rate)
+        : m_period{std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(1.0 / frame_rate))},
+          m_spin{std::chrono::milliseconds(1)}
+{
+}
+
+void FrameLimiter::wait()
+{
+    Clock::time_point now = Clock::now();
+    if (!m_started)
+    {
+        m_deadline = now;
+        m_started = true;
+    }
+
+    if (now - m_deadline > m_period)
+    {
+        m_deadline = now + m_period;
+        return;
+    }
+
+    Clock::time_point wake = m_deadline - m_spin;
+    if (now < wake)
+    {
+        std::this_thread::sleep_until(wake);
+
+        /// Track how late the scheduler wakes us and keep the spin margin
+        /// comfortably above it
+        Clock::duration oversleep = Clock::now() - wake;
+        m_oversleep += (oversleep - m_oversleep) / 8;
+        m_spin = std::clamp(2 * m_oversleep + k_min_spin, k_min_spin,
+                            k_max_spin);
+    }
+
+    while (Clock::now() < m_deadline)
+        std::this_thread::yield();
+
+    m_deadline += m_period;
+}
+
+}; // namespace demonia
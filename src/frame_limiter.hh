@@ -0,0 +1,55 @@
+// Paces frames to a target rate on the CPU.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_FRAME_LIMITER_HH_
+#define DEMONIA_SRC_FRAME_LIMITER_HH_
+
+#include <chrono>
+
+namespace demonia
+{
+
+// Limits the frame rate by waiting until each frame's deadline. The thread
+// sleeps until shortly before the deadline and spins for the remainder, with
+// the spin margin adapted to the observed oversleep of the system scheduler,
+// giving sub-millisecond accuracy without spinning for the whole interval.
+typedef class FrameLimiter
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Creates a limiter for a target rate in frames per second.
+    explicit FrameLimiter(double frame_rate);
+
+    // Waits until the deadline of the current frame and schedules the next.
+    // If more than a whole frame behind, the schedule is reset rather than
+    // rendering a burst of frames to catch up.
+    void wait();
+
+private:
+    static const Clock::duration k_min_spin;
+    static const Clock::duration k_max_spin;
+
+    Clock::duration m_period;
+    Clock::duration m_spin;
+    Clock::duration m_oversleep{0}; // Moving average
+    Clock::time_point m_deadline;
+    bool m_started = false;
+} FrameLimiter;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_FRAME_LIMITER_HH_
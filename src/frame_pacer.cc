@@ -0,0 +1,122 @@
+// Bounds the frames in flight on the GPU to reduce latency.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "frame_pacer.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <ios>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+// Returns the value below which a fraction of sorted values fall.
+inline double percentile(const std::vector<double>& sorted, double fraction)
+    noexcept
+{
+    size_t index = std::ceil(fraction * sorted.size());
+    return sorted[std::clamp(index, size_t{1}, sorted.size()) - 1];
+}
+
+}; // namespace
+
+FramePacer::FramePacer(unsigned int frames_in_flight)
+        : m_frames_in_flight{std::clamp(frames_in_flight, 1u,
+                                        k_max_frames_in_flight)}
+{
+}
+
+FramePacer::~FramePacer()
+{
+    for (Frame& frame : m_frames)
+        glDeleteSync(frame.fence);
+}
+
+void FramePacer::begin_frame()
+{
+    retire();
+    if (m_frames.size() >= m_frames_in_flight)
+    {
+        ++m_waits;
+        Clock::time_point start = Clock::now();
+        while (m_frames.size() >= m_frames_in_flight)
+        {
+            glClientWaitSync(m_frames.front().fence,
+                             GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            retire();
+        }
+        m_wait_time += Clock::now() - start;
+    }
+
+    m_input_time = Clock::now();
+}
+
+void FramePacer::end_frame()
+{
+    m_frames.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0),
+                        m_input_time});
+    retire();
+}
+
+void FramePacer::report(std::ostream& os) const
+{
+    typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+    std::vector<double> sorted = m_latencies;
+    std::sort(sorted.begin(), sorted.end());
+    unsigned long frames = m_latencies.size() + m_frames.size();
+
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3)
+       << "Frames in flight: at most " << m_frames_in_flight << ", waited "
+       << m_waits << " times for "
+       << (frames ? Milliseconds(m_wait_time).count() / frames : 0.0)
+       << " ms per frame" << std::endl;
+    if (!sorted.empty())
+    {
+        os << "Estimated input latency (ms): p50 "
+           << 1e3 * percentile(sorted, 0.5) << ", p95 "
+           << 1e3 * percentile(sorted, 0.95) << ", p99 "
+           << 1e3 * percentile(sorted, 0.99) << ", max "
+           << 1e3 * sorted.back() << std::endl;
+    }
+    os.flags(flags);
+}
+
+void FramePacer::retire()
+{
+    while (!m_frames.empty()
+           && glClientWaitSync(m_frames.front().fence, 0, 0)
+              != GL_TIMEOUT_EXPIRED)
+    {
+        std::chrono::duration<double> latency = Clock::now()
+            - m_frames.front().input_time;
+        m_latencies.push_back(latency.count());
+        glDeleteSync(m_frames.front().fence);
+        m_frames.pop_front();
+    }
+}
+
+}; // namespace demonia
@@ -0,0 +1,94 @@
+// Bounds the frames in flight on the GPU to reduce latency.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_FRAME_PACER_HH_
+#define DEMONIA_SRC_FRAME_PACER_HH_
+
+#include <chrono>
+#include <deque>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Limits how many frames the CPU may submit ahead of the GPU. A fence is
+// inserted after each frame, and before starting a frame the oldest fence
+// is waited on while the maximum number of frames is in flight, so that
+// input sampled at the start of a frame is at most that many frames old
+// when it is displayed instead of depending on the queue depth of the
+// driver. The latency from sampling input to the completion of the frame
+// on the GPU is measured as an estimate of input-to-present latency.
+typedef class FramePacer
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static const unsigned int k_max_frames_in_flight = 3;
+
+    // Creates a pacer allowing between 1 and k_max_frames_in_flight frames
+    // in flight.
+    explicit FramePacer(unsigned int frames_in_flight);
+
+    // Deletes the fences of the frames in flight.
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    // Waits until fewer than the maximum frames are in flight, then records
+    // the input sample time of the frame as now.
+    void begin_frame();
+
+    // Records that the input of the frame was sampled again now, later in
+    // the frame.
+    inline void sample_input() noexcept
+    {
+        m_input_time = Clock::now();
+    }
+
+    // Inserts a fence after the commands of the frame.
+    void end_frame();
+
+    // Outputs the maximum frames in flight, the time waited on fences and
+    // percentiles of the estimated input latency.
+    void report(std::ostream& os) const;
+
+private:
+    typedef struct Frame
+    {
+        GLsync fence;
+        Clock::time_point input_time;
+    } Frame;
+
+    // Removes the frames completed by the GPU from the front of m_frames,
+    // recording their latency.
+    void retire();
+
+    unsigned int m_frames_in_flight;
+    std::deque<Frame> m_frames; // Oldest first
+    Clock::time_point m_input_time;
+
+    unsigned long m_waits = 0;
+    Clock::duration m_wait_time{0};
+    std::vector<double> m_latencies; // Seconds
+} FramePacer;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_FRAME_PACER_HH_
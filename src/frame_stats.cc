@@ -0,0 +1,82 @@
+// Accumulates frame times and summarises them.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "frame_stats.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ios>
+#include <iomanip>
+#include <ostream>
+
+namespace demonia
+{
+
+FrameStats::FrameStats(std::size_t expected_frames)
+{
+    m_frame_times.reserve(expected_frames);
+}
+
+void FrameStats::end_frame()
+{
+    std::chrono::duration<double> elapsed = Clock::now() - m_frame_start;
+    m_frame_times.push_back(elapsed.count());
+}
+
+void FrameStats::report(std::ostream& os) const
+{
+    if (m_frame_times.empty())
+    {
+        os << "No frames rendered." << std::endl;
+        return;
+    }
+
+    double total = 0.0;
+    for (double t : m_frame_times)
+        total += t;
+    double mean = total / m_frame_times.size();
+
+    double variance = 0.0;
+    for (double t : m_frame_times)
+        variance += (t - mean) * (t - mean);
+    variance /= m_frame_times.size();
+
+    /// Jitter is the mean absolute change in frame time between consecutive
+    /// frames, which unlike the standard deviation ignores slow drift
+    double jitter = 0.0;
+    for (std::size_t i = 1; i < m_frame_times.size(); ++i)
+        jitter += std::abs(m_frame_times[i] - m_frame_times[i - 1]);
+    if (m_frame_times.size() > 1)
+        jitter /= m_frame_times.size() - 1;
+
+    auto [min, max] = std::minmax_element(m_frame_times.begin(),
+                                          m_frame_times.end());
+
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3)
+       << "Frames: " << m_frame_times.size()
+       << " in " << total << " s (" << m_frame_times.size() / total
+       << " FPS)\n"
+       << "Frame time (ms): mean " << mean * 1e3
+       << ", stddev " << std::sqrt(variance) * 1e3
+       << ", min " << *min * 1e3
+       << ", max " << *max * 1e3
+       << ", jitter " << jitter * 1e3 << std::endl;
+    os.flags(flags);
+}
+
+}; // namespace demonia
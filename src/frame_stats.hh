@@ -0,0 +1,63 @@
+// Accumulates frame times and summarises them.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_FRAME_STATS_HH_
+#define DEMONIA_SRC_FRAME_STATS_HH_
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+namespace demonia
+{
+
+// Records the duration of each rendered frame and summarises them.
+typedef class FrameStats
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Reserves storage for an expected number of frames.
+    explicit FrameStats(std::size_t expected_frames = 0);
+
+    // Marks the start of a frame.
+    inline void begin_frame() noexcept
+    {
+        m_frame_start = Clock::now();
+    }
+
+    // Marks the end of the frame started by the last call to begin_frame()
+    // and records its duration.
+    void end_frame();
+
+    // Returns the number of recorded frames.
+    inline std::size_t count() const noexcept
+    {
+        return m_frame_times.size();
+    }
+
+    // Outputs the frame count, mean frame rate and frame-time mean, standard
+    // deviation, minimum, maximum and jitter in milliseconds.
+    void report(std::ostream& os) const;
+
+private:
+    Clock::time_point m_frame_start;
+    std::vector<double> m_frame_times; // Seconds
+} FrameStats;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_FRAME_STATS_HH_
@@ -0,0 +1,233 @@
+// Scene of objects culled against the view frustum through a BVH.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "bounds.hh"
+#include "bvh.hh"
+#include "frustum_scene.hh"
+#include "gl_state.hh"
+#include "job_system.hh"
+#include "program_builder.hh"
+#include "render_queue.hh"
+#include "shader.hh"
+#include "uniform.hh"
+#include "vertices.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+const char* vertex_shader_src =
+#include "shaders/view.vert"
+;
+
+const char* fragment_shader_src =
+#include "shaders/color.frag"
+;
+
+const char* vertex_shader_file = "view.vert";
+const char* fragment_shader_file = "color.frag";
+
+typedef Vertices<Position, Color> Mesh;
+typedef UniformMatrix<4, 4> Matrix;
+
+// Distance between the centres of adjacent cubes.
+const float k_spacing = 2.0f;
+
+// Distance to the far plane, beyond which cubes are culled.
+const float k_far = 200.0f;
+
+// Returns the product of two column-major matrices.
+Matrix multiply(const Matrix& a, const Matrix& b) noexcept
+{
+    Matrix result{};
+    for (int column = 0; column < 4; ++column)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                result.data[column * 4 + row] += a.data[i * 4 + row]
+                                                 * b.data[column * 4 + i];
+            }
+        }
+    }
+    return result;
+}
+
+// Returns the view-projection matrix of a camera at 'eye' turned by 'yaw'
+// radians about the y axis from looking down -z, with a vertical field of
+// view of 60° and a square viewport.
+Matrix view_projection(const float eye[3], float yaw) noexcept
+{
+    const float near_plane = 0.1f;
+    const float focal = 1.0f / std::tan(0.5236f);
+    const Matrix projection{{
+        focal, 0, 0, 0,
+        0, focal, 0, 0,
+        0, 0, (k_far + near_plane) / (near_plane - k_far), -1,
+        0, 0, 2 * k_far * near_plane / (near_plane - k_far), 0
+    }};
+
+    // Rotation by -yaw, then translation by -eye
+    float c = std::cos(yaw);
+    float s = std::sin(yaw);
+    const Matrix view{{
+        c, 0, s, 0,
+        0, 1, 0, 0,
+        -s, 0, c, 0,
+        -c * eye[0] + s * eye[2], -eye[1], -s * eye[0] - c * eye[2], 1
+    }};
+    return multiply(projection, view);
+}
+
+}; // namespace
+
+FrustumScene::FrustumScene(unsigned int thread_count)
+        : jobs(thread_count), command_lists(jobs.size())
+{
+}
+
+FrustumScene::~FrustumScene()
+{
+    GlState::current().delete_vertex_arrays(1, &vao);
+    GlState::current().delete_buffers(1, &ebo);
+    GlState::current().delete_buffers(1, &vbo);
+}
+
+void FrustumScene::load(ProgramBuilder& programs)
+{
+    programs.add(vertex_shader_src, fragment_shader_src, program,
+                 vertex_shader_file, fragment_shader_file);
+
+    // A unit cube standing on the ground, its corners numbered by the bits
+    // of their x, y and z, and its faces wound counter-clockwise from
+    // outside
+    std::vector<Mesh::Vertex> corners;
+    for (unsigned int i = 0; i < 8; ++i)
+    {
+        float shade = i & 2 ? 1.0f : 0.4f;
+        corners.emplace_back(Position({i & 1 ? 0.5f : -0.5f,
+                                       i & 2 ? 1.0f : 0.0f,
+                                       i & 4 ? 0.5f : -0.5f}),
+                             Color({shade, shade, shade}));
+    }
+    Mesh cube(std::move(corners), {
+        0, 4, 6, 0, 6, 2,  1, 3, 7, 1, 7, 5,
+        0, 1, 5, 0, 5, 4,  2, 6, 7, 2, 7, 3,
+        0, 2, 3, 0, 3, 1,  4, 5, 7, 4, 7, 6
+    });
+
+    // Copies of the cube coloured by their place in the field, each bounded
+    // by the bounds of the cube moved to its place
+    const float half = (k_grid_size - 1) * k_spacing / 2;
+    std::vector<Mesh::Vertex> vertices;
+    vertices.reserve(k_grid_size * k_grid_size * cube.size());
+    boxes.reserve(k_grid_size * k_grid_size);
+    for (unsigned int row = 0; row < k_grid_size; ++row)
+    {
+        for (unsigned int column = 0; column < k_grid_size; ++column)
+        {
+            float x = column * k_spacing - half;
+            float z = row * k_spacing - half;
+            float red = static_cast<float>(column) / k_grid_size;
+            float green = static_cast<float>(row) / k_grid_size;
+            boxes.push_back(cube.get_bounds().translated(x, 0.0f, z));
+
+            for (Mesh::Vertex corner : cube.get_data())
+            {
+                Position::Data& position = get<0>(corner).m_data;
+                Color::Data& color = get<1>(corner).m_data;
+                position.x += x;
+                position.z += z;
+                color = {color.r * red, color.g * green, color.b * 0.5f};
+                vertices.push_back(corner);
+            }
+        }
+    }
+    bvh.build(boxes);
+
+    Mesh mesh(std::move(vertices), cube.get_indices().unpack());
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glGenVertexArrays(1, &vao);
+    mesh.use(vao, vbo, ebo);
+    index_type = mesh.get_indices().get_type();
+}
+
+void FrustumScene::draw(double time)
+{
+    const float eye[3] = {0.0f, 1.5f, 0.0f};
+    const GLuint program_id = program->get_id();
+    Matrix matrix = view_projection(eye, static_cast<float>(time * 0.3));
+
+    bvh.cull(Frustum::from_matrix(matrix.data.data()),
+        [&](const uint32_t* objects, size_t count, unsigned int worker)
+        {
+            CommandList& commands = command_lists[worker];
+            for (size_t i = 0; i < count; ++i)
+            {
+                /// Drawn back to front, as the field has no depth buffer
+                const Aabb& box = boxes[objects[i]];
+                float dx = (box.min[0] + box.max[0]) / 2 - eye[0];
+                float dz = (box.min[2] + box.max[2]) / 2 - eye[2];
+                float depth = std::min(std::sqrt(dx * dx + dz * dz) / k_far,
+                                       1.0f);
+
+                DrawCommand command;
+                command.key = RenderQueue::make_key(0, program_id, vao, 0,
+                                                    depth, true);
+                command.program = program_id;
+                command.vao = vao;
+                command.material = 0;
+                command.mode = GL_TRIANGLES;
+                command.index_type = index_type;
+                command.first = 0;
+                command.count = 36;
+                command.base_vertex = objects[i] * 8;
+                commands.push_back(command);
+            }
+        }, &jobs);
+
+    program->use();
+    program->set_uniform("uViewProjection", matrix);
+    for (CommandList& commands : command_lists)
+    {
+        queue.submit(commands);
+        commands.clear();
+    }
+    GlState::current().enable(GL_CULL_FACE);
+    queue.flush();
+    GlState::current().disable(GL_CULL_FACE);
+}
+
+void FrustumScene::report(std::ostream& os) const
+{
+    bvh.report(os);
+    jobs.report(os);
+    queue.report(os);
+}
+
+}; // namespace demonia
@@ -0,0 +1,80 @@
+// Scene of objects culled against the view frustum through a BVH.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_FRUSTUM_SCENE_HH_
+#define DEMONIA_SRC_FRUSTUM_SCENE_HH_
+
+#include "bvh.hh"
+#include "job_system.hh"
+#include "program_builder.hh"
+#include "render_queue.hh"
+#include "scene.hh"
+#include "shader.hh"
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Draws a field of k_grid_size² cubes seen by a camera turning at its
+// centre. The bounds of the cubes are placed in a bounding volume hierarchy
+// once; each frame it is culled against the view frustum on a job system,
+// and the draws of the visible cubes are recorded into a command list per
+// worker, then submitted to a render queue sorting them back to front.
+typedef class FrustumScene : public Scene
+{
+public:
+    // Number of cubes along each side of the field.
+    static const unsigned int k_grid_size = 256;
+
+    // Creates the scene with a job system of 'thread_count' workers, or one
+    // per core if 0.
+    explicit FrustumScene(unsigned int thread_count = 0);
+
+    ~FrustumScene() override;
+
+    void load(ProgramBuilder& programs) override;
+
+    void draw(double time) override;
+
+    bool is_animated() const override
+    {
+        return true;
+    }
+
+    // Outputs the culling, job system and render queue statistics.
+    void report(std::ostream& os) const override;
+
+private:
+    JobSystem jobs;
+    RenderQueue queue;
+    Bvh bvh;
+    std::unique_ptr<ShaderProgram> program;
+    std::vector<Aabb> boxes; // Per cube
+    std::vector<CommandList> command_lists; // Per worker
+    GLenum index_type = GL_UNSIGNED_INT;
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+    GLuint vao = 0;
+} FrustumScene;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_FRUSTUM_SCENE_HH_
@@ -0,0 +1,384 @@
+// Budgeted asynchronous streaming of mesh files.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "geometry_streamer.hh"
+#include "gl_exception.hh"
+#include "gl_state.hh"
+#include "indices.hh"
+#include "mesh_file.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+// Alignment of chunks in the staging buffer.
+const std::size_t k_staging_alignment = 16;
+
+inline std::size_t align(std::size_t size) noexcept
+{
+    return (size + k_staging_alignment - 1) / k_staging_alignment
+           * k_staging_alignment;
+}
+
+}; // namespace
+
+const std::size_t GeometryStreamer::k_max_chunk_size = 256 * 1024;
+const std::size_t GeometryStreamer::k_max_queued_chunks = 64;
+
+GeometryStreamer::GeometryStreamer(std::size_t budget)
+        : m_budget{std::max(budget, k_staging_alignment)},
+          m_chunk_size{std::min(k_max_chunk_size,
+                                m_budget / k_staging_alignment
+                                * k_staging_alignment)},
+          m_staging{GL_COPY_READ_BUFFER, static_cast<GLsizeiptr>(m_budget)}
+{
+    m_thread = std::thread(&GeometryStreamer::run, this);
+}
+
+GeometryStreamer::~GeometryStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_loader_wake.notify_all();
+    m_thread.join();
+
+    GlState& state = GlState::current();
+    for (std::unique_ptr<Mesh>& mesh : m_meshes)
+    {
+        glDeleteSync(mesh->fence);
+        state.delete_vertex_arrays(1, &mesh->vao);
+        state.delete_buffers(1, &mesh->ebo);
+        state.delete_buffers(1, &mesh->vbo);
+    }
+}
+
+GeometryStreamer::MeshId GeometryStreamer::request(const std::string& path)
+{
+    MeshId id = m_meshes.size();
+    m_meshes.emplace_back(new Mesh());
+    m_meshes.back()->path = path;
+    if (id == m_settled)
+        m_first_request = Clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_requests.push_back({id, path});
+    }
+    m_loader_wake.notify_one();
+    return id;
+}
+
+void GeometryStreamer::upload()
+{
+    // Settle the meshes whose copies have completed
+    for (std::size_t i = 0; i < m_fenced.size();)
+    {
+        Mesh& mesh = *m_meshes[m_fenced[i]];
+        GLenum status = glClientWaitSync(mesh.fence, 0, 0);
+        if (status == GL_TIMEOUT_EXPIRED)
+        {
+            ++i;
+            continue;
+        }
+        glDeleteSync(mesh.fence);
+        mesh.fence = nullptr;
+        settle(mesh, State::RESIDENT);
+        m_fenced[i] = m_fenced.back();
+        m_fenced.pop_back();
+    }
+
+    // Take as many chunks as fit in the budget
+    std::vector<Chunk> chunks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::size_t staged = 0;
+        while (!m_chunks.empty()
+               && align(staged) + m_chunks.front().data.size() <= m_budget)
+        {
+            staged = align(staged) + m_chunks.front().data.size();
+            chunks.push_back(std::move(m_chunks.front()));
+            m_chunks.pop_front();
+        }
+    }
+    if (chunks.empty())
+        return;
+    m_loader_wake.notify_one();
+
+    GlState& state = GlState::current();
+    std::size_t frame_bytes = 0;
+    m_staging.begin_frame();
+    for (Chunk& chunk : chunks)
+    {
+        Mesh& mesh = *m_meshes[chunk.id];
+        if (!chunk.error.empty())
+        {
+            mesh.error = std::move(chunk.error);
+            settle(mesh, State::FAILED);
+            continue;
+        }
+        if (chunk.header)
+            allocate(mesh, chunk);
+
+        if (!chunk.data.empty())
+        {
+            GLintptr offset = m_staging.write(chunk.data.data(),
+                                              chunk.data.size(),
+                                              k_staging_alignment);
+            state.bind_buffer(GL_COPY_WRITE_BUFFER,
+                              chunk.target == GL_ARRAY_BUFFER ? mesh.vbo
+                                                              : mesh.ebo);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                offset, chunk.offset, chunk.data.size());
+            mesh.bytes_uploaded += chunk.data.size();
+            frame_bytes += chunk.data.size();
+            ++m_chunks_uploaded;
+        }
+
+        if (mesh.bytes_uploaded == mesh.bytes)
+        {
+            mesh.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            mesh.state = State::FENCED;
+            m_fenced.push_back(chunk.id);
+        }
+    }
+    m_staging.end_frame();
+
+    if (frame_bytes > 0)
+    {
+        ++m_frames;
+        m_bytes_uploaded += frame_bytes;
+        m_max_frame_bytes = std::max(m_max_frame_bytes, frame_bytes);
+    }
+}
+
+bool GeometryStreamer::draw(MeshId id, GLenum mode,
+                            GLsizei instance_count) const
+{
+    const Mesh& mesh = *m_meshes[id];
+    if (mesh.state != State::RESIDENT)
+        return false;
+
+    GlState::current().bind_vertex_array(mesh.vao);
+    draw_mesh(mesh.header, mode, instance_count);
+    return true;
+}
+
+void GeometryStreamer::report(std::ostream& os) const
+{
+    std::size_t resident = std::count_if(
+            m_meshes.begin(), m_meshes.end(),
+            [](const std::unique_ptr<Mesh>& mesh)
+            {
+                return mesh->state == State::RESIDENT;
+            });
+
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1)
+       << "Geometry streaming: " << resident << " of " << m_meshes.size()
+       << " meshes resident, " << m_bytes_uploaded / (1024.0 * 1024.0)
+       << " MiB in " << m_chunks_uploaded << " chunks over " << m_frames
+       << " frames" << std::endl
+       << "Uploaded per frame (KiB): mean "
+       << (m_frames ? m_bytes_uploaded / m_frames : 0) / 1024.0 << ", max "
+       << m_max_frame_bytes / 1024.0 << ", budget " << m_budget / 1024.0
+       << std::endl;
+    if (is_complete() && resident > 0)
+    {
+        os << std::setprecision(3) << "Time to full residency: "
+           << std::chrono::duration<double, std::milli>(
+                   m_residency_time).count()
+           << " ms" << std::endl;
+    }
+    os.flags(flags);
+
+    /// Copies of a file tend to fail alike, so only the first error is shown
+    auto failed = std::find_if(m_meshes.begin(), m_meshes.end(),
+                               [](const std::unique_ptr<Mesh>& mesh)
+                               {
+                                   return mesh->state == State::FAILED;
+                               });
+    if (failed != m_meshes.end())
+    {
+        os << "Failed to stream "
+           << std::count_if(failed, m_meshes.end(),
+                            [](const std::unique_ptr<Mesh>& mesh)
+                            {
+                                return mesh->state == State::FAILED;
+                            })
+           << " meshes, first: " << (*failed)->error;
+    }
+    m_staging.report(os);
+}
+
+void GeometryStreamer::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_loader_wake.wait(lock, [this]
+                           {
+                               return m_stopping || !m_requests.empty();
+                           });
+        if (m_stopping)
+            return;
+
+        Request request = std::move(m_requests.front());
+        m_requests.pop_front();
+        if (!load(request, lock))
+            return;
+    }
+}
+
+bool GeometryStreamer::load(const Request& request,
+                            std::unique_lock<std::mutex>& lock)
+{
+    lock.unlock();
+    std::unique_ptr<MeshFile> file;
+    std::string error;
+    try
+    {
+        file.reset(new MeshFile(request.path));
+    }
+    catch (MeshFileException& e)
+    {
+        error = e.what();
+    }
+    lock.lock();
+
+    if (!file)
+    {
+        Chunk chunk{request.id, 0, 0};
+        chunk.error = std::move(error);
+        m_chunks.push_back(std::move(chunk));
+        return true;
+    }
+
+    const struct
+    {
+        GLenum target;
+        const unsigned char* data;
+        std::size_t size;
+    } blobs[] = {
+        {GL_ARRAY_BUFFER,
+         static_cast<const unsigned char*>(file->vertex_data()),
+         file->vertex_bytes()},
+        {GL_ELEMENT_ARRAY_BUFFER,
+         static_cast<const unsigned char*>(file->index_data()),
+         file->index_bytes()}};
+
+    bool first = true;
+    for (const auto& blob : blobs)
+    {
+        for (std::size_t offset = 0; offset < blob.size || first;
+             offset += m_chunk_size)
+        {
+            m_loader_wake.wait(lock, [this]
+                               {
+                                   return m_stopping
+                                          || m_chunks.size()
+                                             < k_max_queued_chunks;
+                               });
+            if (m_stopping)
+                return false;
+
+            /// Read the chunk without holding the lock, faulting in its
+            /// pages on this thread rather than the render thread
+            lock.unlock();
+            std::size_t size = std::min(m_chunk_size, blob.size - offset);
+            Chunk chunk{request.id, blob.target, offset};
+            chunk.data.assign(blob.data + offset, blob.data + offset + size);
+            if (first)
+            {
+                chunk.header.reset(new MeshFileHeader(file->get_header()));
+                chunk.attributes.assign(
+                        file->get_attributes(),
+                        file->get_attributes()
+                        + file->get_header().attribute_count);
+                first = false;
+            }
+            lock.lock();
+            m_chunks.push_back(std::move(chunk));
+        }
+    }
+    return true;
+}
+
+void GeometryStreamer::allocate(Mesh& mesh, const Chunk& chunk)
+{
+    const MeshFileHeader& header = *chunk.header;
+    mesh.header = header;
+    mesh.state = State::UPLOADING;
+    std::size_t vertex_bytes = header.vertex_count * header.stride;
+    std::size_t index_bytes = header.index_type == 0 ? 0
+        : header.index_count * index_type_size(header.index_type);
+    mesh.bytes = vertex_bytes + index_bytes;
+
+    GlState& state = GlState::current();
+    glGenVertexArrays(1, &mesh.vao);
+    glGenBuffers(1, &mesh.vbo);
+    state.bind_vertex_array(mesh.vao);
+    state.bind_buffer(GL_ARRAY_BUFFER, mesh.vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertex_bytes, nullptr, GL_STATIC_DRAW);
+
+    std::size_t offset = 0;
+    for (GLuint i = 0; i < chunk.attributes.size(); ++i)
+    {
+        const MeshFileAttribute& attribute = chunk.attributes[i];
+        glVertexAttribPointer(i, attribute.size, attribute.type,
+                              attribute.normalized, header.stride,
+                              reinterpret_cast<const void*>(offset));
+        glEnableVertexAttribArray(i);
+        offset += mesh_attribute_size(attribute);
+    }
+
+    if (index_bytes > 0)
+    {
+        glGenBuffers(1, &mesh.ebo);
+        state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_bytes, nullptr,
+                     GL_STATIC_DRAW);
+    }
+    state.bind_vertex_array(0);
+}
+
+void GeometryStreamer::settle(Mesh& mesh, State state)
+{
+    mesh.state = state;
+    if (++m_settled == m_meshes.size())
+        m_residency_time = Clock::now() - m_first_request;
+}
+
+}; // namespace demonia
@@ -0,0 +1,195 @@
+// Budgeted asynchronous streaming of mesh files.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_GEOMETRY_STREAMER_HH_
+#define DEMONIA_SRC_GEOMETRY_STREAMER_HH_
+
+#include "mesh_file.hh"
+#include "streaming_buffer.hh"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Streams mesh files into GL buffers without stalling the render thread. A
+// loader thread maps each requested file and reads its vertex and index
+// data into chunks; once per frame, the render thread copies queued chunks
+// through a StreamingBuffer into the buffers of their meshes, up to a budget
+// of bytes per frame. A fence placed after the last copy of a mesh tracks
+// its completion on the GPU, after which the mesh is resident and can be
+// drawn. The loader stays at most k_max_queued_chunks ahead of the uploads.
+typedef class GeometryStreamer
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Index of a requested mesh.
+    typedef std::size_t MeshId;
+
+    // Residency of a requested mesh.
+    enum class State
+    {
+        QUEUED,    // Waiting for or being read by the loader thread
+        UPLOADING, // Chunks are being copied into its buffers
+        FENCED,    // Copies issued, waiting for the GPU to complete them
+        RESIDENT,  // Drawable
+        FAILED     // The file could not be read
+    };
+
+    static const std::size_t k_max_chunk_size;
+    static const std::size_t k_max_queued_chunks;
+
+    // Creates a streamer uploading at most 'budget' bytes per frame and
+    // starts its loader thread. Must be called with the GL context current.
+    explicit GeometryStreamer(std::size_t budget);
+
+    // Stops the loader thread and deletes the buffers of every mesh. Must
+    // be called with the GL context current.
+    ~GeometryStreamer();
+
+    GeometryStreamer(const GeometryStreamer&) = delete;
+    GeometryStreamer& operator=(const GeometryStreamer&) = delete;
+
+    // Queues a mesh file to be loaded, returning the id of its mesh.
+    MeshId request(const std::string& path);
+
+    // Uploads queued chunks within the budget and checks the fences of
+    // meshes whose copies have been issued. Called once per frame by the
+    // render thread before drawing.
+    void upload();
+
+    inline State get_state(MeshId id) const noexcept
+    {
+        return m_meshes[id]->state;
+    }
+
+    inline bool is_resident(MeshId id) const noexcept
+    {
+        return get_state(id) == State::RESIDENT;
+    }
+
+    // Returns whether every requested mesh is resident or failed.
+    inline bool is_complete() const noexcept
+    {
+        return m_settled == m_meshes.size();
+    }
+
+    // Returns the header of a mesh which is at least uploading.
+    inline const MeshFileHeader& get_header(MeshId id) const noexcept
+    {
+        return m_meshes[id]->header;
+    }
+
+    // Draws a resident mesh as primitives of a mode for each of a number of
+    // instances, binding its Vertex Array Object. Returns false without
+    // drawing if the mesh is not resident.
+    bool draw(MeshId id, GLenum mode, GLsizei instance_count = 1) const;
+
+    // Outputs the bytes uploaded per frame, the time taken for every mesh
+    // to become resident, and the meshes which failed to load.
+    void report(std::ostream& os) const;
+
+private:
+    // Mesh being streamed. Only accessed by the render thread.
+    typedef struct Mesh
+    {
+        std::string path;
+        State state = State::QUEUED;
+        MeshFileHeader header{};
+        GLuint vbo = 0; // Vertex Buffer Object
+        GLuint ebo = 0; // Element Buffer Object
+        GLuint vao = 0; // Vertex Array Object
+        std::size_t bytes = 0;          // Total size of the data
+        std::size_t bytes_uploaded = 0;
+        GLsync fence = nullptr;
+        std::string error;
+    } Mesh;
+
+    // Range of the vertex or index data of a mesh read by the loader
+    // thread. The first chunk of a mesh carries its header and attributes,
+    // and a chunk with an error replaces the chunks of a mesh which could
+    // not be read.
+    typedef struct Chunk
+    {
+        MeshId id;
+        GLenum target; // GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER
+        std::size_t offset;
+        std::vector<unsigned char> data;
+        std::unique_ptr<MeshFileHeader> header;
+        std::vector<MeshFileAttribute> attributes;
+        std::string error;
+    } Chunk;
+
+    // Mesh file queued for the loader thread.
+    typedef struct Request
+    {
+        MeshId id;
+        std::string path;
+    } Request;
+
+    // Body of the loader thread.
+    void run();
+
+    // Reads a mesh file into chunks, blocking while the queue is full.
+    // Returns false if the streamer is stopping.
+    bool load(const Request& request, std::unique_lock<std::mutex>& lock);
+
+    // Creates the buffers of a mesh from its first chunk and links its
+    // attributes.
+    void allocate(Mesh& mesh, const Chunk& chunk);
+
+    // Marks a mesh as resident or failed, recording the time taken for
+    // every requested mesh to settle.
+    void settle(Mesh& mesh, State state);
+
+    std::size_t m_budget;
+    std::size_t m_chunk_size;
+    StreamingBuffer m_staging;
+    std::vector<std::unique_ptr<Mesh>> m_meshes;
+    std::vector<MeshId> m_fenced; // Meshes waiting for their fences
+    std::size_t m_settled = 0;    // Resident or failed meshes
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_loader_wake; // Requests queued or chunks taken
+    bool m_stopping = false;
+    std::deque<Request> m_requests;
+    std::deque<Chunk> m_chunks;
+
+    Clock::time_point m_first_request;
+    Clock::duration m_residency_time{0}; // First request to all settled
+    uint64_t m_frames = 0;           // Frames in which data was uploaded
+    uint64_t m_bytes_uploaded = 0;
+    std::size_t m_max_frame_bytes = 0;
+    uint64_t m_chunks_uploaded = 0;
+} GeometryStreamer;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_GEOMETRY_STREAMER_HH_
@@ -46,4 +46,25 @@ ProgramLinkException::ProgramLinkException(
 {
 }
 
+ContextException::ContextException(const char info_log[GL_INFO_LOG_LENGTH])
+        : GlException(info_log)
+{
+}
+
+BufferException::BufferException(const char info_log[GL_INFO_LOG_LENGTH])
+        : GlException(info_log)
+{
+}
+
+MeshFileException::MeshFileException(
+        const char info_log[GL_INFO_LOG_LENGTH])
+        : GlException(info_log)
+{
+}
+
+TextureException::TextureException(const char info_log[GL_INFO_LOG_LENGTH])
+        : GlException(info_log)
+{
+}
+
 }; // namespace demonia
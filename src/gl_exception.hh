@@ -66,6 +66,41 @@ public:
     ProgramLinkException(const char info_log[GL_INFO_LOG_LENGTH]);
 };
 
+// Exception raised when a GL context or its rendering target could not be
+// created.
+typedef class ContextException ContextException;
+class ContextException : public GlException
+{
+public:
+    ContextException(const char info_log[GL_INFO_LOG_LENGTH]);
+};
+
+// Exception raised when a buffer object could not be allocated from or
+// mapped, or its data would be invalid.
+typedef class BufferException BufferException;
+class BufferException : public GlException
+{
+public:
+    BufferException(const char info_log[GL_INFO_LOG_LENGTH]);
+};
+
+// Exception raised when a mesh file could not be mapped, is malformed or does
+// not have the expected vertex layout.
+typedef class MeshFileException MeshFileException;
+class MeshFileException : public GlException
+{
+public:
+    MeshFileException(const char info_log[GL_INFO_LOG_LENGTH]);
+};
+
+// Exception raised when a texture could not be created.
+typedef class TextureException TextureException;
+class TextureException : public GlException
+{
+public:
+    TextureException(const char info_log[GL_INFO_LOG_LENGTH]);
+};
+
 }; // namespace demonia
 
 #endif // DEMONIA_SRC_GL_EXCEPTION_HH_
@@ -16,14 +16,30 @@
 
 #define GLFW_INCLUDE_NONE
 
+#include "damage_tracker.hh"
+#include "frame_limiter.hh"
+#include "frame_pacer.hh"
+#include "frame_stats.hh"
 #include "gl_exception.hh"
 #include "gl_handler.hh"
+#include "gl_state.hh"
+#include "headless.hh"
+#include "options.hh"
+#include "profiler.hh"
+#include "program_builder.hh"
+#include "program_cache.hh"
+#include "scene.hh"
 #include "shader.hh"
-#include "vertices.hh"
+#include "shader_reloader.hh"
+#include "update_thread.hh"
 
+#include <chrono>
+#include <cmath>
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <exception>
+#include <fstream>
 #include <iostream>
 
 #include <GL/glew.h>
@@ -38,6 +54,9 @@ const unsigned int GlHandler::k_initial_window_width = 640;
 const unsigned int GlHandler::k_initial_window_height = 480;
 const char* GlHandler::k_window_title = "Demonia";
 
+const char* GlHandler::vertex_shader_file = "color.vert";
+const char* GlHandler::fragment_shader_file = "color.frag";
+
 const char* GlHandler::vertex_shader_src =
 #include "shaders/color.vert"
 ;
@@ -46,10 +65,21 @@ const char* GlHandler::fragment_shader_src =
 #include "shaders/color.frag"
 ;
 
+Options GlHandler::options;
 GLFWwindow* GlHandler::window;
+HeadlessContext* GlHandler::headless_context;
+OffscreenFramebuffer* GlHandler::offscreen_framebuffer;
+Profiler* GlHandler::profiler;
+FrameLimiter* GlHandler::frame_limiter;
+FramePacer* GlHandler::frame_pacer;
+ProgramCache* GlHandler::program_cache;
 ShaderProgram* GlHandler::shader_program;
-GLuint GlHandler::vbo;
-GLuint GlHandler::vao;
+ShaderReloader* GlHandler::shader_reloader;
+GLFWwindow* GlHandler::reload_window;
+HeadlessContext* GlHandler::reload_context;
+Scene* GlHandler::scene;
+UpdateThread* GlHandler::update_thread;
+DamageTracker* GlHandler::damage_tracker;
 
 // Outputs the string identifying an exception to stderr if the string is not
 // empty.
@@ -59,21 +89,277 @@ inline void log_exception(std::exception& e) noexcept
         std::cerr << e.what();
 }
 
-int GlHandler::start()
+int GlHandler::start(const Options& options)
 {
     // Pre-initialisation check
-    if (window)
+    if (window || headless_context)
     {
-        std::cerr << "Failed to start GL handler: a window has already been \
+        std::cerr << "Failed to start GL handler: a context has already been \
                       created" << std::endl;
         return EXIT_FAILURE;
     }
 
+    GlHandler::options = options;
+
+    // Create context
+    if (options.headless ? !create_headless_context() : !create_window())
+        return EXIT_FAILURE;
+
+    if (!load_gl())
+    {
+        destroy_context();
+        return EXIT_FAILURE;
+    }
+
+    if (options.headless)
+    {
+        try
+        {
+            offscreen_framebuffer = new OffscreenFramebuffer(
+                    k_initial_window_width, k_initial_window_height);
+        }
+        catch (ContextException& e)
+        {
+            std::cerr << "Failed to create offscreen framebuffer." << std::endl;
+            log_exception(e);
+            destroy_context();
+            return EXIT_FAILURE;
+        }
+        GlState::current().viewport(0, 0, k_initial_window_width,
+                                    k_initial_window_height);
+    }
+
+    // Load shaders
+    if (options.shader_cache)
+    {
+        program_cache = new ProgramCache(
+                options.shader_cache_directory.empty()
+                    ? ProgramCache::default_directory()
+                    : options.shader_cache_directory);
+    }
+
+    // Load the scene, building its programs in one batch with the default
+    // program
+    scene = create_scene(options);
+    ProgramBuilder program_builder(program_cache);
+    try
+    {
+        std::size_t index = program_builder.add(vertex_shader_src,
+                                                fragment_shader_src);
+        scene->load(program_builder);
+        shader_program = program_builder.finish()[index].release();
+        shader_program->use();
+        scene->prepare();
+    }
+    catch (ShaderCompileException& e)
+    {
+        if (e.get_shader_type() == GL_VERTEX_SHADER)
+            std::cerr << "Failed to compile vertex shader." << std::endl;
+        else if (e.get_shader_type() == GL_FRAGMENT_SHADER)
+            std::cerr << "Failed to compile fragment shader." << std::endl;
+        else
+            std::cerr << "Failed to compile shader." << std::endl;
+
+        log_exception(e);
+        delete scene;
+        scene = nullptr;
+        delete shader_program;
+        shader_program = nullptr;
+        delete program_cache;
+        program_cache = nullptr;
+        destroy_context();
+        return EXIT_FAILURE;
+    }
+    catch (ProgramLinkException& e)
+    {
+        std::cerr << "Failed to link shader program." << std::endl;
+        log_exception(e);
+        delete scene;
+        scene = nullptr;
+        delete shader_program;
+        shader_program = nullptr;
+        delete program_cache;
+        program_cache = nullptr;
+        destroy_context();
+        return EXIT_FAILURE;
+    }
+    catch (GlException& e)
+    {
+        std::cerr << "Failed to load scene '" << options.scene << "'."
+                  << std::endl;
+        log_exception(e);
+        delete scene;
+        scene = nullptr;
+        delete shader_program;
+        shader_program = nullptr;
+        delete program_cache;
+        program_cache = nullptr;
+        destroy_context();
+        return EXIT_FAILURE;
+    }
+
+    // Pre-render setup
+    if (window)
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    apply_present_mode();
+
+    if (options.hot_reload)
+        start_shader_reloader(program_builder.get_sources());
+
+    if (options.profile)
+        profiler = new Profiler();
+
+    if (options.on_demand)
+        start_on_demand();
+
+    // Render
+    FrameStats frame_stats(options.frame_count);
+    std::chrono::steady_clock::time_point start_time =
+        std::chrono::steady_clock::now();
+    if (scene->is_simulated())
+    {
+        update_thread = new UpdateThread(
+                [](double time, double step)
+                {
+                    scene->update(time, step);
+                    if (damage_tracker)
+                        damage_tracker->invalidate();
+                },
+                options.update_rate);
+        update_thread->start(start_time);
+    }
+    for (unsigned long frame = 0; !should_close(frame); ++frame)
+    {
+        if (damage_tracker && !wait_for_damage(start_time))
+            break;
+
+        frame_stats.begin_frame();
+        if (damage_tracker)
+            damage_tracker->begin_frame();
+        GlState::current().begin_frame();
+        if (profiler)
+            profiler->begin_frame();
+
+        if (frame_pacer)
+        {
+            /// Sample input after waiting for the GPU rather than before
+            frame_pacer->begin_frame();
+            if (window)
+            {
+                ProfileScope scope(profiler, ProfileMetric::CPU_POLL);
+                glfwPollEvents();
+            }
+        }
+
+        if (shader_reloader)
+        {
+            if (shader_reloader->update(0, shader_program))
+                shader_program->use();
+
+            /// Uniforms and draw keys set up for the replaced scene programs
+            /// must be set up again for the new ones
+            if (shader_reloader->update_targets())
+            {
+                shader_program->use();
+                scene->prepare();
+            }
+        }
+
+        // Clear framebuffer
+        {
+            ProfileScope scope(profiler, ProfileMetric::GPU_CLEAR);
+            GlState::current().clear_color(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+
+        // Draw
+        {
+            ProfileScope scope(profiler, ProfileMetric::GPU_DRAW);
+            if (options.late_latch)
+            {
+                if (window)
+                    glfwPollEvents();
+                frame_pacer->sample_input();
+            }
+            std::chrono::duration<double> time =
+                std::chrono::steady_clock::now() - start_time;
+            scene->draw(time.count());
+        }
+
+        // End
+        present();
+        if (frame_pacer)
+            frame_pacer->end_frame();
+        if (damage_tracker)
+            damage_tracker->end_frame();
+        if (frame_limiter)
+            frame_limiter->wait();
+        if (profiler)
+            profiler->end_frame();
+        GlState::current().end_frame();
+        frame_stats.end_frame();
+    }
+
+    if (update_thread)
+        update_thread->stop();
+
+    if (options.print_stats)
+    {
+        std::cout << "Present mode: "
+                  << present_mode_name(options.present_mode);
+        if (frame_limiter)
+            std::cout << " (" << options.frame_rate_limit << " FPS)";
+        std::cout << std::endl;
+        frame_stats.report(std::cout);
+        scene->report(std::cout);
+        if (update_thread)
+            update_thread->report(std::cout);
+        if (damage_tracker)
+            damage_tracker->report(std::cout);
+        if (frame_pacer)
+            frame_pacer->report(std::cout);
+        GlState::current().report(std::cout);
+        program_builder.report(std::cout);
+        if (program_cache)
+            program_cache->report(std::cout);
+    }
+
+    delete frame_limiter;
+    frame_limiter = nullptr;
+    delete frame_pacer;
+    frame_pacer = nullptr;
+
+    if (profiler)
+    {
+        report_profile();
+        delete profiler;
+        profiler = nullptr;
+    }
+
+    // Deinitialise GL
+    stop_shader_reloader();
+    delete update_thread;
+    update_thread = nullptr;
+    delete damage_tracker;
+    damage_tracker = nullptr;
+    delete scene;
+    scene = nullptr;
+    delete shader_program;
+    shader_program = nullptr;
+    delete program_cache;
+    program_cache = nullptr;
+    destroy_context();
+
+    return EXIT_SUCCESS;
+}
+
+bool GlHandler::create_window()
+{
     // Initialise GLFW
     if (!glfwInit())
     {
         std::cerr << "Failed to initialise GLFW." << std::endl;
-        return EXIT_FAILURE;
+        return false;
     }
 
     glfwSetErrorCallback(glfw_error_callback);
@@ -96,79 +382,284 @@ int GlHandler::start()
     {
         std::cerr << "Failed to create GLFW window." << std::endl;
         glfwTerminate();
-        return EXIT_FAILURE;
+        return false;
     }
 
     glfwMakeContextCurrent(window);
+    return true;
+}
 
-    // Initialise GLEW to load all OpenGL function pointers
-    if (!glewInit())
+bool GlHandler::create_headless_context()
+{
+    try
     {
-        std::cerr << "Failed to initialise GLEW." << std::endl;
-        glfwDestroyWindow(window);
-        glfwTerminate();
-        return EXIT_FAILURE;
+        headless_context = new HeadlessContext(k_gl_version_major,
+                                               k_gl_version_minor);
     }
-
-    // Load shaders
-    try
+    catch (ContextException& e)
     {
-        shader_program = new ShaderProgram(vertex_shader_src,
-                                           fragment_shader_src);
+        std::cerr << "Failed to create headless GL context." << std::endl;
+        log_exception(e);
+        return false;
     }
-    catch (ShaderCompileException& e)
+
+    return true;
+}
+
+void GlHandler::start_shader_reloader(
+        const std::vector<ProgramBuilder::Source>& sources)
+{
+    ShaderReloader::ContextBinder bind_context;
+    try
     {
-        if (e.get_shader_type() == GL_VERTEX_SHADER)
-            std::cerr << "Failed to compile vertex shader." << std::endl;
-        else if (e.get_shader_type() == GL_FRAGMENT_SHADER)
-            std::cerr << "Failed to compile fragment shader." << std::endl;
+        if (window)
+        {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            reload_window = glfwCreateWindow(1, 1, k_window_title, NULL,
+                                             window);
+            glfwDefaultWindowHints();
+            if (!reload_window)
+                throw ContextException("Failed to create shared context.\n");
+
+            bind_context = [](bool bind)
+                {
+                    glfwMakeContextCurrent(bind ? reload_window : NULL);
+                };
+        }
         else
-            std::cerr << "Failed to compile shader." << std::endl;
+        {
+            reload_context = new HeadlessContext(
+                    k_gl_version_major, k_gl_version_minor, headless_context);
+            headless_context->make_current();
 
-        log_exception(e);
-        return EXIT_FAILURE;
+            bind_context = [](bool bind)
+                {
+                    if (bind)
+                        reload_context->make_current();
+                    else
+                        reload_context->release_current();
+                };
+        }
+
+        shader_reloader = new ShaderReloader(options.shader_directory,
+                                             bind_context);
     }
-    catch (ProgramLinkException& e)
+    catch (std::exception& e)
     {
-        std::cerr << "Failed to link shader program." << std::endl;
+        std::cerr << "Failed to start shader hot-reload." << std::endl;
         log_exception(e);
-        return EXIT_FAILURE;
+        std::cerr << std::endl;
+        stop_shader_reloader();
+        return;
     }
 
-    // Create buffer and array objects
-    glGenBuffers(1, &vbo);
-    glGenVertexArrays(1, &vao);
-    vertices_color_2d_triangle.use(vao, vbo);
+    shader_reloader->watch(vertex_shader_file, fragment_shader_file);
+    for (const ProgramBuilder::Source& source : sources)
+        shader_reloader->watch(source.vertex_file, source.fragment_file,
+                               *source.target);
+    shader_reloader->start();
+}
 
-    // Pre-render setup
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSwapInterval(1);
-    shader_program->use();
+void GlHandler::stop_shader_reloader()
+{
+    delete shader_reloader;
+    shader_reloader = nullptr;
 
-    // Render
-    while (!glfwWindowShouldClose(window))
+    if (reload_window)
     {
-        // Clear framebuffer
-        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        glfwDestroyWindow(reload_window);
+        reload_window = nullptr;
+    }
 
-        // Draw
-        glBindVertexArray(vao);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
+    delete reload_context;
+    reload_context = nullptr;
+}
 
-        // End
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+bool GlHandler::load_gl()
+{
+    // Initialise GLEW to load all OpenGL function pointers
+    glewExperimental = GL_TRUE;
+    GLenum result = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    /// GLEW loads core functions before querying GLX, which is absent for
+    /// EGL contexts without a display server
+    if (headless_context && result == GLEW_ERROR_NO_GLX_DISPLAY)
+        result = GLEW_OK;
+#endif
+    if (result != GLEW_OK)
+    {
+        std::cerr << "Failed to initialise GLEW: " << glewGetErrorString(result)
+                  << std::endl;
+        return false;
     }
 
-    // Deinitialise GL
-    glDeleteVertexArrays(1, &vao);
-    glDeleteBuffers(1, &vbo);
-    delete shader_program;
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    return true;
+}
 
-    return EXIT_SUCCESS;
+void GlHandler::destroy_context()
+{
+    delete offscreen_framebuffer;
+    offscreen_framebuffer = nullptr;
+
+    if (headless_context)
+    {
+        delete headless_context;
+        headless_context = nullptr;
+    }
+
+    if (window)
+    {
+        glfwDestroyWindow(window);
+        window = nullptr;
+        glfwTerminate();
+    }
+}
+
+void GlHandler::apply_present_mode()
+{
+    if (options.present_mode == PresentMode::LIMITED)
+        frame_limiter = new FrameLimiter(options.frame_rate_limit);
+    if (options.frames_in_flight)
+        frame_pacer = new FramePacer(options.frames_in_flight);
+
+    if (!window)
+        return;
+
+    switch (options.present_mode)
+    {
+    case PresentMode::UNCAPPED:
+    case PresentMode::LIMITED:
+        glfwSwapInterval(0);
+        break;
+    case PresentMode::ADAPTIVE:
+        /// A negative interval enables late swap tearing
+        if (glfwExtensionSupported("GLX_EXT_swap_control_tear")
+            || glfwExtensionSupported("WGL_EXT_swap_control_tear"))
+        {
+            glfwSwapInterval(-1);
+            break;
+        }
+        std::cerr << "Adaptive vsync is unsupported; using vsync."
+                  << std::endl;
+        options.present_mode = PresentMode::VSYNC;
+        [[fallthrough]];
+    case PresentMode::VSYNC:
+        glfwSwapInterval(1);
+        break;
+    }
+}
+
+bool GlHandler::should_close(unsigned long frame)
+{
+    if (options.frame_count && frame >= options.frame_count)
+        return true;
+
+    return window && glfwWindowShouldClose(window);
+}
+
+void GlHandler::start_on_demand()
+{
+    damage_tracker = new DamageTracker(glfwPostEmptyEvent);
+
+    glfwSetWindowRefreshCallback(window, [](GLFWwindow*)
+        {
+            damage_tracker->invalidate();
+        });
+    glfwSetKeyCallback(window, [](GLFWwindow*, int, int, int, int)
+        {
+            damage_tracker->invalidate();
+        });
+    glfwSetMouseButtonCallback(window, [](GLFWwindow*, int, int, int)
+        {
+            damage_tracker->invalidate();
+        });
+    glfwSetCursorPosCallback(window, [](GLFWwindow*, double, double)
+        {
+            damage_tracker->invalidate();
+        });
+    glfwSetScrollCallback(window, [](GLFWwindow*, double, double)
+        {
+            damage_tracker->invalidate();
+        });
+
+    /// Draw the first frame
+    damage_tracker->invalidate();
+}
+
+bool GlHandler::wait_for_damage(std::chrono::steady_clock::time_point
+                                    start_time)
+{
+    typedef std::chrono::duration<double> Seconds;
+
+    while (!damage_tracker->is_damaged())
+    {
+        if (glfwWindowShouldClose(window))
+            return false;
+
+        if (!scene->is_animated())
+        {
+            glfwWaitEvents();
+            continue;
+        }
+
+        double now = Seconds(std::chrono::steady_clock::now() - start_time)
+            .count();
+        double tick = (std::floor(now * options.animation_rate) + 1.0)
+            / options.animation_rate;
+        glfwWaitEventsTimeout(tick - now);
+        if (Seconds(std::chrono::steady_clock::now() - start_time).count()
+            >= tick)
+            damage_tracker->invalidate();
+    }
+
+    return true;
+}
+
+void GlHandler::present()
+{
+    if (window)
+    {
+        {
+            ProfileScope scope(profiler, ProfileMetric::CPU_SWAP);
+            glfwSwapBuffers(window);
+        }
+
+        /// With the frame pacer, events are polled after its wait at the
+        /// start of the next frame, so that input is stamped when sampled
+        if (!frame_pacer)
+        {
+            ProfileScope scope(profiler, ProfileMetric::CPU_POLL);
+            glfwPollEvents();
+        }
+    }
+    else
+    {
+        /// Without a swap chain to throttle submission, wait for the frame to
+        /// complete so that frame times include GPU work, unless the frame
+        /// pacer bounds the frames in flight instead
+        ProfileScope scope(profiler, ProfileMetric::CPU_SWAP);
+        if (frame_pacer)
+            glFlush();
+        else
+            glFinish();
+    }
+}
+
+void GlHandler::report_profile()
+{
+    profiler->finish();
+
+    if (options.profile_output.empty())
+    {
+        profiler->report(std::cout);
+        return;
+    }
+
+    std::ofstream file(options.profile_output);
+    profiler->write_csv(file);
+    if (!file)
+        std::cerr << "Failed to write profile to '" << options.profile_output
+                  << "'." << std::endl;
 }
 
 void GlHandler::glfw_error_callback(int error, const char* description)
@@ -180,7 +671,9 @@ void GlHandler::glfw_error_callback(int error, const char* description)
 void GlHandler::framebuffer_size_callback(GLFWwindow* window, int width,
                                           int height)
 {
-    glViewport(0, 0, width, height);
+    GlState::current().viewport(0, 0, width, height);
+    if (damage_tracker)
+        damage_tracker->invalidate();
 }
 
 }; // namespace demonia
@@ -18,7 +18,21 @@
 
 #define GLFW_INCLUDE_NONE
 
+#include "damage_tracker.hh"
+#include "frame_limiter.hh"
+#include "frame_pacer.hh"
+#include "headless.hh"
+#include "options.hh"
+#include "profiler.hh"
+#include "program_builder.hh"
+#include "program_cache.hh"
+#include "scene.hh"
 #include "shader.hh"
+#include "shader_reloader.hh"
+#include "update_thread.hh"
+
+#include <chrono>
+#include <vector>
 
 #include <GLFW/glfw3.h>
 
@@ -34,28 +48,96 @@ public:
     static const unsigned int k_initial_window_width;
     static const unsigned int k_initial_window_height;
     static const char* k_window_title;
+    static const char* vertex_shader_file;
+    static const char* fragment_shader_file;
     static const char* vertex_shader_src;
     static const char* fragment_shader_src;
 
     // Initialises GL and starts graphics rendering; deinitialises GL upon an
-    // exit signal. Returns an exit code.
-    static int start();
+    // exit signal or once the configured number of frames has been rendered.
+    // Returns an exit code.
+    static int start(const Options& options = Options());
 
 private:
+    // Initialises GLFW and creates a window with a current GL context.
+    // Returns false upon failure.
+    static bool create_window();
+
+    // Creates a windowless GL context rendering into an offscreen
+    // framebuffer. Returns false upon failure.
+    static bool create_headless_context();
+
+    // Loads GL function pointers for the current context. Returns false upon
+    // failure.
+    static bool load_gl();
+
+    // Destroys the window or headless context and deinitialises GLFW.
+    static void destroy_context();
+
+    // Sets the swap interval for the configured present mode and creates the
+    // frame limiter and frame pacer if required. Falls back to vsync if
+    // adaptive vsync is unsupported.
+    static void apply_present_mode();
+
+    // Creates a context sharing objects with the render context and starts
+    // watching the shader directory for changes to the default program and to
+    // the scene programs built from sources. Logs a warning and continues
+    // without hot-reload upon failure.
+    static void start_shader_reloader(
+            const std::vector<ProgramBuilder::Source>& sources);
+
+    // Stops watching for shader changes and destroys the shared context.
+    static void stop_shader_reloader();
+
+    // Returns whether rendering should stop after the given number of
+    // rendered frames.
+    static bool should_close(unsigned long frame);
+
+    // Creates the damage tracker of on-demand rendering and invalidates the
+    // frame upon resize, exposure and input events.
+    static void start_on_demand();
+
+    // Blocks in GLFW until the frame is invalidated, or until the next tick
+    // of the animation rate if the scene is animated, given the time of the
+    // first frame. Returns false if the window should close instead.
+    static bool wait_for_damage(std::chrono::steady_clock::time_point
+                                    start_time);
+
+    // Presents a rendered frame: swaps buffers and polls for events when
+    // windowed, or waits for rendering to complete when headless unless
+    // the frame pacer bounds the frames in flight.
+    static void present();
+
+    // Waits for outstanding profiling results and outputs them to stdout or
+    // the configured profile output file.
+    static void report_profile();
+
     // Called when GLFW throws an error; logs the error code and description to
     // stderr.
     static void glfw_error_callback(int error, const char* description)
         noexcept;
 
     // Called when the GL framebuffer is resized; resizes the GL viewport to
-    // the new dimensions of the framebuffer.
+    // the new dimensions of the framebuffer, and invalidates the frame in
+    // on-demand rendering.
     static void framebuffer_size_callback(GLFWwindow* window, int width,
                                           int height);
 
+    static Options options;
     static GLFWwindow* window;
+    static HeadlessContext* headless_context;
+    static OffscreenFramebuffer* offscreen_framebuffer;
+    static Profiler* profiler;
+    static FrameLimiter* frame_limiter;
+    static FramePacer* frame_pacer;
+    static ProgramCache* program_cache;
     static ShaderProgram* shader_program;
-    static GLuint vbo; // Vertex Buffer Object
-    static GLuint vao; // Vertex Array Object
+    static ShaderReloader* shader_reloader;
+    static GLFWwindow* reload_window;
+    static HeadlessContext* reload_context;
+    static Scene* scene;
+    static UpdateThread* update_thread;
+    static DamageTracker* damage_tracker;
 } GlHandler;
 
 }; // namespace demonia
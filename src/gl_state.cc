@@ -0,0 +1,187 @@
+// Shadow of GL context state filtering redundant calls.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_state.hh"
+
+#include <iomanip>
+#include <ios>
+#include <ostream>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+GlState::GlState() noexcept
+{
+    invalidate();
+}
+
+int GlState::capability_index(GLenum capability) noexcept
+{
+    switch (capability)
+    {
+    case GL_BLEND:
+        return 0;
+    case GL_CULL_FACE:
+        return 1;
+    case GL_DEPTH_TEST:
+        return 2;
+    case GL_FRAMEBUFFER_SRGB:
+        return 3;
+    case GL_MULTISAMPLE:
+        return 4;
+    case GL_PRIMITIVE_RESTART:
+        return 5;
+    case GL_SCISSOR_TEST:
+        return 6;
+    case GL_STENCIL_TEST:
+        return 7;
+    default:
+        return -1;
+    }
+}
+
+void GlState::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+    noexcept
+{
+    std::array<GLint, 4> viewport = {x, y, width, height};
+    if (skip(m_viewport_known && m_viewport == viewport))
+        return;
+    m_viewport = viewport;
+    m_viewport_known = true;
+    glViewport(x, y, width, height);
+}
+
+void GlState::clear_color(GLfloat red, GLfloat green, GLfloat blue,
+                          GLfloat alpha) noexcept
+{
+    std::array<GLfloat, 4> color = {red, green, blue, alpha};
+    if (skip(m_clear_color_known && m_clear_color == color))
+        return;
+    m_clear_color = color;
+    m_clear_color_known = true;
+    glClearColor(red, green, blue, alpha);
+}
+
+void GlState::set_enabled(GLenum capability, bool enabled) noexcept
+{
+    int index = capability_index(capability);
+    if (skip(index >= 0 && m_capabilities[index] == enabled))
+        return;
+    if (index >= 0)
+        m_capabilities[index] = enabled;
+
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void GlState::delete_program(GLuint program) noexcept
+{
+    /// A deleted program stays in use until another is used, but it is
+    /// forgotten so that a new program given the same name is used
+    if (m_program == program)
+        m_program = k_unknown;
+    glDeleteProgram(program);
+}
+
+void GlState::delete_vertex_arrays(GLsizei count, const GLuint* vaos)
+    noexcept
+{
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        if (vaos[i] != 0 && m_vao == vaos[i])
+        {
+            m_vao = 0;
+            m_buffers[buffer_index(GL_ELEMENT_ARRAY_BUFFER)] = k_unknown;
+        }
+    }
+    glDeleteVertexArrays(count, vaos);
+}
+
+void GlState::delete_buffers(GLsizei count, const GLuint* buffers) noexcept
+{
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        for (GLuint& binding : m_buffers)
+        {
+            if (buffers[i] != 0 && binding == buffers[i])
+                binding = 0;
+        }
+    }
+    glDeleteBuffers(count, buffers);
+}
+
+void GlState::delete_textures(GLsizei count, const GLuint* textures)
+    noexcept
+{
+    for (GLsizei i = 0; i < count; ++i)
+    {
+        for (std::array<GLuint, k_texture_target_count>& unit : m_textures)
+        {
+            for (GLuint& binding : unit)
+            {
+                if (textures[i] != 0 && binding == textures[i])
+                    binding = 0;
+            }
+        }
+    }
+    glDeleteTextures(count, textures);
+}
+
+void GlState::invalidate() noexcept
+{
+    m_program = k_unknown;
+    m_vao = k_unknown;
+    m_buffers.fill(k_unknown);
+    m_texture_unit = k_unknown;
+    for (std::array<GLuint, k_texture_target_count>& unit : m_textures)
+        unit.fill(k_unknown);
+    m_capabilities.fill(-1);
+    m_viewport_known = false;
+    m_clear_color_known = false;
+}
+
+void GlState::begin_frame() noexcept
+{
+    m_frame_issued = 0;
+    m_frame_skipped = 0;
+}
+
+void GlState::end_frame() noexcept
+{
+    m_issued += m_frame_issued;
+    m_skipped += m_frame_skipped;
+    ++m_frames;
+}
+
+void GlState::report(std::ostream& os) const
+{
+    double frames = m_frames ? m_frames : 1;
+    uint64_t calls = m_issued + m_skipped;
+
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1)
+       << "GL state calls per frame: " << m_issued / frames << " issued, "
+       << m_skipped / frames << " skipped ("
+       << (calls ? 100.0 * m_skipped / calls : 0.0) << "% redundant)"
+       << std::endl;
+    os.flags(flags);
+}
+
+}; // namespace demonia
@@ -0,0 +1,221 @@
+// Shadow of GL context state filtering redundant calls.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_GL_STATE_HH_
+#define DEMONIA_SRC_GL_STATE_HH_
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Shadows the buffer, texture and program bindings, viewport, clear colour
+// and capabilities of the GL context current on the calling thread, so that
+// calls which would not change the state are skipped rather than reaching
+// the driver. State set by calling GL directly is not seen; call
+// invalidate() afterwards so that the next change of each state is issued.
+typedef class GlState
+{
+public:
+    // Returns the state of the context current on the calling thread.
+    static inline GlState& current() noexcept
+    {
+        thread_local GlState state;
+        return state;
+    }
+
+    inline void use_program(GLuint program) noexcept
+    {
+        if (skip(m_program == program))
+            return;
+        m_program = program;
+        glUseProgram(program);
+    }
+
+    // Binding a Vertex Array Object also changes the element array buffer
+    // binding, which is part of its state.
+    inline void bind_vertex_array(GLuint vao) noexcept
+    {
+        if (skip(m_vao == vao))
+            return;
+        m_vao = vao;
+        m_buffers[buffer_index(GL_ELEMENT_ARRAY_BUFFER)] = k_unknown;
+        glBindVertexArray(vao);
+    }
+
+    inline void bind_buffer(GLenum target, GLuint buffer) noexcept
+    {
+        int index = buffer_index(target);
+        if (skip(index >= 0 && m_buffers[index] == buffer))
+            return;
+        if (index >= 0)
+            m_buffers[index] = buffer;
+        glBindBuffer(target, buffer);
+    }
+
+    // Selects the texture unit of later texture bindings.
+    inline void active_texture(GLenum unit) noexcept
+    {
+        if (skip(m_texture_unit == unit))
+            return;
+        m_texture_unit = unit;
+        glActiveTexture(unit);
+    }
+
+    // Binds a texture to a target of the active texture unit. Bindings of
+    // GL_TEXTURE_2D and GL_TEXTURE_2D_ARRAY on the first k_texture_unit_count
+    // units are shadowed.
+    inline void bind_texture(GLenum target, GLuint texture) noexcept
+    {
+        GLuint* binding = texture_binding(target);
+        if (skip(binding && *binding == texture))
+            return;
+        if (binding)
+            *binding = texture;
+        glBindTexture(target, texture);
+    }
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height) noexcept;
+
+    void clear_color(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha)
+        noexcept;
+
+    // Enables or disables a capability with glEnable or glDisable.
+    void set_enabled(GLenum capability, bool enabled) noexcept;
+
+    inline void enable(GLenum capability) noexcept
+    {
+        set_enabled(capability, true);
+    }
+
+    inline void disable(GLenum capability) noexcept
+    {
+        set_enabled(capability, false);
+    }
+
+    // Deletes objects, resetting the bindings shadowed for them to 0 as GL
+    // does, so that a new object given the same name is bound.
+    void delete_program(GLuint program) noexcept;
+    void delete_vertex_arrays(GLsizei count, const GLuint* vaos) noexcept;
+    void delete_buffers(GLsizei count, const GLuint* buffers) noexcept;
+    void delete_textures(GLsizei count, const GLuint* textures) noexcept;
+
+    // Forgets all shadowed state.
+    void invalidate() noexcept;
+
+    // Starts counting the calls of a frame.
+    void begin_frame() noexcept;
+
+    // Adds the calls of the frame to the totals.
+    void end_frame() noexcept;
+
+    // Returns the calls issued to the driver in the current frame.
+    inline uint64_t issued() const noexcept
+    {
+        return m_frame_issued;
+    }
+
+    // Returns the calls skipped as redundant in the current frame.
+    inline uint64_t skipped() const noexcept
+    {
+        return m_frame_skipped;
+    }
+
+    // Outputs the mean calls issued and skipped per frame.
+    void report(std::ostream& os) const;
+
+private:
+    // Marks state which has not been shadowed since the last invalidate().
+    static const GLuint k_unknown = UINT32_MAX;
+
+    // Shadowed buffer targets and capabilities, of which the index is
+    // returned by buffer_index() and capability_index(), or -1 for others.
+    static const int k_buffer_count = 4;
+    static const int k_capability_count = 8;
+
+    // Shadowed texture units and targets per unit.
+    static const int k_texture_unit_count = 16;
+    static const int k_texture_target_count = 2;
+
+    static inline int buffer_index(GLenum target) noexcept
+    {
+        switch (target)
+        {
+        case GL_ARRAY_BUFFER:
+            return 0;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return 1;
+        case GL_PIXEL_PACK_BUFFER:
+            return 2;
+        case GL_PIXEL_UNPACK_BUFFER:
+            return 3;
+        default:
+            return -1;
+        }
+    }
+
+    static int capability_index(GLenum capability) noexcept;
+
+    // Returns the shadowed binding of a target of the active texture unit,
+    // or null if it is not shadowed.
+    inline GLuint* texture_binding(GLenum target) noexcept
+    {
+        GLuint unit = m_texture_unit - GL_TEXTURE0;
+        if (m_texture_unit == k_unknown
+            || unit >= static_cast<GLuint>(k_texture_unit_count))
+            return nullptr;
+        if (target == GL_TEXTURE_2D)
+            return &m_textures[unit][0];
+        if (target == GL_TEXTURE_2D_ARRAY)
+            return &m_textures[unit][1];
+        return nullptr;
+    }
+
+    GlState() noexcept;
+
+    // Counts a call as skipped if redundant, or issued otherwise.
+    inline bool skip(bool redundant) noexcept
+    {
+        ++(redundant ? m_frame_skipped : m_frame_issued);
+        return redundant;
+    }
+
+    GLuint m_program;
+    GLuint m_vao;
+    std::array<GLuint, k_buffer_count> m_buffers;
+    GLenum m_texture_unit;
+    std::array<std::array<GLuint, k_texture_target_count>,
+               k_texture_unit_count> m_textures;
+    std::array<GLint, 4> m_viewport;
+    std::array<GLfloat, 4> m_clear_color;
+    std::array<int8_t, k_capability_count> m_capabilities; // -1 if unknown
+    bool m_viewport_known;
+    bool m_clear_color_known;
+
+    uint64_t m_frame_issued = 0;
+    uint64_t m_frame_skipped = 0;
+    uint64_t m_frames = 0;
+    uint64_t m_issued = 0;
+    uint64_t m_skipped = 0;
+} GlState;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_GL_STATE_HH_
@@ -0,0 +1,69 @@
+// Sizes of GL data types used in vertex attributes.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_GL_TYPE_HH_
+#define DEMONIA_SRC_GL_TYPE_HH_
+
+#include <cstddef>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Returns the size in bytes of a component of a GL data type, or 0 if the
+// type cannot be used in a vertex attribute.
+constexpr size_t gl_type_size(GLenum type) noexcept
+{
+    switch (type)
+    {
+    case GL_BYTE: return sizeof(GLbyte);
+    case GL_UNSIGNED_BYTE: return sizeof(GLubyte);
+    case GL_SHORT: return sizeof(GLshort);
+    case GL_UNSIGNED_SHORT: return sizeof(GLushort);
+    case GL_INT: return sizeof(GLint);
+    case GL_UNSIGNED_INT: return sizeof(GLuint);
+    case GL_HALF_FLOAT: return sizeof(GLhalf);
+    case GL_FLOAT: return sizeof(GLfloat);
+    case GL_DOUBLE: return sizeof(GLdouble);
+    case GL_FIXED: return sizeof(GLfixed);
+    case GL_INT_2_10_10_10_REV: return sizeof(GLint);
+    case GL_UNSIGNED_INT_2_10_10_10_REV: return sizeof(GLuint);
+    case GL_UNSIGNED_INT_10F_11F_11F_REV: return sizeof(GLuint);
+    default: return 0;
+    }
+}
+
+// Returns whether a GL data type packs every component of an attribute into
+// a single value.
+constexpr bool gl_type_is_packed(GLenum type) noexcept
+{
+    return type == GL_INT_2_10_10_10_REV
+           || type == GL_UNSIGNED_INT_2_10_10_10_REV
+           || type == GL_UNSIGNED_INT_10F_11F_11F_REV;
+}
+
+// Returns the size in bytes of an attribute of count components of a GL data
+// type, or 0 if the type cannot be used in a vertex attribute.
+constexpr size_t gl_attribute_size(GLint count, GLenum type) noexcept
+{
+    return gl_type_is_packed(type) ? gl_type_size(type)
+                                   : count * gl_type_size(type);
+}
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_GL_TYPE_HH_
@@ -0,0 +1,41 @@
+// Usage patterns of GL data stores.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_GL_USAGE_HH_
+#define DEMONIA_SRC_GL_USAGE_HH_
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Expected usage patterns of data stores. Castable to GLenum.
+enum class GlUsage
+{
+    STREAM_DRAW = GL_STREAM_DRAW,
+    STREAM_READ = GL_STREAM_READ,
+    STREAM_COPY = GL_STREAM_COPY,
+    STATIC_DRAW = GL_STATIC_DRAW,
+    STATIC_READ = GL_STATIC_READ,
+    STATIC_COPY = GL_STATIC_COPY,
+    DYNAMIC_DRAW = GL_DYNAMIC_DRAW,
+    DYNAMIC_READ = GL_DYNAMIC_READ,
+    DYNAMIC_COPY = GL_DYNAMIC_COPY
+};
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_GL_USAGE_HH_
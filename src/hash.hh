@@ -0,0 +1,60 @@
+// FNV-1a hashing of byte sequences.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_HASH_HH_
+#define DEMONIA_SRC_HASH_HH_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace demonia
+{
+
+// Offset basis and prime of FNV-1a for a hash of 32 or 64 bits.
+template<typename Hash>
+struct Fnv1a;
+
+template<>
+struct Fnv1a<uint32_t>
+{
+    static constexpr uint32_t k_offset = 2166136261u;
+    static constexpr uint32_t k_prime = 16777619u;
+};
+
+template<>
+struct Fnv1a<uint64_t>
+{
+    static constexpr uint64_t k_offset = 14695981039346656037ull;
+    static constexpr uint64_t k_prime = 1099511628211ull;
+};
+
+// Folds a sequence of bytes into an FNV-1a hash, by default starting a new
+// one. Hashing a string literal is a constant expression.
+template<typename Hash>
+constexpr Hash fnv1a(const char* data, std::size_t size,
+                     Hash hash = Fnv1a<Hash>::k_offset) noexcept
+{
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= Fnv1a<Hash>::k_prime;
+    }
+    return hash;
+}
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_HASH_HH_
@@ -0,0 +1,211 @@
+// Windowless GL contexts and offscreen rendering targets.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_exception.hh"
+#include "headless.hh"
+
+#include <cstring>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+bool HeadlessContext::has_extension(const char* extensions, const char* name)
+{
+    if (!extensions)
+        return false;
+
+    size_t length = strlen(name);
+    for (const char* p = extensions; (p = strstr(p, name)); p += length)
+    {
+        bool starts = p == extensions || p[-1] == ' ';
+        bool ends = p[length] == ' ' || p[length] == '\0';
+        if (starts && ends)
+            return true;
+    }
+
+    return false;
+}
+
+EGLDisplay HeadlessContext::get_display()
+{
+    const char* client_extensions = eglQueryString(EGL_NO_DISPLAY,
+                                                   EGL_EXTENSIONS);
+
+    if (has_extension(client_extensions, "EGL_MESA_platform_surfaceless"))
+    {
+        auto get_platform_display =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+                eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (get_platform_display)
+        {
+            EGLDisplay display = get_platform_display(
+                    EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+            if (display != EGL_NO_DISPLAY)
+                return display;
+        }
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+HeadlessContext::HeadlessContext(unsigned int gl_version_major,
+                                 unsigned int gl_version_minor,
+                                 const HeadlessContext* share)
+{
+    if (share)
+    {
+        display = share->display;
+        config = share->config;
+        owns_display = false;
+    }
+    else
+    {
+        display = get_display();
+        if (display == EGL_NO_DISPLAY)
+            throw ContextException("No EGL display available.\n");
+
+        if (!eglInitialize(display, NULL, NULL))
+            throw ContextException("Failed to initialise EGL display.\n");
+    }
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        terminate();
+        throw ContextException("EGL does not support desktop OpenGL.\n");
+    }
+
+    bool surfaceless = has_extension(eglQueryString(display, EGL_EXTENSIONS),
+                                     "EGL_KHR_surfaceless_context");
+
+    if (!share)
+    {
+        const EGLint config_attribs[] = {
+            EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_NONE
+        };
+
+        EGLint config_count = 0;
+        if (!eglChooseConfig(display, config_attribs, &config, 1,
+                             &config_count)
+            || config_count < 1)
+        {
+            terminate();
+            throw ContextException(
+                    "No suitable EGL framebuffer configuration.\n");
+        }
+    }
+
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, static_cast<EGLint>(gl_version_major),
+        EGL_CONTEXT_MINOR_VERSION, static_cast<EGLint>(gl_version_minor),
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+
+    context = eglCreateContext(display, config,
+                               share ? share->context : EGL_NO_CONTEXT,
+                               context_attribs);
+    if (context == EGL_NO_CONTEXT)
+    {
+        terminate();
+        throw ContextException("Failed to create EGL context.\n");
+    }
+
+    if (!surfaceless)
+    {
+        /// A minimal surface is only needed to make the context current;
+        /// rendering goes to an OffscreenFramebuffer.
+        const EGLint pbuffer_attribs[] = {
+            EGL_WIDTH, 1,
+            EGL_HEIGHT, 1,
+            EGL_NONE
+        };
+        surface = eglCreatePbufferSurface(display, config, pbuffer_attribs);
+        if (surface == EGL_NO_SURFACE)
+        {
+            eglDestroyContext(display, context);
+            terminate();
+            throw ContextException("Failed to create EGL pbuffer surface.\n");
+        }
+    }
+
+    make_current();
+}
+
+HeadlessContext::~HeadlessContext()
+{
+    if (eglGetCurrentContext() == context)
+        release_current();
+    if (surface != EGL_NO_SURFACE)
+        eglDestroySurface(display, surface);
+    eglDestroyContext(display, context);
+    terminate();
+}
+
+void HeadlessContext::terminate() noexcept
+{
+    if (owns_display)
+        eglTerminate(display);
+}
+
+void HeadlessContext::make_current() const
+{
+    /// The client API is per-thread state
+    eglBindAPI(EGL_OPENGL_API);
+    if (!eglMakeCurrent(display, surface, surface, context))
+        throw ContextException("Failed to make EGL context current.\n");
+}
+
+void HeadlessContext::release_current() const noexcept
+{
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+OffscreenFramebuffer::OffscreenFramebuffer(GLsizei width, GLsizei height)
+{
+    glGenRenderbuffers(1, &rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, rbo);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        glDeleteFramebuffers(1, &fbo);
+        glDeleteRenderbuffers(1, &rbo);
+        throw ContextException("Offscreen framebuffer is incomplete.\n");
+    }
+}
+
+OffscreenFramebuffer::~OffscreenFramebuffer()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &rbo);
+}
+
+}; // namespace demonia
@@ -0,0 +1,103 @@
+// Windowless GL contexts and offscreen rendering targets.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_HEADLESS_HH_
+#define DEMONIA_SRC_HEADLESS_HH_
+
+#include <EGL/egl.h>
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Creates a GL context without a window or windowing system through EGL,
+// preferring the Mesa surfaceless platform and falling back to a pbuffer
+// surface on the default display.
+typedef class HeadlessContext
+{
+public:
+    // Creates a core profile context of the given version and makes it
+    // current on the calling thread. If a context to share with is given, the
+    // new context shares its objects and EGL display. If no suitable context
+    // can be created, throws a ContextException.
+    HeadlessContext(unsigned int gl_version_major,
+                    unsigned int gl_version_minor,
+                    const HeadlessContext* share = nullptr);
+
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    // Makes the context current on the calling thread.
+    void make_current() const;
+
+    // Releases the context from the calling thread.
+    void release_current() const noexcept;
+
+    // Returns whether the context is rendering without any surface.
+    inline bool is_surfaceless() const noexcept
+    {
+        return surface == EGL_NO_SURFACE;
+    }
+
+private:
+    // Returns whether a space-separated extension string contains the given
+    // extension name.
+    static bool has_extension(const char* extensions, const char* name);
+
+    // Returns the surfaceless platform display if supported, otherwise the
+    // default display.
+    static EGLDisplay get_display();
+
+    // Releases the display if this context initialised it.
+    void terminate() noexcept;
+
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLConfig config;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+    bool owns_display = true; // Shared contexts use their parent's display
+} HeadlessContext;
+
+// Framebuffer Object with a colour renderbuffer, used as the default render
+// target when no window is available.
+typedef class OffscreenFramebuffer
+{
+public:
+    // Creates and binds a framebuffer of the given dimensions. If the
+    // framebuffer is incomplete, throws a ContextException.
+    OffscreenFramebuffer(GLsizei width, GLsizei height);
+
+    ~OffscreenFramebuffer();
+
+    OffscreenFramebuffer(const OffscreenFramebuffer&) = delete;
+    OffscreenFramebuffer& operator=(const OffscreenFramebuffer&) = delete;
+
+    // Binds the framebuffer for drawing.
+    inline void bind() const noexcept
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    }
+
+private:
+    GLuint fbo; // Framebuffer Object
+    GLuint rbo; // Renderbuffer Object
+} OffscreenFramebuffer;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_HEADLESS_HH_
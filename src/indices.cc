@@ -0,0 +1,147 @@
+// Index buffers stored in the narrowest index type.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_exception.hh"
+#include "gl_state.hh"
+#include "gl_usage.hh"
+#include "indices.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+// Copies indices into a buffer as values of type T, translating k_restart
+// to the restart index of T. Returns whether any index was k_restart.
+template<typename T>
+bool pack_as(const std::vector<GLuint>& indices,
+             std::vector<unsigned char>& data)
+{
+    bool restart = false;
+    data.resize(indices.size() * sizeof(T));
+    unsigned char* out = data.data();
+    for (GLuint index : indices)
+    {
+        T value = static_cast<T>(index);
+        if (index == Indices::k_restart)
+        {
+            value = static_cast<T>(-1);
+            restart = true;
+        }
+        std::memcpy(out, &value, sizeof(T));
+        out += sizeof(T);
+    }
+    return restart;
+}
+
+// Reads indices of type T from a buffer, translating the restart index of
+// T to k_restart.
+template<typename T>
+std::vector<GLuint> unpack_as(const std::vector<unsigned char>& data)
+{
+    std::vector<GLuint> indices(data.size() / sizeof(T));
+    const unsigned char* in = data.data();
+    for (GLuint& index : indices)
+    {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        index = value == static_cast<T>(-1) ? Indices::k_restart : value;
+    }
+    return indices;
+}
+
+}; // namespace
+
+Indices::Indices(const std::vector<GLuint>& indices, size_t vertex_count)
+        : m_type{index_type(vertex_count)}, m_size(indices.size())
+{
+    /// An index past the vertices would be truncated to another vertex, or
+    /// even to the restart index, when packed
+    for (GLuint index : indices)
+    {
+        if (index != k_restart && index >= vertex_count)
+        {
+            std::string info_log = "Index " + std::to_string(index)
+                + " is out of range for " + std::to_string(vertex_count)
+                + " vertices.\n";
+            throw BufferException(info_log.substr(0, GL_INFO_LOG_LENGTH - 1)
+                                  .c_str());
+        }
+    }
+
+    switch (m_type)
+    {
+    case GL_UNSIGNED_BYTE:
+        m_restart = pack_as<GLubyte>(indices, m_data);
+        break;
+    case GL_UNSIGNED_SHORT:
+        m_restart = pack_as<GLushort>(indices, m_data);
+        break;
+    default:
+        m_restart = pack_as<GLuint>(indices, m_data);
+        break;
+    }
+}
+
+std::vector<GLuint> Indices::unpack() const
+{
+    switch (m_type)
+    {
+    case GL_UNSIGNED_BYTE:
+        return unpack_as<GLubyte>(m_data);
+    case GL_UNSIGNED_SHORT:
+        return unpack_as<GLushort>(m_data);
+    default:
+        return unpack_as<GLuint>(m_data);
+    }
+}
+
+void Indices::use(GLuint ebo, GlUsage usage) const noexcept
+{
+    GlState::current().bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_data.size(), m_data.data(),
+                 static_cast<GLenum>(usage));
+}
+
+void Indices::draw(GLenum mode, GLsizei instance_count) const noexcept
+{
+    if (m_restart)
+    {
+        GlState::current().enable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(restart_index(m_type));
+    }
+
+    if (instance_count == 1)
+        glDrawElements(mode, m_size, m_type, nullptr);
+    else
+        glDrawElementsInstanced(mode, m_size, m_type, nullptr,
+                                instance_count);
+
+    if (m_restart)
+        GlState::current().disable(GL_PRIMITIVE_RESTART);
+}
+
+}; // namespace demonia
@@ -0,0 +1,124 @@
+// Index buffers stored in the narrowest index type.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_INDICES_HH_
+#define DEMONIA_SRC_INDICES_HH_
+
+#include "gl_usage.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Returns the narrowest index type that can address a number of vertices
+// while keeping the largest value of the type free for primitive restart.
+constexpr GLenum index_type(size_t vertex_count) noexcept
+{
+    return vertex_count <= UINT8_MAX ? GL_UNSIGNED_BYTE
+           : vertex_count <= UINT16_MAX ? GL_UNSIGNED_SHORT
+           : GL_UNSIGNED_INT;
+}
+
+// Returns the size in bytes of an index type.
+constexpr size_t index_type_size(GLenum type) noexcept
+{
+    return type == GL_UNSIGNED_BYTE ? sizeof(GLubyte)
+           : type == GL_UNSIGNED_SHORT ? sizeof(GLushort)
+           : sizeof(GLuint);
+}
+
+// Returns the primitive restart index of an index type, its largest value.
+constexpr GLuint restart_index(GLenum type) noexcept
+{
+    return type == GL_UNSIGNED_BYTE ? UINT8_MAX
+           : type == GL_UNSIGNED_SHORT ? UINT16_MAX
+           : UINT32_MAX;
+}
+
+// Creates a set of indices describing the order in which vertices should be
+// rendered, packed into the narrowest type for the number of vertices so
+// that each index takes 1, 2 or 4 bytes of bandwidth. Strips and fans can be
+// split with k_restart, which is translated to the restart index of the
+// type and enables primitive restart when drawn.
+typedef class Indices
+{
+public:
+    // Marks the end of a strip or fan in the unpacked indices.
+    static constexpr GLuint k_restart = UINT32_MAX;
+
+    // Creates an empty set of indices, for drawing vertices in order.
+    Indices() = default;
+
+    // Packs indices addressing a number of vertices. Throws a
+    // BufferException if an index other than k_restart is out of range.
+    Indices(const std::vector<GLuint>& indices, size_t vertex_count);
+
+    // Copies the packed indices into an Element Buffer Object, which is
+    // bound to the currently bound Vertex Array Object.
+    void use(GLuint ebo, GlUsage usage = GlUsage::STATIC_DRAW) const noexcept;
+
+    // Returns the indices unpacked to GLuint, with restart indices as
+    // k_restart.
+    std::vector<GLuint> unpack() const;
+
+    // Draws the indexed vertices as primitives of a mode for each of a
+    // number of instances, from the Element Buffer Object of the bound
+    // Vertex Array Object.
+    void draw(GLenum mode, GLsizei instance_count = 1) const noexcept;
+
+    inline GLenum get_type() const noexcept
+    {
+        return m_type;
+    }
+
+    // Returns the number of indices.
+    inline GLsizei size() const noexcept
+    {
+        return m_size;
+    }
+
+    inline bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    // Returns the size in bytes of the packed indices.
+    inline size_t bytes() const noexcept
+    {
+        return m_data.size();
+    }
+
+    // Returns whether any index restarts a primitive.
+    inline bool has_restart() const noexcept
+    {
+        return m_restart;
+    }
+
+private:
+    std::vector<unsigned char> m_data;
+    GLenum m_type = GL_UNSIGNED_INT;
+    GLsizei m_size = 0;
+    bool m_restart = false;
+} Indices;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_INDICES_HH_
@@ -0,0 +1,120 @@
+// Scene of many instances of a triangle.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_state.hh"
+#include "instanced_scene.hh"
+#include "program_builder.hh"
+#include "shader.hh"
+#include "vertices.hh"
+
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+const char* vertex_shader_src =
+#include "shaders/instanced.vert"
+;
+
+const char* fragment_shader_src =
+#include "shaders/color.frag"
+;
+
+const char* vertex_shader_file = "instanced.vert";
+const char* fragment_shader_file = "color.frag";
+
+}; // namespace
+
+InstancedScene::InstancedScene(bool instanced)
+        : m_instanced{instanced}
+{
+}
+
+InstancedScene::~InstancedScene()
+{
+    GlState::current().delete_vertex_arrays(1, &vao);
+    GlState::current().delete_buffers(1, &instance_vbo);
+    GlState::current().delete_buffers(1, &vbo);
+}
+
+void InstancedScene::load(ProgramBuilder& programs)
+{
+    programs.add(vertex_shader_src, fragment_shader_src, program,
+                 vertex_shader_file, fragment_shader_file);
+
+    const float step = 2.0f / k_grid_size;
+    std::vector<Copies::Instance> data;
+    data.reserve(k_instance_count);
+    for (unsigned int row = 0; row < k_grid_size; ++row)
+    {
+        for (unsigned int column = 0; column < k_grid_size; ++column)
+        {
+            float u = (column + 0.5f) / k_grid_size;
+            float v = (row + 0.5f) / k_grid_size;
+            data.emplace_back(Offset({-1.0f + (column + 0.5f) * step,
+                                      -1.0f + (row + 0.5f) * step, 0.0f}),
+                              Tint({u, v, 1.0f - u}));
+        }
+    }
+    copies.reset(new Copies(std::move(data)));
+
+    glGenBuffers(1, &vbo);
+    glGenVertexArrays(1, &vao);
+    vertices_color_2d_triangle.use(vao, vbo);
+    if (m_instanced)
+    {
+        glGenBuffers(1, &instance_vbo);
+        copies->use(vao, instance_vbo, 2);
+    }
+}
+
+void InstancedScene::prepare()
+{
+    program->use();
+    program->set_uniform("uScale", 2.0f / k_grid_size);
+}
+
+void InstancedScene::draw(double time)
+{
+    program->use();
+    GlState::current().bind_vertex_array(vao);
+    if (m_instanced)
+    {
+        vertices_color_2d_triangle.draw(GL_TRIANGLES, copies->size());
+        return;
+    }
+
+    for (const Copies::Instance& copy : copies->get_data())
+    {
+        glVertexAttrib3fv(2, &get<0>(copy).m_data.x);
+        glVertexAttrib3fv(3, &get<1>(copy).m_data.r);
+        vertices_color_2d_triangle.draw(GL_TRIANGLES);
+    }
+}
+
+void InstancedScene::report(std::ostream& os) const
+{
+    os << "Instances: " << copies->size() << ", draw calls per frame: "
+       << (m_instanced ? 1 : copies->size()) << std::endl;
+}
+
+}; // namespace demonia
@@ -0,0 +1,71 @@
+// Scene of many instances of a triangle.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_INSTANCED_SCENE_HH_
+#define DEMONIA_SRC_INSTANCED_SCENE_HH_
+
+#include "program_builder.hh"
+#include "scene.hh"
+#include "shader.hh"
+#include "vertices.hh"
+
+#include <memory>
+#include <ostream>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Draws a grid of k_instance_count tinted copies of
+// vertices_color_2d_triangle covering the viewport. When instanced, every
+// copy is drawn by a single call with the offsets and tints read from a
+// per-instance buffer; otherwise each copy is drawn by its own call with the
+// offset and tint set as constant attributes, for comparison.
+typedef class InstancedScene : public Scene
+{
+public:
+    // Number of copies along each side of the grid.
+    static const unsigned int k_grid_size = 320;
+    static const unsigned int k_instance_count = k_grid_size * k_grid_size;
+
+    explicit InstancedScene(bool instanced = true);
+
+    ~InstancedScene() override;
+
+    void load(ProgramBuilder& programs) override;
+
+    void prepare() override;
+
+    void draw(double time) override;
+
+    // Outputs the number of draw calls and instances per frame.
+    void report(std::ostream& os) const override;
+
+private:
+    typedef Instances<Offset, Tint> Copies;
+
+    bool m_instanced;
+    std::unique_ptr<ShaderProgram> program;
+    std::unique_ptr<Copies> copies;
+    GLuint vbo = 0;          // Vertex Buffer Object
+    GLuint instance_vbo = 0; // Vertex Buffer Object of the instances
+    GLuint vao = 0;          // Vertex Array Object
+} InstancedScene;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_INSTANCED_SCENE_HH_
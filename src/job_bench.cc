@@ -0,0 +1,211 @@
+// Benchmark of parallel frame preparation across thread counts.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "job_system.hh"
+#include "render_queue.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+// Objects prepared per frame, in groups sharing a transform.
+const size_t k_group_count = 1024;
+const size_t k_group_size = 1024;
+const size_t k_grain = 4096;
+const unsigned int k_runs = 20;
+
+typedef struct Sphere
+{
+    float center[3];
+    float radius;
+} Sphere;
+
+typedef struct Plane
+{
+    float normal[3];
+    float distance;
+} Plane;
+
+// Transform of a group: a rotation about the y axis and a translation.
+typedef struct Transform
+{
+    float cos_angle;
+    float sin_angle;
+    float translation[3];
+} Transform;
+
+// Returns the planes of a perspective frustum in view space, pointing
+// inwards, looking down -z.
+std::vector<Plane> frustum_planes(float fov_y, float aspect, float near,
+                                  float far)
+{
+    float y = std::tan(fov_y / 2);
+    float x = y * aspect;
+    std::vector<Plane> planes = {
+        {{1, 0, -x}, 0}, {{-1, 0, -x}, 0},
+        {{0, 1, -y}, 0}, {{0, -1, -y}, 0},
+        {{0, 0, -1}, -near}, {{0, 0, 1}, far}
+    };
+    for (Plane& plane : planes)
+    {
+        float length = std::sqrt(plane.normal[0] * plane.normal[0]
+                                 + plane.normal[1] * plane.normal[1]
+                                 + plane.normal[2] * plane.normal[2]);
+        for (float& component : plane.normal)
+            component /= length;
+        plane.distance /= length;
+    }
+    return planes;
+}
+
+}; // namespace
+
+int main(int argc, char** argv)
+{
+    unsigned int max_threads = argc > 1
+        ? std::stoul(argv[1])
+        : std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::mt19937 random(0);
+    std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> radius(0.1f, 2.0f);
+    std::vector<Sphere> spheres(k_group_count * k_group_size);
+    for (Sphere& sphere : spheres)
+    {
+        sphere = {{position(random) / 4, position(random) / 4,
+                   position(random) / 4}, radius(random)};
+    }
+    std::vector<Transform> transforms(k_group_count);
+    for (size_t i = 0; i < k_group_count; ++i)
+    {
+        float angle = i * 0.1f;
+        transforms[i] = {std::cos(angle), std::sin(angle),
+                         {position(random), position(random),
+                          position(random) - 150.0f}};
+    }
+    const std::vector<Plane> planes = frustum_planes(1.0f, 16.0f / 9.0f,
+                                                     0.1f, 300.0f);
+
+    std::cout << "Culling and recording " << spheres.size()
+              << " objects, best of " << k_runs << " frames\n\n"
+              << std::setw(8) << "Threads" << std::setw(12) << "ms/frame"
+              << std::setw(14) << "Mobject/s" << std::setw(10) << "Speedup"
+              << std::endl;
+
+    bool mismatch = false;
+    size_t reference_count = 0;
+    double single_seconds = 0.0;
+    for (unsigned int threads = 1; threads <= max_threads; ++threads)
+    {
+        demonia::JobSystem jobs(threads);
+        std::vector<demonia::CommandList> command_lists(jobs.size());
+        demonia::CommandList merged;
+
+        // Traverses the groups of a range of objects, culls their bounding
+        // spheres against the frustum and records the visible ones
+        demonia::JobSystem::RangeFunction prepare =
+            [&](size_t begin, size_t end, unsigned int worker)
+            {
+                demonia::CommandList& commands = command_lists[worker];
+                for (size_t i = begin; i < end; ++i)
+                {
+                    const Transform& transform = transforms[i / k_group_size];
+                    const Sphere& sphere = spheres[i];
+                    float center[3] = {
+                        transform.cos_angle * sphere.center[0]
+                            + transform.sin_angle * sphere.center[2]
+                            + transform.translation[0],
+                        sphere.center[1] + transform.translation[1],
+                        transform.cos_angle * sphere.center[2]
+                            - transform.sin_angle * sphere.center[0]
+                            + transform.translation[2]
+                    };
+
+                    bool visible = true;
+                    for (const Plane& plane : planes)
+                    {
+                        visible &= plane.normal[0] * center[0]
+                                   + plane.normal[1] * center[1]
+                                   + plane.normal[2] * center[2]
+                                   + plane.distance >= -sphere.radius;
+                    }
+                    if (!visible)
+                        continue;
+
+                    demonia::DrawCommand command;
+                    command.key = demonia::RenderQueue::make_key(
+                            0, 1, 1 + i / k_group_size, 0,
+                            -center[2] / 300.0f);
+                    command.program = 1;
+                    command.vao = 1 + i / k_group_size;
+                    command.material = 0;
+                    command.mode = GL_TRIANGLES;
+                    command.index_type = GL_UNSIGNED_SHORT;
+                    command.first = 0;
+                    command.count = 36;
+                    command.base_vertex = (i % k_group_size) * 24;
+                    commands.push_back(command);
+                }
+            };
+
+        double best = 1e9;
+        for (unsigned int run = 0; run < k_runs; ++run)
+        {
+            Clock::time_point start = Clock::now();
+            jobs.parallel_for(spheres.size(), k_grain, prepare);
+            merged.clear();
+            for (demonia::CommandList& commands : command_lists)
+            {
+                merged.insert(merged.end(), commands.begin(), commands.end());
+                commands.clear();
+            }
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            best = std::min(best, elapsed.count());
+        }
+
+        if (threads == 1)
+        {
+            single_seconds = best;
+            reference_count = merged.size();
+        }
+        bool differs = merged.size() != reference_count;
+        mismatch |= differs;
+
+        std::cout << std::setw(8) << threads << std::fixed
+                  << std::setprecision(2) << std::setw(12) << best * 1e3
+                  << std::setprecision(1) << std::setw(14)
+                  << spheres.size() / best / 1e6 << std::setprecision(2)
+                  << std::setw(9) << single_seconds / best << "x"
+                  << (differs ? "  MISMATCH" : "") << std::endl;
+    }
+
+    std::cout << "\nVisible objects: " << reference_count << std::endl;
+    return mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
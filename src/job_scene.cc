@@ -0,0 +1,164 @@
+// Scene of draws culled and recorded in parallel by a job system.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_state.hh"
+#include "job_scene.hh"
+#include "job_system.hh"
+#include "program_builder.hh"
+#include "render_queue.hh"
+#include "shader.hh"
+#include "vertices.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+const char* vertex_shader_src =
+#include "shaders/color.vert"
+;
+
+const char* fragment_shader_src =
+#include "shaders/color.frag"
+;
+
+const char* vertex_shader_file = "color.vert";
+const char* fragment_shader_file = "color.frag";
+
+// Objects culled and recorded by each job.
+const size_t k_grain = 1024;
+
+}; // namespace
+
+JobScene::JobScene(unsigned int thread_count)
+        : jobs(thread_count), command_lists(jobs.size())
+{
+}
+
+JobScene::~JobScene()
+{
+    GlState::current().delete_vertex_arrays(1, &vao);
+    GlState::current().delete_buffers(1, &ebo);
+    GlState::current().delete_buffers(1, &vbo);
+}
+
+void JobScene::load(ProgramBuilder& programs)
+{
+    typedef Vertices<Position, Color> Mesh;
+
+    programs.add(vertex_shader_src, fragment_shader_src, program,
+                 vertex_shader_file, fragment_shader_file);
+
+    const float step = 2.0f / k_grid_size;
+    const float corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+    std::vector<Mesh::Vertex> vertices;
+    vertices.reserve(k_grid_size * k_grid_size * 4);
+    objects.reserve(k_grid_size * k_grid_size);
+    for (unsigned int row = 0; row < k_grid_size; ++row)
+    {
+        for (unsigned int column = 0; column < k_grid_size; ++column)
+        {
+            Object object;
+            object.min[0] = -1.0f + column * step;
+            object.min[1] = -1.0f + row * step;
+            object.max[0] = object.min[0] + step;
+            object.max[1] = object.min[1] + step;
+            object.base_vertex = vertices.size();
+            objects.push_back(object);
+
+            Color color({static_cast<float>(column) / k_grid_size,
+                         static_cast<float>(row) / k_grid_size, 0.5f});
+            for (const float* corner : corners)
+            {
+                vertices.emplace_back(
+                        Position({object.min[0] + corner[0] * step,
+                                  object.min[1] + corner[1] * step, 0.0f}),
+                        color);
+            }
+        }
+    }
+
+    Mesh mesh(std::move(vertices), {0, 1, 2, 0, 2, 3});
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glGenVertexArrays(1, &vao);
+    mesh.use(vao, vbo, ebo);
+    index_type = mesh.get_indices().get_type();
+}
+
+void JobScene::draw(double time)
+{
+    /// The circle orbits the centre of the viewport
+    const float radius = 0.6f;
+    const float center[2] = {0.4f * static_cast<float>(std::cos(time)),
+                             0.4f * static_cast<float>(std::sin(time))};
+    const GLuint program_id = program->get_id();
+
+    jobs.parallel_for(objects.size(), k_grain,
+        [&](size_t begin, size_t end, unsigned int worker)
+        {
+            CommandList& commands = command_lists[worker];
+            for (size_t i = begin; i < end; ++i)
+            {
+                const Object& object = objects[i];
+
+                // Distance from the centre of the circle to the quad
+                float dx = std::max({object.min[0] - center[0], 0.0f,
+                                     center[0] - object.max[0]});
+                float dy = std::max({object.min[1] - center[1], 0.0f,
+                                     center[1] - object.max[1]});
+                float distance = std::sqrt(dx * dx + dy * dy);
+                if (distance > radius)
+                    continue;
+
+                DrawCommand command;
+                command.key = RenderQueue::make_key(0, program_id, vao, 0,
+                                                    distance / radius);
+                command.program = program_id;
+                command.vao = vao;
+                command.material = 0;
+                command.mode = GL_TRIANGLES;
+                command.index_type = index_type;
+                command.first = 0;
+                command.count = 6;
+                command.base_vertex = object.base_vertex;
+                commands.push_back(command);
+            }
+        });
+
+    for (CommandList& commands : command_lists)
+    {
+        queue.submit(commands);
+        commands.clear();
+    }
+    queue.flush();
+}
+
+void JobScene::report(std::ostream& os) const
+{
+    jobs.report(os);
+    queue.report(os);
+}
+
+}; // namespace demonia
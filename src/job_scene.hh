@@ -0,0 +1,85 @@
+// Scene of draws culled and recorded in parallel by a job system.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_JOB_SCENE_HH_
+#define DEMONIA_SRC_JOB_SCENE_HH_
+
+#include "job_system.hh"
+#include "program_builder.hh"
+#include "render_queue.hh"
+#include "scene.hh"
+#include "shader.hh"
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Draws those of a grid of k_grid_size² quads which overlap a circle moving
+// over the viewport. Each frame the quads are culled against the circle
+// and their draws recorded into a command list per worker of a job system;
+// the lists are then submitted to a render queue, which sorts them front to
+// back from the centre of the circle and merges them into one call.
+typedef class JobScene : public Scene
+{
+public:
+    // Number of quads along each side of the grid.
+    static const unsigned int k_grid_size = 256;
+
+    // Creates the scene with a job system of 'thread_count' workers, or one
+    // per core if 0.
+    explicit JobScene(unsigned int thread_count = 0);
+
+    ~JobScene() override;
+
+    void load(ProgramBuilder& programs) override;
+
+    void draw(double time) override;
+
+    bool is_animated() const override
+    {
+        return true;
+    }
+
+    // Outputs the job system and render queue statistics.
+    void report(std::ostream& os) const override;
+
+private:
+    typedef struct Object
+    {
+        GLfloat min[2];
+        GLfloat max[2];
+        GLint base_vertex;
+    } Object;
+
+    JobSystem jobs;
+    RenderQueue queue;
+    std::unique_ptr<ShaderProgram> program;
+    std::vector<Object> objects;
+    std::vector<CommandList> command_lists; // Per worker
+    GLenum index_type = GL_UNSIGNED_INT;
+    GLuint vbo = 0;
+    GLuint ebo = 0;
+    GLuint vao = 0;
+} JobScene;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_JOB_SCENE_HH_
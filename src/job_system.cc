@@ -0,0 +1,182 @@
+// Work-stealing job system for parallel frame preparation.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "job_system.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+namespace demonia
+{
+
+namespace
+{
+
+inline uint64_t pack_range(size_t begin, size_t end) noexcept
+{
+    return static_cast<uint64_t>(begin) << 32 | end;
+}
+
+}; // namespace
+
+JobSystem::JobSystem(unsigned int thread_count)
+{
+    if (thread_count == 0)
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (unsigned int i = 0; i < thread_count; ++i)
+        m_workers.emplace_back(new Worker());
+    for (unsigned int i = 1; i < thread_count; ++i)
+        m_workers[i]->thread = std::thread(&JobSystem::run, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+
+    for (std::unique_ptr<Worker>& worker : m_workers)
+    {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+}
+
+void JobSystem::parallel_for(size_t count, size_t grain,
+                             const RangeFunction& function)
+{
+    if (count == 0)
+        return;
+
+    ++m_loops;
+    grain = std::max(grain, size_t{1});
+    if (m_workers.size() == 1 || count <= grain)
+    {
+        function(0, count, 0);
+        m_workers[0]->ranges.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    m_function = &function;
+    m_grain = grain;
+    m_pending.store(count, std::memory_order_relaxed);
+    m_workers[0]->deque.push(pack_range(0, count));
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    while (m_pending.load(std::memory_order_acquire) > 0)
+    {
+        if (!work(0))
+            std::this_thread::yield();
+    }
+}
+
+void JobSystem::report(std::ostream& os) const
+{
+    uint64_t ranges = 0;
+    uint64_t steals = 0;
+    for (const std::unique_ptr<Worker>& worker : m_workers)
+    {
+        ranges += worker->ranges.load(std::memory_order_relaxed);
+        steals += worker->steals.load(std::memory_order_relaxed);
+    }
+    double loops = m_loops ? m_loops : 1;
+
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1)
+       << "Job workers: " << m_workers.size() << ", ranges per loop: "
+       << ranges / loops << " (" << steals / loops << " stolen)"
+       << std::endl;
+    os.flags(flags);
+}
+
+void JobSystem::run(unsigned int worker)
+{
+    uint64_t generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]()
+                {
+                    return m_stopping || m_generation != generation;
+                });
+            if (m_stopping)
+                return;
+            generation = m_generation;
+        }
+
+        while (m_pending.load(std::memory_order_acquire) > 0)
+        {
+            if (!work(worker))
+                std::this_thread::yield();
+        }
+    }
+}
+
+bool JobSystem::work(unsigned int worker)
+{
+    uint64_t range = m_workers[worker]->deque.pop();
+    for (unsigned int i = 1; !range && i < m_workers.size(); ++i)
+    {
+        Worker& victim = *m_workers[(worker + i) % m_workers.size()];
+        range = victim.deque.steal();
+        if (range)
+            m_workers[worker]->steals.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!range)
+        return false;
+    execute(range, worker);
+    return true;
+}
+
+void JobSystem::execute(uint64_t range, unsigned int worker)
+{
+    size_t begin = range >> 32;
+    size_t end = range & UINT32_MAX;
+
+    /// Keep the lower half and leave the upper one to be stolen, so that
+    /// thieves take the largest ranges
+    RangeDeque& deque = m_workers[worker]->deque;
+    while (end - begin > m_grain)
+    {
+        size_t middle = begin + (end - begin) / 2;
+        if (!deque.push(pack_range(middle, end)))
+            break;
+        end = middle;
+    }
+
+    (*m_function)(begin, end, worker);
+    m_workers[worker]->ranges.fetch_add(1, std::memory_order_relaxed);
+    m_pending.fetch_sub(end - begin, std::memory_order_release);
+}
+
+}; // namespace demonia
@@ -0,0 +1,118 @@
+// Work-stealing job system for parallel frame preparation.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_JOB_SYSTEM_HH_
+#define DEMONIA_SRC_JOB_SYSTEM_HH_
+
+#include "work_deque.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace demonia
+{
+
+// Runs loops in parallel on a worker thread per core. Each worker owns a
+// deque of ranges: a worker splits the range it runs in halves down to the
+// grain size, pushing the upper halves for itself, while idle workers steal
+// the largest remaining halves from the tops of the others' deques. The
+// thread which creates the system is worker 0 and runs ranges while it
+// waits.
+typedef class JobSystem
+{
+public:
+    // Function called on a range [begin, end) of a loop by the worker of the
+    // given index, which may be used to select per-worker output such as a
+    // command list.
+    typedef std::function<void(size_t begin, size_t end, unsigned int worker)>
+        RangeFunction;
+
+    // Creates a system of 'thread_count' workers including the calling
+    // thread, or one per core if 0.
+    explicit JobSystem(unsigned int thread_count = 0);
+
+    // Stops and joins the worker threads.
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Returns the number of workers, including the calling thread.
+    inline unsigned int size() const noexcept
+    {
+        return m_workers.size();
+    }
+
+    // Calls 'function' over [0, count) in ranges of at most 'grain' on all
+    // workers, returning once every range has run. Must be called from the
+    // thread which created the system, and not from within 'function'.
+    // 'count' must be less than 2^32.
+    void parallel_for(size_t count, size_t grain,
+                      const RangeFunction& function);
+
+    // Outputs the number of workers and the mean ranges run and stolen per
+    // loop.
+    void report(std::ostream& os) const;
+
+private:
+    /// Ranges are packed as begin << 32 | end so that they fit in a
+    /// lock-free deque; 0 is the empty range
+    typedef WorkDeque<uint64_t, 64> RangeDeque;
+
+    typedef struct alignas(64) Worker
+    {
+        RangeDeque deque;
+        std::thread thread;
+        std::atomic<uint64_t> ranges{0};
+        std::atomic<uint64_t> steals{0};
+    } Worker;
+
+    // Body of each worker thread other than the first.
+    void run(unsigned int worker);
+
+    // Runs a range from the worker's deque or stolen from another; returns
+    // false if none was found.
+    bool work(unsigned int worker);
+
+    // Runs a packed range, splitting off the upper halves of it first.
+    void execute(uint64_t range, unsigned int worker);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    /// Set by parallel_for() before its first range is pushed
+    const RangeFunction* m_function = nullptr;
+    size_t m_grain = 1;
+    std::atomic<size_t> m_pending{0}; // Items of the loop not yet run
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    uint64_t m_generation = 0; // Incremented for each loop
+    bool m_stopping = false;
+
+    uint64_t m_loops = 0;
+} JobSystem;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_JOB_SYSTEM_HH_
@@ -15,8 +15,25 @@
 // along with this program. If not, see <https://www.gnu.org/licenses/>.
 
 #include "gl_handler.hh"
+#include "options.hh"
 
-int main()
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+int main(int argc, char* argv[])
 {
-    return demonia::GlHandler::start();
+    demonia::Options options;
+    try
+    {
+        options = demonia::parse_options(argc, argv);
+    }
+    catch (std::invalid_argument& e)
+    {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+        demonia::print_usage(std::cerr, argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    return demonia::GlHandler::start(options);
 }
@@ -0,0 +1,272 @@
+// Memory-mapped binary mesh files.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_exception.hh"
+#include "gl_type.hh"
+#include "indices.hh"
+#include "mesh_file.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+[[noreturn]] void throw_invalid(const std::string& path,
+                                const std::string& what)
+{
+    std::string info_log = "Mesh file '" + path + "' " + what + ".\n";
+    throw MeshFileException(info_log.substr(0, GL_INFO_LOG_LENGTH - 1)
+                                .c_str());
+}
+
+inline uint64_t align(uint64_t offset) noexcept
+{
+    return (offset + MeshFile::k_alignment - 1) / MeshFile::k_alignment
+           * MeshFile::k_alignment;
+}
+
+// Returns whether a blob of a number of elements of a size at an offset
+// lies within a file.
+inline bool fits(uint64_t offset, uint64_t count, uint64_t size,
+                 uint64_t file_size) noexcept
+{
+    return size == 0 || (count <= (file_size - std::min(offset, file_size))
+                                  / size
+                         && offset <= file_size);
+}
+
+template<typename T>
+void write_indices(std::ostream& os, const std::vector<uint32_t>& indices,
+                   T restart)
+{
+    std::vector<T> packed(indices.size());
+    std::transform(indices.begin(), indices.end(), packed.begin(),
+                   [restart](uint32_t index)
+                   {
+                       return index == Indices::k_restart
+                           ? restart : static_cast<T>(index);
+                   });
+    os.write(reinterpret_cast<const char*>(packed.data()),
+             packed.size() * sizeof(T));
+}
+
+void pad(std::ostream& os, uint64_t from, uint64_t to)
+{
+    static const char zeros[MeshFile::k_alignment] = {};
+    os.write(zeros, to - from);
+}
+
+}; // namespace
+
+uint32_t mesh_attribute_size(const MeshFileAttribute& attribute) noexcept
+{
+    return gl_attribute_size(attribute.size, attribute.type);
+}
+
+const char MeshFile::k_magic[4] = {'D', 'M', 'S', 'H'};
+
+MeshFile::MeshFile(const std::string& path)
+        : m_path{path}
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw_invalid(path, std::string("cannot be opened: ")
+                            + std::strerror(errno));
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size < 0)
+    {
+        int error = errno;
+        close(fd);
+        throw_invalid(path, std::string("cannot be read: ")
+                            + std::strerror(error));
+    }
+    m_size = status.st_size;
+    if (m_size < sizeof(MeshFileHeader))
+    {
+        close(fd);
+        throw_invalid(path, "is too small for a header");
+    }
+
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int error = errno;
+    close(fd);
+    if (data == MAP_FAILED)
+        throw_invalid(path, std::string("cannot be mapped: ")
+                            + std::strerror(error));
+    m_data = static_cast<const unsigned char*>(data);
+    m_header = reinterpret_cast<const MeshFileHeader*>(m_data);
+    m_attributes = reinterpret_cast<const MeshFileAttribute*>(
+            m_data + sizeof(MeshFileHeader));
+
+    try
+    {
+        const MeshFileHeader& header = *m_header;
+        if (std::memcmp(header.magic, k_magic, sizeof(k_magic)) != 0)
+            throw_invalid(path, "is not a mesh file");
+        if (header.version != k_version)
+            throw_invalid(path, "has unsupported version "
+                                + std::to_string(header.version));
+        if (header.attribute_count == 0
+            || header.attribute_count > k_max_attributes
+            || !fits(sizeof(MeshFileHeader), header.attribute_count,
+                     sizeof(MeshFileAttribute), m_size))
+            throw_invalid(path, "has an invalid attribute count");
+
+        uint32_t stride = 0;
+        for (uint32_t i = 0; i < header.attribute_count; ++i)
+        {
+            const MeshFileAttribute& attribute = m_attributes[i];
+            uint32_t size = mesh_attribute_size(attribute);
+            if (attribute.size < 1 || attribute.size > 4 || size == 0)
+                throw_invalid(path, "has an invalid attribute "
+                                    + std::to_string(i));
+            stride += size;
+        }
+        if (header.stride != stride)
+            throw_invalid(path, "has a stride which does not match its "
+                                "attributes");
+
+        if (header.vertex_offset % k_alignment != 0
+            || !fits(header.vertex_offset, header.vertex_count, stride,
+                     m_size))
+            throw_invalid(path, "has truncated vertex data");
+
+        if (header.index_type != 0)
+        {
+            if (header.index_type != GL_UNSIGNED_BYTE
+                && header.index_type != GL_UNSIGNED_SHORT
+                && header.index_type != GL_UNSIGNED_INT)
+                throw_invalid(path, "has an invalid index type");
+            if (header.index_offset % k_alignment != 0
+                || !fits(header.index_offset, header.index_count,
+                         index_type_size(header.index_type), m_size))
+                throw_invalid(path, "has truncated index data");
+        }
+        if (header.vertex_count > std::numeric_limits<GLsizei>::max()
+            || header.index_count > std::numeric_limits<GLsizei>::max())
+            throw_invalid(path, "has too many vertices or indices");
+    }
+    catch (MeshFileException&)
+    {
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+        throw;
+    }
+
+    /// Start reading the blobs ahead of their upload
+    madvise(const_cast<unsigned char*>(m_data), m_size, MADV_WILLNEED);
+}
+
+MeshFile::~MeshFile()
+{
+    munmap(const_cast<unsigned char*>(m_data), m_size);
+}
+
+bool write_mesh_file(std::ostream& os,
+                     const std::vector<MeshFileAttribute>& attributes,
+                     uint32_t stride, const void* vertices,
+                     uint64_t vertex_count,
+                     const std::vector<uint32_t>& indices)
+{
+    MeshFileHeader header{};
+    std::memcpy(header.magic, MeshFile::k_magic, sizeof(header.magic));
+    header.version = MeshFile::k_version;
+    header.attribute_count = attributes.size();
+    header.stride = stride;
+    header.vertex_count = vertex_count;
+    header.vertex_offset = align(sizeof(MeshFileHeader)
+                                 + attributes.size()
+                                   * sizeof(MeshFileAttribute));
+
+    uint64_t vertex_end = header.vertex_offset + vertex_count * stride;
+    if (!indices.empty())
+    {
+        header.index_type = index_type(vertex_count);
+        header.restart = std::find(indices.begin(), indices.end(),
+                                   Indices::k_restart) != indices.end();
+        header.index_count = indices.size();
+        header.index_offset = align(vertex_end);
+    }
+
+    /// Bounds are only known for positions of 3 floats
+    if (!attributes.empty() && attributes.front().type == GL_FLOAT
+        && attributes.front().size == 3)
+    {
+        std::fill_n(header.bounds_min, 3,
+                    std::numeric_limits<float>::max());
+        std::fill_n(header.bounds_max, 3,
+                    std::numeric_limits<float>::lowest());
+        const unsigned char* bytes =
+            static_cast<const unsigned char*>(vertices);
+        for (uint64_t i = 0; i < vertex_count; ++i)
+        {
+            float position[3];
+            std::memcpy(position, bytes + i * stride, sizeof(position));
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                header.bounds_min[axis] = std::min(header.bounds_min[axis],
+                                                   position[axis]);
+                header.bounds_max[axis] = std::max(header.bounds_max[axis],
+                                                   position[axis]);
+            }
+        }
+    }
+
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char*>(attributes.data()),
+             attributes.size() * sizeof(MeshFileAttribute));
+    pad(os, sizeof(header) + attributes.size() * sizeof(MeshFileAttribute),
+        header.vertex_offset);
+    os.write(static_cast<const char*>(vertices), vertex_count * stride);
+
+    if (!indices.empty())
+    {
+        pad(os, vertex_end, header.index_offset);
+        switch (header.index_type)
+        {
+        case GL_UNSIGNED_BYTE:
+            write_indices<GLubyte>(os, indices, UINT8_MAX);
+            break;
+        case GL_UNSIGNED_SHORT:
+            write_indices<GLushort>(os, indices, UINT16_MAX);
+            break;
+        default:
+            write_indices<GLuint>(os, indices, UINT32_MAX);
+            break;
+        }
+    }
+
+    return static_cast<bool>(os);
+}
+
+}; // namespace demonia
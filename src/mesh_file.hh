@@ -0,0 +1,254 @@
+// Memory-mapped binary mesh files.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_MESH_FILE_HH_
+#define DEMONIA_SRC_MESH_FILE_HH_
+
+#include "gl_exception.hh"
+#include "gl_state.hh"
+#include "gl_usage.hh"
+#include "indices.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Vertex attribute described by a mesh file, as VertexAttribute::Metadata.
+typedef struct MeshFileAttribute
+{
+    int32_t size;
+    uint32_t type;
+    uint32_t normalized;
+} MeshFileAttribute;
+
+// Returns the size in bytes of an attribute of a mesh file, as
+// attribute_size() does for VertexAttribute::Metadata, or 0 if its type is
+// unknown.
+uint32_t mesh_attribute_size(const MeshFileAttribute& attribute) noexcept;
+
+// Header at the start of a mesh file. It is followed by attribute_count
+// attribute records, then by the interleaved vertex data and the packed
+// index data at offsets aligned to MeshFile::k_alignment. Values are stored
+// in the byte order of the host, which is little-endian on every supported
+// platform.
+typedef struct MeshFileHeader
+{
+    char magic[4];         // MeshFile::k_magic
+    uint32_t version;      // MeshFile::k_version
+    uint32_t attribute_count;
+    uint32_t stride;       // Bytes per vertex
+    uint64_t vertex_count;
+    uint64_t vertex_offset;
+    uint32_t index_type;   // GL_UNSIGNED_BYTE, _SHORT or _INT; 0 if none
+    uint32_t restart;      // 1 if the indices contain the restart index
+    uint64_t index_count;
+    uint64_t index_offset;
+    float bounds_min[3];   // Bounds of a first attribute of 3 floats
+    float bounds_max[3];
+} MeshFileHeader;
+
+// Draws a mesh described by the header of a mesh file as primitives of a mode
+// for each of a number of instances, from the vertex and element buffers of
+// the bound Vertex Array Object.
+inline void draw_mesh(const MeshFileHeader& header, GLenum mode,
+                      GLsizei instance_count = 1) noexcept
+{
+    GLenum type = header.index_type;
+    if (type == 0)
+    {
+        glDrawArraysInstanced(mode, 0, header.vertex_count, instance_count);
+        return;
+    }
+
+    if (header.restart)
+    {
+        GlState::current().enable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(restart_index(type));
+    }
+    glDrawElementsInstanced(mode, header.index_count, type, nullptr,
+                            instance_count);
+    if (header.restart)
+        GlState::current().disable(GL_PRIMITIVE_RESTART);
+}
+
+// Binary mesh file mapped into memory, from which vertex and index data are
+// passed straight to the GL without being copied or parsed, so that loading
+// costs little more than the page faults of reading it.
+typedef class MeshFile
+{
+public:
+    static const char k_magic[4];
+    static const uint32_t k_version = 1;
+    static const uint32_t k_max_attributes = 16;
+    static const size_t k_alignment = 64;
+
+    // Maps a mesh file read-only and validates its header. Throws a
+    // MeshFileException if the file cannot be mapped or is malformed.
+    explicit MeshFile(const std::string& path);
+
+    // Unmaps the file.
+    ~MeshFile();
+
+    MeshFile(const MeshFile&) = delete;
+    MeshFile& operator=(const MeshFile&) = delete;
+
+    // Returns whether the attributes of the file are those of a set of
+    // interleaved vertices, such as Vertices<Position, Color>.
+    template<typename V>
+    bool matches() const noexcept
+    {
+        typedef typename V::Layout Layout;
+
+        if (m_header->attribute_count != Layout::count
+            || m_header->stride != static_cast<uint32_t>(Layout::stride))
+            return false;
+
+        for (size_t i = 0; i < Layout::count; ++i)
+        {
+            const MeshFileAttribute& attribute = m_attributes[i];
+            if (attribute.size != Layout::metadata[i].size
+                || attribute.type != Layout::metadata[i].type
+                || attribute.normalized != Layout::metadata[i].normalized)
+                return false;
+        }
+        return true;
+    }
+
+    // Passes the mapped vertex and index data to the GL as the data stores
+    // of a Vertex Buffer Object and Element Buffer Object, and links and
+    // enables the attributes of a set of interleaved vertices in a Vertex
+    // Array Object. The EBO is only used if the mesh is indexed. Throws a
+    // MeshFileException if the attributes of the file do not match.
+    template<typename V>
+    void use(GLuint vao, GLuint vbo, GLuint ebo,
+             GlUsage usage = GlUsage::STATIC_DRAW) const
+    {
+        if (!matches<V>())
+        {
+            std::string info_log = "Vertex layout of mesh file '" + m_path
+                + "' does not match.\n";
+            throw MeshFileException(info_log.substr(0, GL_INFO_LOG_LENGTH - 1)
+                                        .c_str());
+        }
+
+        GlState& state = GlState::current();
+        state.bind_vertex_array(vao);
+        state.bind_buffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertex_bytes(), vertex_data(),
+                     static_cast<GLenum>(usage));
+        V::link();
+        if (is_indexed())
+        {
+            state.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_bytes(),
+                         index_data(), static_cast<GLenum>(usage));
+        }
+        state.bind_vertex_array(0);
+    }
+
+    // Draws the mesh as primitives of a mode for each of a number of
+    // instances. The Vertex Array Object linked by use() must be bound.
+    void draw(GLenum mode, GLsizei instance_count = 1) const noexcept
+    {
+        draw_mesh(*m_header, mode, instance_count);
+    }
+
+    inline const MeshFileHeader& get_header() const noexcept
+    {
+        return *m_header;
+    }
+
+    inline const MeshFileAttribute* get_attributes() const noexcept
+    {
+        return m_attributes;
+    }
+
+    inline bool is_indexed() const noexcept
+    {
+        return m_header->index_type != 0;
+    }
+
+    inline const void* vertex_data() const noexcept
+    {
+        return m_data + m_header->vertex_offset;
+    }
+
+    inline size_t vertex_bytes() const noexcept
+    {
+        return m_header->vertex_count * m_header->stride;
+    }
+
+    inline const void* index_data() const noexcept
+    {
+        return m_data + m_header->index_offset;
+    }
+
+    inline size_t index_bytes() const noexcept
+    {
+        return m_header->index_count * index_type_size(m_header->index_type);
+    }
+
+    // Returns the size of the mapped file in bytes.
+    inline size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+private:
+    std::string m_path;
+    const unsigned char* m_data = nullptr;
+    size_t m_size = 0;
+    const MeshFileHeader* m_header = nullptr;
+    const MeshFileAttribute* m_attributes = nullptr;
+} MeshFile;
+
+// Writes a mesh file of interleaved vertices with the given attributes and
+// stride, and of indices, which are packed into the narrowest type for the
+// number of vertices and may contain Indices::k_restart. Returns false if
+// writing failed.
+bool write_mesh_file(std::ostream& os,
+                     const std::vector<MeshFileAttribute>& attributes,
+                     uint32_t stride, const void* vertices,
+                     uint64_t vertex_count,
+                     const std::vector<uint32_t>& indices = {});
+
+// Writes a set of interleaved vertices and their indices as a mesh file.
+template<typename V>
+bool write_mesh_file(std::ostream& os, V& vertices)
+{
+    typedef typename V::Layout Layout;
+
+    std::vector<MeshFileAttribute> attributes;
+    for (const auto& metadata : Layout::metadata)
+    {
+        attributes.push_back({metadata.size, metadata.type,
+                              metadata.normalized});
+    }
+    return write_mesh_file(os, attributes, Layout::stride,
+                           vertices.get_data().data(), vertices.size(),
+                           vertices.get_indices().unpack());
+}
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_MESH_FILE_HH_
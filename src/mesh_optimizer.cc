@@ -0,0 +1,333 @@
+// Mesh optimisation for the post-transform vertex cache and vertex fetch.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_exception.hh"
+#include "hash.hh"
+#include "mesh_optimizer.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace demonia
+{
+
+namespace
+{
+
+// Size of the LRU cache modelled by the vertex cache optimisation. Larger
+// than any real FIFO cache, so that the order suits every cache size.
+const unsigned int k_forsyth_cache_size = 32;
+const float k_forsyth_cache_decay_power = 1.5f;
+const float k_forsyth_last_triangle_score = 0.75f;
+const float k_forsyth_valence_boost_scale = 2.0f;
+const float k_forsyth_valence_boost_power = 0.5f;
+const unsigned int k_forsyth_max_valence = 32;
+
+// Score of a vertex from its position in the cache and the number of
+// triangles yet to be drawn which use it. Vertices of the last triangle are
+// scored lower to avoid drawing strips back and forth, and vertices with few
+// triangles left are boosted to finish them off.
+float forsyth_score(int cache_position, uint32_t remaining)
+{
+    if (remaining == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cache_position >= 0)
+    {
+        if (cache_position < 3)
+            score = k_forsyth_last_triangle_score;
+        else
+            score = std::pow(1.0f - (cache_position - 3)
+                                 / static_cast<float>(
+                                     k_forsyth_cache_size - 3),
+                             k_forsyth_cache_decay_power);
+    }
+    return score + k_forsyth_valence_boost_scale
+                   * std::pow(static_cast<float>(remaining),
+                              -k_forsyth_valence_boost_power);
+}
+
+// Table of vertex scores for every cache position and low valence.
+typedef class ForsythScores
+{
+public:
+    ForsythScores()
+    {
+        for (unsigned int valence = 0; valence <= k_forsyth_max_valence;
+             ++valence)
+        {
+            for (int position = -1;
+                 position < static_cast<int>(k_forsyth_cache_size); ++position)
+                m_scores[valence][position + 1] =
+                    forsyth_score(position, valence);
+        }
+    }
+
+    inline float operator()(int cache_position, uint32_t remaining) const
+    {
+        if (remaining > k_forsyth_max_valence)
+            return forsyth_score(cache_position, remaining);
+        return m_scores[remaining][cache_position + 1];
+    }
+
+private:
+    std::array<std::array<float, k_forsyth_cache_size + 1>,
+               k_forsyth_max_valence + 1> m_scores;
+} ForsythScores;
+
+}; // namespace
+
+void MeshStats::report(std::ostream& os) const
+{
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3)
+       << vertex_count << " vertices, " << triangle_count << " triangles, "
+       << "ACMR " << acmr << ", ATVR " << atvr << ", overfetch "
+       << overfetch << std::endl;
+    os.flags(flags);
+}
+
+void MeshOptimization::report(std::ostream& os) const
+{
+    os << "Before: ";
+    before.report(os);
+    os << "After:  ";
+    after.report(os);
+}
+
+void check_triangle_list(const std::vector<uint32_t>& indices,
+                         size_t vertex_count)
+{
+    /// Every pass indexes per-vertex and per-triangle tables without bounds
+    /// checks, so anything else would read and write past them
+    std::string info_log;
+    if (indices.size() % 3 != 0)
+    {
+        info_log = std::to_string(indices.size())
+            + " indices are not a whole number of triangles.\n";
+    }
+    else
+    {
+        for (uint32_t index : indices)
+        {
+            if (index >= vertex_count)
+            {
+                info_log = "Index " + std::to_string(index)
+                    + " is out of range for " + std::to_string(vertex_count)
+                    + " vertices.\n";
+                break;
+            }
+        }
+    }
+    if (!info_log.empty())
+        throw BufferException(info_log.substr(0, GL_INFO_LOG_LENGTH - 1)
+                              .c_str());
+}
+
+MeshStats analyze_mesh(const std::vector<uint32_t>& indices,
+                       size_t vertex_count, size_t vertex_size)
+{
+    MeshStats stats{};
+    stats.vertex_count = vertex_count;
+    stats.triangle_count = indices.size() / 3;
+    if (indices.empty() || vertex_count == 0)
+        return stats;
+
+    // A vertex or line is in a FIFO cache if fewer than its size of misses
+    // have occurred since it was last missed
+    std::vector<uint64_t> vertex_time(vertex_count, 0);
+    uint64_t vertex_misses = 0;
+
+    size_t line_count = (vertex_count * vertex_size
+                         + MeshStats::k_cache_line_size - 1)
+                        / MeshStats::k_cache_line_size;
+    std::vector<uint64_t> line_time(line_count, 0);
+    uint64_t line_misses = 0;
+
+    for (uint32_t index : indices)
+    {
+        if (vertex_time[index] != 0
+            && vertex_misses - vertex_time[index] < MeshStats::k_cache_size)
+            continue;
+        vertex_time[index] = ++vertex_misses;
+
+        size_t first = index * vertex_size / MeshStats::k_cache_line_size;
+        size_t last = ((index + 1) * vertex_size - 1)
+                      / MeshStats::k_cache_line_size;
+        for (size_t line = first; line <= last; ++line)
+        {
+            if (line_time[line] != 0
+                && line_misses - line_time[line]
+                   < MeshStats::k_fetch_cache_lines)
+                continue;
+            line_time[line] = ++line_misses;
+        }
+    }
+
+    stats.acmr = static_cast<double>(vertex_misses) / stats.triangle_count;
+    stats.atvr = static_cast<double>(vertex_misses) / vertex_count;
+    stats.overfetch = static_cast<double>(line_misses)
+                      * MeshStats::k_cache_line_size
+                      / (vertex_count * vertex_size);
+    return stats;
+}
+
+void optimize_vertex_cache(std::vector<uint32_t>& indices,
+                           size_t vertex_count)
+{
+    static const ForsythScores scores;
+    size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0)
+        return;
+
+    // Triangles using each vertex, the first 'remaining' of which are yet to
+    // be drawn
+    std::vector<uint32_t> remaining(vertex_count, 0);
+    for (uint32_t index : indices)
+        ++remaining[index];
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    for (size_t v = 0; v < vertex_count; ++v)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> filled(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+        adjacency[filled[indices[i]]++] = i / 3;
+
+    std::vector<int> cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count);
+    for (size_t v = 0; v < vertex_count; ++v)
+        vertex_score[v] = scores(-1, remaining[v]);
+
+    std::vector<bool> drawn(triangle_count, false);
+    size_t best = 0;
+    float best_score = -1.0f;
+    for (size_t t = 0; t < triangle_count; ++t)
+    {
+        float score = vertex_score[indices[t * 3]]
+                      + vertex_score[indices[t * 3 + 1]]
+                      + vertex_score[indices[t * 3 + 2]];
+        if (score > best_score)
+        {
+            best_score = score;
+            best = t;
+        }
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> next_cache;
+    cache.reserve(k_forsyth_cache_size + 3);
+    next_cache.reserve(k_forsyth_cache_size + 3);
+    size_t next_undrawn = 0;
+
+    for (size_t drawn_count = 0; drawn_count < triangle_count; ++drawn_count)
+    {
+        if (best == SIZE_MAX)
+        {
+            // No triangle shares a vertex in the cache; take the next one
+            while (drawn[next_undrawn])
+                ++next_undrawn;
+            best = next_undrawn;
+        }
+
+        const uint32_t* triangle = &indices[best * 3];
+        drawn[best] = true;
+        result.insert(result.end(), triangle, triangle + 3);
+
+        // Remove the triangle from the lists of its vertices
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            uint32_t v = triangle[corner];
+            uint32_t* begin = &adjacency[offsets[v]];
+            uint32_t* end = begin + remaining[v];
+            std::iter_swap(std::find(begin, end, best), end - 1);
+            --remaining[v];
+        }
+
+        // Move the vertices of the triangle to the front of the cache
+        next_cache.assign(triangle, triangle + 3);
+        for (uint32_t v : cache)
+        {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                next_cache.push_back(v);
+        }
+        for (size_t i = k_forsyth_cache_size; i < next_cache.size(); ++i)
+        {
+            cache_position[next_cache[i]] = -1;
+            vertex_score[next_cache[i]] = scores(-1, remaining[next_cache[i]]);
+        }
+        if (next_cache.size() > k_forsyth_cache_size)
+            next_cache.resize(k_forsyth_cache_size);
+        for (size_t i = 0; i < next_cache.size(); ++i)
+        {
+            cache_position[next_cache[i]] = i;
+            vertex_score[next_cache[i]] = scores(i, remaining[next_cache[i]]);
+        }
+        cache.swap(next_cache);
+
+        // Rescore the undrawn triangles of the cached vertices and pick the
+        // best of them
+        best = SIZE_MAX;
+        best_score = -1.0f;
+        for (uint32_t v : cache)
+        {
+            for (uint32_t i = 0; i < remaining[v]; ++i)
+            {
+                uint32_t t = adjacency[offsets[v] + i];
+                float score = vertex_score[indices[t * 3]]
+                              + vertex_score[indices[t * 3 + 1]]
+                              + vertex_score[indices[t * 3 + 2]];
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best = t;
+                }
+            }
+        }
+    }
+
+    indices = std::move(result);
+}
+
+size_t fetch_remap(const std::vector<uint32_t>& indices, size_t vertex_count,
+                   std::vector<uint32_t>& remap)
+{
+    remap.assign(vertex_count, UINT32_MAX);
+    uint32_t next = 0;
+    for (uint32_t index : indices)
+    {
+        if (remap[index] == UINT32_MAX)
+            remap[index] = next++;
+    }
+    return next;
+}
+
+uint64_t hash_bytes(const void* data, size_t size) noexcept
+{
+    return fnv1a<uint64_t>(static_cast<const char*>(data), size);
+}
+
+}; // namespace demonia
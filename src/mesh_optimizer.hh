@@ -0,0 +1,188 @@
+// Mesh optimisation for the post-transform vertex cache and vertex fetch.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_MESH_OPTIMIZER_HH_
+#define DEMONIA_SRC_MESH_OPTIMIZER_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <ostream>
+#include <vector>
+
+namespace demonia
+{
+
+// Statistics of drawing an indexed triangle list, from simulations of a
+// FIFO post-transform vertex cache and of the cache lines read by vertex
+// fetch.
+typedef struct MeshStats
+{
+    static const unsigned int k_cache_size = 16;      // Vertices
+    static const unsigned int k_cache_line_size = 64; // Bytes
+    static const unsigned int k_fetch_cache_lines = 64;
+
+    size_t vertex_count;
+    size_t triangle_count;
+
+    // Average cache miss ratio: vertices transformed per triangle, from 3 at
+    // worst to about 0.5 for a regular grid.
+    double acmr;
+
+    // Average transformed vertex ratio: vertices transformed per vertex,
+    // from 1 at best.
+    double atvr;
+
+    // Bytes read by vertex fetch per byte of vertex data, from 1 at best.
+    double overfetch;
+
+    // Outputs the statistics.
+    void report(std::ostream& os) const;
+} MeshStats;
+
+// Statistics of a mesh before and after optimisation.
+typedef struct MeshOptimization
+{
+    MeshStats before;
+    MeshStats after;
+
+    // Outputs both sets of statistics.
+    void report(std::ostream& os) const;
+} MeshOptimization;
+
+// Throws BufferException unless the indices are a triangle list of vertices
+// of a count: a whole number of triangles whose indices are all below the
+// count, so that neither strips nor restart indices are accepted.
+void check_triangle_list(const std::vector<uint32_t>& indices,
+                         size_t vertex_count);
+
+// Simulates drawing an indexed triangle list of vertices of a size in bytes.
+MeshStats analyze_mesh(const std::vector<uint32_t>& indices,
+                       size_t vertex_count, size_t vertex_size);
+
+// Reorders the triangles of an indexed triangle list to reuse vertices in
+// the post-transform vertex cache, using Forsyth's linear-speed greedy
+// algorithm with a 32-entry LRU cache model.
+void optimize_vertex_cache(std::vector<uint32_t>& indices,
+                           size_t vertex_count);
+
+// Builds a table mapping each vertex to its position in the order in which
+// it is first referenced by the indices, or to UINT32_MAX if unreferenced.
+// Returns the number of referenced vertices.
+size_t fetch_remap(const std::vector<uint32_t>& indices, size_t vertex_count,
+                   std::vector<uint32_t>& remap);
+
+// Returns a 64-bit FNV-1a hash of a sequence of bytes.
+uint64_t hash_bytes(const void* data, size_t size) noexcept;
+
+// Merges vertices whose records are identical byte for byte, rewriting the
+// indices to refer to the first of each. If there are no indices, the
+// vertices are taken to be a triangle list in order and indices are
+// created. Vertices must have no padding, as is checked for Vertices.
+template<typename Vertex>
+void deduplicate_vertices(std::vector<Vertex>& vertices,
+                          std::vector<uint32_t>& indices)
+{
+    if (indices.empty())
+    {
+        indices.resize(vertices.size());
+        std::iota(indices.begin(), indices.end(), 0);
+    }
+
+    // Open addressing table of indices into unique vertices
+    size_t capacity = 1;
+    while (capacity < vertices.size() * 2)
+        capacity *= 2;
+    const uint32_t empty = UINT32_MAX;
+    std::vector<uint32_t> table(capacity, empty);
+
+    std::vector<Vertex> unique;
+    unique.reserve(vertices.size());
+    std::vector<uint32_t> remap(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        size_t slot = hash_bytes(&vertices[i], sizeof(Vertex)) & (capacity - 1);
+        while (table[slot] != empty
+               && std::memcmp(&unique[table[slot]], &vertices[i],
+                              sizeof(Vertex)) != 0)
+            slot = (slot + 1) & (capacity - 1);
+
+        if (table[slot] == empty)
+        {
+            table[slot] = unique.size();
+            unique.push_back(vertices[i]);
+        }
+        remap[i] = table[slot];
+    }
+
+    for (uint32_t& index : indices)
+        index = remap[index];
+    vertices = std::move(unique);
+}
+
+// Reorders vertices in the order in which they are first referenced by the
+// indices, so that vertex fetch reads memory mostly sequentially, rewriting
+// the indices to match. Unreferenced vertices are removed.
+template<typename Vertex>
+void optimize_vertex_fetch(std::vector<Vertex>& vertices,
+                           std::vector<uint32_t>& indices)
+{
+    std::vector<uint32_t> remap;
+    size_t count = fetch_remap(indices, vertices.size(), remap);
+
+    std::vector<Vertex> ordered(count, vertices.front());
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        if (remap[i] != UINT32_MAX)
+            ordered[remap[i]] = vertices[i];
+    }
+
+    for (uint32_t& index : indices)
+        index = remap[index];
+    vertices = std::move(ordered);
+}
+
+// Deduplicates the vertices of a triangle list, then optimises it for the
+// vertex cache and vertex fetch, in that order. Returns statistics from
+// before and after. Throws BufferException if it is not a triangle list.
+template<typename Vertex>
+MeshOptimization optimize_mesh(std::vector<Vertex>& vertices,
+                               std::vector<uint32_t>& indices)
+{
+    MeshOptimization result;
+    if (indices.empty())
+    {
+        indices.resize(vertices.size());
+        std::iota(indices.begin(), indices.end(), 0);
+    }
+    check_triangle_list(indices, vertices.size());
+    result.before = analyze_mesh(indices, vertices.size(), sizeof(Vertex));
+
+    if (!vertices.empty())
+    {
+        deduplicate_vertices(vertices, indices);
+        optimize_vertex_cache(indices, vertices.size());
+        optimize_vertex_fetch(vertices, indices);
+    }
+
+    result.after = analyze_mesh(indices, vertices.size(), sizeof(Vertex));
+    return result;
+}
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_MESH_OPTIMIZER_HH_
@@ -0,0 +1,114 @@
+// Scene drawing a memory-mapped mesh file.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_state.hh"
+#include "mesh_file.hh"
+#include "mesh_scene.hh"
+#include "program_builder.hh"
+#include "shader.hh"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <ostream>
+#include <string>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+const char* vertex_shader_src =
+#include "shaders/mesh.vert"
+;
+
+const char* fragment_shader_src =
+#include "shaders/color.frag"
+;
+
+const char* vertex_shader_file = "mesh.vert";
+const char* fragment_shader_file = "color.frag";
+
+}; // namespace
+
+MeshScene::MeshScene(const std::string& path)
+        : m_path{path}
+{
+}
+
+MeshScene::~MeshScene()
+{
+    GlState::current().delete_vertex_arrays(1, &vao);
+    GlState::current().delete_buffers(1, &ebo);
+    GlState::current().delete_buffers(1, &vbo);
+}
+
+void MeshScene::load(ProgramBuilder& programs)
+{
+    programs.add(vertex_shader_src, fragment_shader_src, program,
+                 vertex_shader_file, fragment_shader_file);
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    mesh.reset(new MeshFile(m_path));
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glGenVertexArrays(1, &vao);
+    mesh->use<MeshVertices>(vao, vbo, ebo);
+    m_load_time = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+}
+
+void MeshScene::prepare()
+{
+    /// Fit the bounds of the mesh into the viewport
+    const MeshFileHeader& header = mesh->get_header();
+    std::array<GLfloat, 3> center;
+    GLfloat extent = 0.0f;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        center[axis] = (header.bounds_min[axis] + header.bounds_max[axis])
+                       / 2.0f;
+        extent = std::max(extent, header.bounds_max[axis]
+                                  - header.bounds_min[axis]);
+    }
+
+    program->use();
+    program->set_uniform("uCenter", center);
+    program->set_uniform("uScale", extent > 0.0f ? 1.5f / extent : 1.0f);
+}
+
+void MeshScene::draw(double time)
+{
+    program->use();
+    program->set_uniform("uAngle", static_cast<GLfloat>(time * 0.5));
+    GlState::current().bind_vertex_array(vao);
+    mesh->draw(GL_TRIANGLES);
+}
+
+void MeshScene::report(std::ostream& os) const
+{
+    const MeshFileHeader& header = mesh->get_header();
+    os << "Mesh: " << header.vertex_count << " vertices, "
+       << header.index_count << " indices, "
+       << mesh->size() / (1024.0 * 1024.0) << " MiB mapped, loaded in "
+       << m_load_time * 1000.0 << " ms" << std::endl;
+}
+
+}; // namespace demonia
@@ -0,0 +1,74 @@
+// Scene drawing a memory-mapped mesh file.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_MESH_SCENE_HH_
+#define DEMONIA_SRC_MESH_SCENE_HH_
+
+#include "mesh_file.hh"
+#include "program_builder.hh"
+#include "scene.hh"
+#include "shader.hh"
+#include "vertices.hh"
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Draws a mesh file written by demonia-meshopt, fitted to the viewport and
+// spinning about its vertical axis, coloured by its normals. The vertex and
+// index data are uploaded straight from the mapped file.
+typedef class MeshScene : public Scene
+{
+public:
+    // Layout of the vertices of the mesh file.
+    typedef Vertices<Position, PackedNormal, PackedTexCoord> MeshVertices;
+
+    explicit MeshScene(const std::string& path);
+
+    ~MeshScene() override;
+
+    void load(ProgramBuilder& programs) override;
+
+    void prepare() override;
+
+    void draw(double time) override;
+
+    bool is_animated() const override
+    {
+        return true;
+    }
+
+    // Outputs the size of the mesh and the time taken to load it.
+    void report(std::ostream& os) const override;
+
+private:
+    std::string m_path;
+    double m_load_time = 0.0; // Seconds to map and upload the file
+    std::unique_ptr<MeshFile> mesh;
+    std::unique_ptr<ShaderProgram> program;
+    GLuint vbo = 0; // Vertex Buffer Object
+    GLuint ebo = 0; // Element Buffer Object
+    GLuint vao = 0; // Vertex Array Object
+} MeshScene;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_MESH_SCENE_HH_
@@ -0,0 +1,317 @@
+// Command-line tool baking optimised meshes.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_exception.hh"
+#include "mesh_file.hh"
+#include "mesh_optimizer.hh"
+#include "packing.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace
+{
+
+// Vertex of a Wavefront OBJ face corner, with every attribute resolved so
+// that identical corners can be merged byte-wise.
+struct ObjVertex
+{
+    float position[3];
+    float texcoord[2];
+    float normal[3];
+};
+
+// Triangulated mesh read from a Wavefront OBJ file.
+struct ObjMesh
+{
+    std::vector<ObjVertex> vertices; // One per face corner
+    std::vector<uint32_t> indices;
+    bool has_texcoords = false;
+    bool has_normals = false;
+};
+
+// Resolves a 1-based or negative relative OBJ index into a 0-based index.
+size_t resolve_index(long index, size_t count)
+{
+    long resolved = index < 0 ? static_cast<long>(count) + index : index - 1;
+    if (resolved < 0 || static_cast<size_t>(resolved) >= count)
+        throw std::runtime_error("index " + std::to_string(index)
+                                 + " out of range");
+    return resolved;
+}
+
+// Reads the positions, texture coordinates, normals and faces of an OBJ
+// file, splitting polygons into fans of triangles. Other statements are
+// ignored. Throws a std::runtime_error if the file is malformed.
+ObjMesh read_obj(std::istream& is)
+{
+    std::vector<std::array<float, 3>> positions;
+    std::vector<std::array<float, 2>> texcoords;
+    std::vector<std::array<float, 3>> normals;
+    ObjMesh mesh;
+
+    std::string line;
+    while (std::getline(is, line))
+    {
+        std::istringstream ss(line);
+        std::string keyword;
+        ss >> keyword;
+        if (keyword == "v")
+        {
+            std::array<float, 3> p{};
+            ss >> p[0] >> p[1] >> p[2];
+            positions.push_back(p);
+        }
+        else if (keyword == "vt")
+        {
+            std::array<float, 2> t{};
+            ss >> t[0] >> t[1];
+            texcoords.push_back(t);
+        }
+        else if (keyword == "vn")
+        {
+            std::array<float, 3> n{};
+            ss >> n[0] >> n[1] >> n[2];
+            normals.push_back(n);
+        }
+        else if (keyword == "f")
+        {
+            std::vector<ObjVertex> corners;
+            std::string corner;
+            while (ss >> corner)
+            {
+                ObjVertex vertex{};
+                std::istringstream cs(corner);
+                std::string field;
+                for (int i = 0; i < 3 && std::getline(cs, field, '/'); ++i)
+                {
+                    if (field.empty())
+                        continue;
+                    long index = std::stol(field);
+                    if (i == 0)
+                    {
+                        auto& p = positions[resolve_index(index,
+                                                          positions.size())];
+                        std::copy(p.begin(), p.end(), vertex.position);
+                    }
+                    else if (i == 1)
+                    {
+                        auto& t = texcoords[resolve_index(index,
+                                                          texcoords.size())];
+                        std::copy(t.begin(), t.end(), vertex.texcoord);
+                        mesh.has_texcoords = true;
+                    }
+                    else
+                    {
+                        auto& n = normals[resolve_index(index,
+                                                        normals.size())];
+                        std::copy(n.begin(), n.end(), vertex.normal);
+                        mesh.has_normals = true;
+                    }
+                }
+                corners.push_back(vertex);
+            }
+            if (corners.size() < 3)
+                throw std::runtime_error("face with fewer than 3 vertices");
+
+            uint32_t first = mesh.vertices.size();
+            mesh.vertices.insert(mesh.vertices.end(), corners.begin(),
+                                 corners.end());
+            for (uint32_t i = 1; i + 1 < corners.size(); ++i)
+            {
+                mesh.indices.push_back(first);
+                mesh.indices.push_back(first + i);
+                mesh.indices.push_back(first + i + 1);
+            }
+        }
+    }
+
+    return mesh;
+}
+
+// Writes a mesh as an OBJ file with one position, texture coordinate and
+// normal per vertex, so that every face corner refers to the same index for
+// each attribute.
+void write_obj(std::ostream& os, const ObjMesh& mesh)
+{
+    os.precision(9);
+    for (const ObjVertex& v : mesh.vertices)
+        os << "v " << v.position[0] << ' ' << v.position[1] << ' '
+           << v.position[2] << '\n';
+    if (mesh.has_texcoords)
+    {
+        for (const ObjVertex& v : mesh.vertices)
+            os << "vt " << v.texcoord[0] << ' ' << v.texcoord[1] << '\n';
+    }
+    if (mesh.has_normals)
+    {
+        for (const ObjVertex& v : mesh.vertices)
+            os << "vn " << v.normal[0] << ' ' << v.normal[1] << ' '
+               << v.normal[2] << '\n';
+    }
+
+    for (size_t i = 0; i < mesh.indices.size(); i += 3)
+    {
+        os << 'f';
+        for (size_t corner = 0; corner < 3; ++corner)
+        {
+            uint32_t index = mesh.indices[i + corner] + 1;
+            os << ' ' << index;
+            if (mesh.has_texcoords || mesh.has_normals)
+                os << '/';
+            if (mesh.has_texcoords)
+                os << index;
+            if (mesh.has_normals)
+                os << '/' << index;
+        }
+        os << '\n';
+    }
+}
+
+// Vertex of a mesh file, laid out as Vertices<Position, PackedNormal,
+// PackedTexCoord>.
+struct MeshFileVertex
+{
+    float position[3];
+    uint32_t normal;
+    uint16_t texcoord[2];
+};
+
+// Returns whether a path ends with a suffix.
+bool ends_with(const std::string& path, const std::string& suffix)
+{
+    return path.size() >= suffix.size()
+           && path.compare(path.size() - suffix.size(), suffix.size(),
+                           suffix) == 0;
+}
+
+// Writes a mesh as a mesh file, packing normals into 10-10-10-2 values and
+// texture coordinates, clamped to [0, 1], into normalized unsigned shorts.
+void write_mesh(std::ostream& os, const ObjMesh& mesh)
+{
+    size_t count = mesh.vertices.size();
+    std::vector<float> normals(count * 4);
+    std::vector<float> texcoords(count * 2);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const ObjVertex& v = mesh.vertices[i];
+        std::copy(v.normal, v.normal + 3, &normals[i * 4]);
+        std::copy(v.texcoord, v.texcoord + 2, &texcoords[i * 2]);
+    }
+
+    std::vector<uint32_t> packed_normals(count);
+    std::vector<uint16_t> packed_texcoords(count * 2);
+    demonia::pack_snorm_2_10_10_10(normals.data(), packed_normals.data(),
+                                   count);
+    demonia::pack_unorm16(texcoords.data(), packed_texcoords.data(),
+                          count * 2);
+
+    std::vector<MeshFileVertex> vertices(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::copy(mesh.vertices[i].position, mesh.vertices[i].position + 3,
+                  vertices[i].position);
+        vertices[i].normal = packed_normals[i];
+        vertices[i].texcoord[0] = packed_texcoords[i * 2];
+        vertices[i].texcoord[1] = packed_texcoords[i * 2 + 1];
+    }
+
+    const std::vector<demonia::MeshFileAttribute> attributes{
+        {3, GL_FLOAT, false},
+        {4, GL_INT_2_10_10_10_REV, true},
+        {2, GL_UNSIGNED_SHORT, true}};
+    demonia::write_mesh_file(os, attributes, sizeof(MeshFileVertex),
+                             vertices.data(), count, mesh.indices);
+}
+
+}; // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " INPUT.obj [OUTPUT]\n"
+                  << "\n"
+                  << "Deduplicates the vertices of a mesh and reorders it for "
+                  << "the vertex cache\nand vertex fetch, printing statistics "
+                  << "from before and after. The\noptimised mesh is written "
+                  << "to OUTPUT if given, as a binary mesh file for\n"
+                  << "'demonia --scene mesh' if its name ends in .dmsh and as "
+                  << "an OBJ file\notherwise." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ObjMesh mesh;
+    try
+    {
+        std::ifstream input(argv[1]);
+        if (!input)
+            throw std::runtime_error("cannot open file");
+        mesh = read_obj(input);
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << argv[0] << ": " << argv[1] << ": " << e.what()
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    demonia::MeshOptimization optimization;
+    try
+    {
+        optimization = demonia::optimize_mesh(mesh.vertices, mesh.indices);
+    }
+    catch (demonia::BufferException& e)
+    {
+        std::cerr << argv[0] << ": " << argv[1] << ": " << e.what();
+        return EXIT_FAILURE;
+    }
+    optimization.report(std::cout);
+
+    if (argc == 3)
+    {
+        std::string path = argv[2];
+        std::ofstream output;
+        if (ends_with(path, ".dmsh"))
+        {
+            output.open(path, std::ios::binary);
+            write_mesh(output, mesh);
+        }
+        else
+        {
+            output.open(path);
+            write_obj(output, mesh);
+        }
+        if (!output)
+        {
+            std::cerr << argv[0] << ": " << argv[2] << ": failed to write"
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,382 @@
+// Runtime options parsed from the command line.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "frame_pacer.hh"
+#include "options.hh"
+#include "scene.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace demonia
+{
+
+const unsigned long Options::k_default_headless_frame_count = 1000;
+
+#ifdef DEMONIA_SHADER_DIR
+const char* Options::k_default_shader_directory = DEMONIA_SHADER_DIR;
+#else
+const char* Options::k_default_shader_directory = "shaders";
+#endif
+
+namespace
+{
+
+// Iterates over command-line arguments, splitting '--name=value' pairs.
+class ArgumentReader
+{
+public:
+    ArgumentReader(int argc, const char* const argv[])
+            : m_argc{argc}, m_argv{argv}
+    {
+    }
+
+    // Advances to the next argument; returns false when none remain.
+    bool next()
+    {
+        if (++m_index >= m_argc)
+            return false;
+
+        m_name = m_argv[m_index];
+        m_value.clear();
+        m_has_inline_value = false;
+
+        std::string::size_type eq = m_name.find('=');
+        if (eq != std::string::npos)
+        {
+            m_value = m_name.substr(eq + 1);
+            m_name.erase(eq);
+            m_has_inline_value = true;
+        }
+
+        return true;
+    }
+
+    const std::string& name() const
+    {
+        return m_name;
+    }
+
+    // Returns the value of the current argument, consuming the following
+    // argument if the value was not given inline.
+    const std::string& value()
+    {
+        if (!m_has_inline_value)
+        {
+            if (m_index + 1 >= m_argc)
+                throw std::invalid_argument("missing value for '" + m_name
+                                            + "'");
+            m_value = m_argv[++m_index];
+            m_has_inline_value = true;
+        }
+
+        return m_value;
+    }
+
+    // Throws if a value was given to an argument which does not take one.
+    void expect_flag() const
+    {
+        if (m_has_inline_value)
+            throw std::invalid_argument("'" + m_name
+                                        + "' does not take a value");
+    }
+
+    // Parses the value of the current argument as a positive number.
+    double positive_value()
+    {
+        const std::string& str = value();
+        std::size_t end = 0;
+        double result = 0.0;
+        try
+        {
+            result = std::stod(str, &end);
+        }
+        catch (std::logic_error&)
+        {
+            end = 0;
+        }
+
+        if (end == 0 || end != str.size() || !(result > 0.0))
+            throw std::invalid_argument("invalid value '" + str + "' for '"
+                                        + m_name + "'");
+        return result;
+    }
+
+    // Parses the value of the current argument as an unsigned integer.
+    unsigned long unsigned_value()
+    {
+        const std::string& str = value();
+        std::size_t end = 0;
+        unsigned long result = 0;
+        try
+        {
+            if (!str.empty() && str[0] != '-')
+                result = std::stoul(str, &end);
+        }
+        catch (std::logic_error&)
+        {
+            end = 0;
+        }
+
+        if (end == 0 || end != str.size())
+            throw std::invalid_argument("invalid value '" + str + "' for '"
+                                        + m_name + "'");
+        return result;
+    }
+
+private:
+    int m_argc;
+    const char* const* m_argv;
+    int m_index = 0;
+    std::string m_name;
+    std::string m_value;
+    bool m_has_inline_value = false;
+};
+
+const char* const k_present_mode_names[] = {
+    "uncapped",
+    "vsync",
+    "adaptive",
+    "limit"
+};
+
+// Parses the name of a present mode.
+PresentMode parse_present_mode(const std::string& name)
+{
+    for (std::size_t i = 0; i < std::size(k_present_mode_names); ++i)
+    {
+        if (name == k_present_mode_names[i])
+            return static_cast<PresentMode>(i);
+    }
+
+    throw std::invalid_argument("unknown present mode '" + name + "'");
+}
+
+}; // namespace
+
+const char* present_mode_name(PresentMode mode) noexcept
+{
+    return k_present_mode_names[static_cast<std::size_t>(mode)];
+}
+
+Options parse_options(int argc, const char* const argv[])
+{
+    Options options;
+    ArgumentReader args(argc, argv);
+    bool present_mode_given = false;
+
+    while (args.next())
+    {
+        const std::string& name = args.name();
+        if (name == "--headless")
+        {
+            args.expect_flag();
+            options.headless = true;
+        }
+        else if (name == "--frames")
+        {
+            options.frame_count = args.unsigned_value();
+        }
+        else if (name == "--stats")
+        {
+            args.expect_flag();
+            options.print_stats = true;
+        }
+        else if (name == "--present-mode")
+        {
+            options.present_mode = parse_present_mode(args.value());
+            present_mode_given = true;
+        }
+        else if (name == "--fps-limit")
+        {
+            options.frame_rate_limit = args.positive_value();
+        }
+        else if (name == "--frames-in-flight")
+        {
+            unsigned long count = args.unsigned_value();
+            if (count < 1 || count > FramePacer::k_max_frames_in_flight)
+                throw std::invalid_argument("'--frames-in-flight' must be \
+from 1 to " + std::to_string(FramePacer::k_max_frames_in_flight));
+            options.frames_in_flight = count;
+        }
+        else if (name == "--late-latch")
+        {
+            args.expect_flag();
+            options.late_latch = true;
+        }
+        else if (name == "--profile")
+        {
+            args.expect_flag();
+            options.profile = true;
+        }
+        else if (name == "--profile-output")
+        {
+            options.profile_output = args.value();
+            options.profile = true;
+        }
+        else if (name == "--shader-cache")
+        {
+            options.shader_cache_directory = args.value();
+            options.shader_cache = true;
+        }
+        else if (name == "--no-shader-cache")
+        {
+            args.expect_flag();
+            options.shader_cache = false;
+        }
+        else if (name == "--hot-reload")
+        {
+            args.expect_flag();
+            options.hot_reload = true;
+        }
+        else if (name == "--shader-dir")
+        {
+            options.shader_directory = args.value();
+        }
+        else if (name == "--on-demand")
+        {
+            args.expect_flag();
+            options.on_demand = true;
+        }
+        else if (name == "--animation-rate")
+        {
+            options.animation_rate = args.positive_value();
+        }
+        else if (name == "--update-rate")
+        {
+            options.update_rate = args.positive_value();
+        }
+        else if (name == "--scene")
+        {
+            options.scene = args.value();
+            const std::vector<std::string>& names = scene_names();
+            if (std::find(names.begin(), names.end(), options.scene)
+                == names.end())
+                throw std::invalid_argument("unknown scene '" + options.scene
+                                            + "'");
+        }
+        else if (name == "--mesh")
+        {
+            options.mesh_path = args.value();
+        }
+        else if (name == "--stream-budget")
+        {
+            unsigned long kibibytes = args.unsigned_value();
+            if (kibibytes < 1)
+                throw std::invalid_argument("'--stream-budget' must be at \
+least 1");
+            options.stream_budget = kibibytes * 1024;
+        }
+        else
+        {
+            throw std::invalid_argument("unknown argument '" + name + "'");
+        }
+    }
+
+    if (options.frame_rate_limit > 0.0)
+    {
+        if (present_mode_given && options.present_mode != PresentMode::LIMITED)
+            throw std::invalid_argument("'--fps-limit' requires present mode \
+'limit'");
+        options.present_mode = PresentMode::LIMITED;
+    }
+    else if (options.present_mode == PresentMode::LIMITED)
+    {
+        throw std::invalid_argument("present mode 'limit' requires \
+'--fps-limit'");
+    }
+    else if (options.headless)
+    {
+        options.present_mode = PresentMode::UNCAPPED;
+    }
+
+    if (options.late_latch && !options.frames_in_flight)
+        throw std::invalid_argument("'--late-latch' requires \
+'--frames-in-flight'");
+
+    if ((options.scene == "mesh" || options.scene == "mesh-streamed")
+        && options.mesh_path.empty())
+        throw std::invalid_argument("scene '" + options.scene
+                                    + "' requires '--mesh'");
+
+    if (options.on_demand && options.headless)
+        throw std::invalid_argument("'--on-demand' requires a window");
+
+    if (options.headless)
+    {
+        options.print_stats = true;
+        if (options.frame_count == 0)
+            options.frame_count = Options::k_default_headless_frame_count;
+    }
+
+    return options;
+}
+
+void print_usage(std::ostream& os, const char* program_name)
+{
+    os << "Usage: " << program_name << " [options]\n"
+       << "\n"
+       << "Options:\n"
+       << "  --headless    render offscreen without a window\n"
+       << "  --frames N    exit after rendering N frames\n"
+       << "  --stats       print frame-time statistics upon exit\n"
+       << "  --present-mode MODE\n"
+       << "                frame pacing: uncapped, vsync (default), adaptive\n"
+       << "                or limit\n"
+       << "  --fps-limit N limit the frame rate to N on the CPU; implies\n"
+       << "                '--present-mode limit'\n"
+       << "  --frames-in-flight N\n"
+       << "                let the CPU run at most N (1 to 3) frames ahead\n"
+       << "                of the GPU and report the input latency\n"
+       << "  --late-latch  poll input again just before drawing; requires\n"
+       << "                '--frames-in-flight'\n"
+       << "  --profile     print CPU and GPU stage percentiles upon exit\n"
+       << "  --profile-output FILE\n"
+       << "                write stage percentiles to FILE as CSV\n"
+       << "  --shader-cache DIR\n"
+       << "                cache program binaries in DIR\n"
+       << "  --no-shader-cache\n"
+       << "                always compile shaders from source\n"
+       << "  --hot-reload  rebuild shaders when their files change\n"
+       << "  --shader-dir DIR\n"
+       << "                directory of the shader files to watch\n"
+       << "  --on-demand   render only when the scene changes or on input\n"
+       << "  --animation-rate N\n"
+       << "                redraw animated scenes N times per second when\n"
+       << "                rendering on demand (default 30)\n"
+       << "  --update-rate N\n"
+       << "                update simulated scenes N times per second\n"
+       << "                (default 60)\n"
+       << "  --scene NAME  scene to draw: triangle (default),\n"
+       << "                triangle-packed, stream-interleaved,\n"
+       << "                stream-separate, stream-interleaved-ring,\n"
+       << "                stream-separate-ring, instanced, uninstanced,\n"
+       << "                strips, queue, queue-unsorted, jobs, bodies,\n"
+       << "                mesh, mesh-streamed, textures, sprites,\n"
+       << "                sprites-atlas or frustum\n"
+       << "  --mesh FILE   mesh file drawn by the mesh scenes, written by\n"
+       << "                demonia-meshopt\n"
+       << "  --stream-budget KIB\n"
+       << "                upload at most KIB KiB of streamed geometry per\n"
+       << "                frame (default 1024)\n";
+}
+
+}; // namespace demonia
@@ -0,0 +1,131 @@
+// Runtime options parsed from the command line.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_OPTIONS_HH_
+#define DEMONIA_SRC_OPTIONS_HH_
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace demonia
+{
+
+// Strategies for pacing the presentation of frames.
+enum class PresentMode
+{
+    UNCAPPED, // Present immediately, without waiting for vertical blanking
+    VSYNC,    // Wait for vertical blanking before each buffer swap
+    ADAPTIVE, // Wait for vertical blanking unless the frame is late, in which
+              // case present immediately and allow tearing
+    LIMITED   // Present immediately, limiting the frame rate on the CPU
+};
+
+// Returns the command-line name of a present mode.
+const char* present_mode_name(PresentMode mode) noexcept;
+
+// Runtime configuration of the GL handler.
+typedef struct Options
+{
+    // Renders into an offscreen framebuffer using a surfaceless EGL context
+    // instead of creating a window.
+    bool headless = false;
+
+    // Number of frames to render before exiting; 0 renders until the window
+    // is closed, or k_default_headless_frame_count frames in headless mode.
+    unsigned long frame_count = 0;
+
+    // Outputs frame-time statistics to stdout upon exit. Always enabled in
+    // headless mode.
+    bool print_stats = false;
+
+    // Measures CPU and GPU time spent in each stage of a frame and outputs
+    // percentiles to stdout upon exit.
+    bool profile = false;
+
+    // Path of a file to which profiling percentiles are written as
+    // comma-separated values instead of stdout; implies profile.
+    std::string profile_output;
+
+    // Frame pacing strategy. Swap intervals have no effect in headless mode,
+    // which is uncapped unless a frame rate limit is given.
+    PresentMode present_mode = PresentMode::VSYNC;
+
+    // Target frame rate of PresentMode::LIMITED, in frames per second.
+    double frame_rate_limit = 0.0;
+
+    // Maximum number of frames submitted ahead of the GPU, from 1 to
+    // FramePacer::k_max_frames_in_flight, bounded by waiting on a fence
+    // inserted after each frame; 0 leaves queueing to the driver.
+    unsigned int frames_in_flight = 0;
+
+    // Polls input again immediately before drawing, rather than only at the
+    // start of the frame; requires frames_in_flight.
+    bool late_latch = false;
+
+    // Caches linked program binaries on disk to skip shader compilation on
+    // later runs.
+    bool shader_cache = true;
+
+    // Directory of the program binary cache; empty for the default of
+    // ProgramCache::default_directory().
+    std::string shader_cache_directory;
+
+    // Watches the shader directory and swaps in rebuilt programs when shader
+    // files change.
+    bool hot_reload = false;
+
+    // Directory containing the shader source files, watched by hot-reload.
+    std::string shader_directory = k_default_shader_directory;
+
+    // Renders a frame only when the scene is invalidated, by an update of a
+    // simulated scene, a tick of an animated one, or a resize or input
+    // event, blocking for events in between. Requires a window.
+    bool on_demand = false;
+
+    // Rate of the animation ticks of on-demand rendering, in ticks per
+    // second.
+    double animation_rate = 30.0;
+
+    // Rate at which simulated scenes are updated on the update thread, in
+    // updates per second.
+    double update_rate = 60.0;
+
+    // Name of the scene to draw, one of scene_names().
+    std::string scene = "triangle";
+
+    // Path of the mesh file drawn by the "mesh" and "mesh-streamed" scenes,
+    // which require it.
+    std::string mesh_path;
+
+    // Bytes of geometry uploaded per frame by the "mesh-streamed" scene.
+    std::size_t stream_budget = 1024 * 1024;
+
+    static const unsigned long k_default_headless_frame_count;
+    static const char* k_default_shader_directory;
+} Options;
+
+// Parses command-line arguments into a set of options. Values may be given
+// as '--name=value' or '--name value'. If an argument is unknown or its value
+// is invalid, throws a std::invalid_argument.
+Options parse_options(int argc, const char* const argv[]);
+
+// Outputs a description of the accepted command-line arguments.
+void print_usage(std::ostream& os, const char* program_name);
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_OPTIONS_HH_
@@ -0,0 +1,150 @@
+// Benchmark of vertex attribute packing throughput.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "packing.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+typedef std::chrono::steady_clock Clock;
+
+// Number of floats converted per run, large enough to exceed the caches.
+const size_t k_float_count = 1 << 24;
+const unsigned int k_runs = 10;
+
+// Kernel under test, converting k_float_count floats at a level into an
+// output buffer.
+typedef std::function<void(const float*, void*, demonia::SimdLevel)> Kernel;
+
+typedef struct Benchmark
+{
+    const char* name;
+    float min; // Range of the input, as for real attributes of the format
+    float max;
+    size_t output_size; // Bytes per input float
+    Kernel kernel;
+} Benchmark;
+
+const demonia::SimdLevel k_levels[] = {
+    demonia::SimdLevel::SCALAR,
+    demonia::SimdLevel::SSE41,
+    demonia::SimdLevel::AVX2
+};
+
+}; // namespace
+
+int main()
+{
+    std::vector<float> input(k_float_count);
+    std::mt19937 random(0);
+
+    const Benchmark benchmarks[] = {
+        {"half", -1.0f, 1.0f, 2,
+            [](const float* in, void* out, demonia::SimdLevel level)
+            {
+                demonia::pack_half(in, static_cast<uint16_t*>(out),
+                                   k_float_count, level);
+            }},
+        {"unorm8", 0.0f, 1.0f, 1,
+            [](const float* in, void* out, demonia::SimdLevel level)
+            {
+                demonia::pack_unorm8(in, static_cast<uint8_t*>(out),
+                                     k_float_count, level);
+            }},
+        {"unorm16", 0.0f, 1.0f, 2,
+            [](const float* in, void* out, demonia::SimdLevel level)
+            {
+                demonia::pack_unorm16(in, static_cast<uint16_t*>(out),
+                                      k_float_count, level);
+            }},
+        {"snorm 10-10-10-2", -1.0f, 1.0f, 1,
+            [](const float* in, void* out, demonia::SimdLevel level)
+            {
+                demonia::pack_snorm_2_10_10_10(in,
+                                               static_cast<uint32_t*>(out),
+                                               k_float_count / 4, level);
+            }}
+    };
+
+    std::cout << "CPU SIMD level: "
+              << demonia::simd_level_name(demonia::simd_level()) << "\n"
+              << "Converting " << k_float_count << " floats, best of "
+              << k_runs << " runs\n\n"
+              << std::left << std::setw(18) << "Format" << std::setw(8)
+              << "Level" << std::right << std::setw(12) << "Mfloat/s"
+              << std::setw(12) << "GB/s in" << std::setw(10) << "Speedup"
+              << std::endl;
+
+    bool mismatch = false;
+    for (const Benchmark& benchmark : benchmarks)
+    {
+        std::uniform_real_distribution<float> distribution(benchmark.min,
+                                                           benchmark.max);
+        for (float& value : input)
+            value = distribution(random);
+
+        std::vector<unsigned char> reference(k_float_count
+                                             * benchmark.output_size);
+        std::vector<unsigned char> output(reference.size());
+        benchmark.kernel(input.data(), reference.data(),
+                         demonia::SimdLevel::SCALAR);
+
+        double scalar_seconds = 0.0;
+        for (demonia::SimdLevel level : k_levels)
+        {
+            if (level > demonia::simd_level())
+                continue;
+
+            double best = 1e9;
+            for (unsigned int run = 0; run < k_runs; ++run)
+            {
+                Clock::time_point start = Clock::now();
+                benchmark.kernel(input.data(), output.data(), level);
+                std::chrono::duration<double> elapsed = Clock::now() - start;
+                best = std::min(best, elapsed.count());
+            }
+            if (level == demonia::SimdLevel::SCALAR)
+                scalar_seconds = best;
+
+            if (output != reference)
+                mismatch = true;
+
+            std::cout << std::left << std::setw(18) << benchmark.name
+                      << std::setw(8) << demonia::simd_level_name(level)
+                      << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(12) << k_float_count / best / 1e6
+                      << std::setprecision(2) << std::setw(12)
+                      << k_float_count * sizeof(float) / best / 1e9
+                      << std::setw(9) << scalar_seconds / best << "x"
+                      << (output != reference ? "  MISMATCH" : "")
+                      << std::endl;
+        }
+    }
+
+    return mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
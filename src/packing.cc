@@ -0,0 +1,490 @@
+// Conversion of floats into packed vertex attribute formats.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "packing.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define DEMONIA_PACKING_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace demonia
+{
+
+namespace
+{
+
+// Scalar kernels, which also finish the elements left over by the SIMD ones.
+
+// Clamps a value to [lo, hi] the way MAXPS and MINPS do, so that NaN
+// becomes lo.
+inline float clamp(float value, float lo, float hi) noexcept
+{
+    return std::min(std::max(lo, value), hi);
+}
+
+// Rounds a value of magnitude below 2^22 to nearest even, as CVTPS2DQ does
+// in the default rounding mode. Adding 1.5 * 2^23 leaves the rounded integer
+// in the low mantissa bits without a call to nearbyint().
+inline int32_t round_even(float value) noexcept
+{
+    const float magic = 12582912.0f;
+    const int32_t magic_bits = 0x4b400000;
+
+    float shifted = value + magic;
+    int32_t bits;
+    std::memcpy(&bits, &shifted, sizeof(bits));
+    return bits - magic_bits;
+}
+
+// Converts a float to a half by integer arithmetic, rounding to nearest
+// even; after F. Giesen's float_to_half_fast3_rtne.
+inline uint16_t float_to_half(float value) noexcept
+{
+    const uint32_t f32_infinity = 255u << 23;
+    const uint32_t f16_max = (127u + 16) << 23;
+    const uint32_t denormal_magic_bits = ((127u - 15) + (23 - 10) + 1) << 23;
+
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint16_t half;
+    if (bits >= f16_max)
+    {
+        // Infinity or NaN
+        half = bits > f32_infinity ? 0x7e00 : 0x7c00;
+    }
+    else if (bits < (113u << 23))
+    {
+        // Subnormal or zero, rounded by adding a magic number
+        float magic;
+        std::memcpy(&magic, &denormal_magic_bits, sizeof(magic));
+        float shifted;
+        std::memcpy(&shifted, &bits, sizeof(shifted));
+        shifted += magic;
+        std::memcpy(&bits, &shifted, sizeof(bits));
+        half = bits - denormal_magic_bits;
+    }
+    else
+    {
+        // Normal, rebiased with the mantissa rounded
+        uint32_t mantissa_odd = (bits >> 13) & 1;
+        bits += (static_cast<uint32_t>(15 - 127) << 23) + 0xfff;
+        bits += mantissa_odd;
+        half = bits >> 13;
+    }
+    return half | (sign >> 16);
+}
+
+void pack_half_scalar(const float* in, uint16_t* out, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        out[i] = float_to_half(in[i]);
+}
+
+void pack_unorm8_scalar(const float* in, uint8_t* out, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        out[i] = round_even(clamp(in[i], 0.0f, 1.0f) * 255.0f);
+}
+
+void pack_unorm16_scalar(const float* in, uint16_t* out, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        out[i] = round_even(clamp(in[i], 0.0f, 1.0f) * 65535.0f);
+}
+
+void pack_snorm_2_10_10_10_scalar(const float* in, uint32_t* out,
+                                  size_t count)
+{
+    for (size_t i = 0; i < count; ++i, in += 4)
+    {
+        uint32_t x = round_even(clamp(in[0], -1.0f, 1.0f) * 511.0f);
+        uint32_t y = round_even(clamp(in[1], -1.0f, 1.0f) * 511.0f);
+        uint32_t z = round_even(clamp(in[2], -1.0f, 1.0f) * 511.0f);
+        uint32_t w = round_even(clamp(in[3], -1.0f, 1.0f));
+        out[i] = (x & 0x3ff) | (y & 0x3ff) << 10 | (z & 0x3ff) << 20
+                 | (w & 0x3) << 30;
+    }
+}
+
+#ifdef DEMONIA_PACKING_X86
+
+// SSE4.1 kernels.
+
+// Converts four floats to halves in the low 16 bits of each lane, with the
+// high bits set for negative values so that signed saturation preserves
+// them; the vector form of float_to_half().
+__attribute__((target("sse4.1")))
+inline __m128i float_to_half_sse(__m128 value) noexcept
+{
+    const __m128i sign_mask = _mm_set1_epi32(0x80000000u);
+    const __m128i f16_max = _mm_set1_epi32((127 + 16) << 23);
+    const __m128i nan_bit = _mm_set1_epi32(0x200);
+    const __m128i infinity = _mm_set1_epi32(0x7c00);
+    const __m128i min_normal = _mm_set1_epi32((127 - 14) << 23);
+    const __m128i denormal_magic = _mm_set1_epi32(
+            ((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i normal_bias = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+    __m128 sign = _mm_and_ps(_mm_castsi128_ps(sign_mask), value);
+    __m128 abs = _mm_xor_ps(value, sign);
+    __m128i abs_bits = _mm_castps_si128(abs);
+
+    __m128i is_nan = _mm_castps_si128(_mm_cmpunord_ps(abs, abs));
+    __m128i is_finite = _mm_cmpgt_epi32(f16_max, abs_bits);
+    __m128i special = _mm_or_si128(_mm_and_si128(is_nan, nan_bit), infinity);
+    __m128i is_subnormal = _mm_cmpgt_epi32(min_normal, abs_bits);
+
+    __m128i subnormal = _mm_sub_epi32(
+            _mm_castps_si128(_mm_add_ps(abs,
+                                        _mm_castsi128_ps(denormal_magic))),
+            denormal_magic);
+
+    __m128i mantissa_odd = _mm_srai_epi32(_mm_slli_epi32(abs_bits, 31 - 13),
+                                          31);
+    __m128i normal = _mm_srli_epi32(
+            _mm_sub_epi32(_mm_add_epi32(abs_bits, normal_bias), mantissa_odd),
+            13);
+
+    __m128i finite = _mm_blendv_epi8(normal, subnormal, is_subnormal);
+    __m128i half = _mm_blendv_epi8(special, finite, is_finite);
+    return _mm_or_si128(half, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+__attribute__((target("sse4.1")))
+void pack_half_sse41(const float* in, uint16_t* out, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i lo = float_to_half_sse(_mm_loadu_ps(in + i));
+        __m128i hi = float_to_half_sse(_mm_loadu_ps(in + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_packs_epi32(lo, hi));
+    }
+    pack_half_scalar(in + i, out + i, count - i);
+}
+
+// Scales four floats clamped to [lo, hi] and rounds them to integers.
+__attribute__((target("sse4.1")))
+inline __m128i scale_sse(const float* in, __m128 lo, __m128 hi, __m128 scale)
+    noexcept
+{
+    __m128 value = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in), lo), hi);
+    return _mm_cvtps_epi32(_mm_mul_ps(value, scale));
+}
+
+__attribute__((target("sse4.1")))
+void pack_unorm8_sse41(const float* in, uint8_t* out, size_t count)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i a = scale_sse(in + i, zero, one, scale);
+        __m128i b = scale_sse(in + i + 4, zero, one, scale);
+        __m128i c = scale_sse(in + i + 8, zero, one, scale);
+        __m128i d = scale_sse(in + i + 12, zero, one, scale);
+        __m128i packed = _mm_packus_epi16(_mm_packus_epi32(a, b),
+                                          _mm_packus_epi32(c, d));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    pack_unorm8_scalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("sse4.1")))
+void pack_unorm16_sse41(const float* in, uint16_t* out, size_t count)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(65535.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i a = scale_sse(in + i, zero, one, scale);
+        __m128i b = scale_sse(in + i + 4, zero, one, scale);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                         _mm_packus_epi32(a, b));
+    }
+    pack_unorm16_scalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("sse4.1")))
+void pack_snorm_2_10_10_10_sse41(const float* in, uint32_t* out,
+                                 size_t count)
+{
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_setr_ps(511.0f, 511.0f, 511.0f, 1.0f);
+    const __m128i mask = _mm_setr_epi32(0x3ff, 0x3ff, 0x3ff, 0x3);
+    const __m128i shift = _mm_setr_epi32(1, 1 << 10, 1 << 20, 1 << 30);
+
+    // The fields of each vector occupy disjoint bits, so adding them
+    // horizontally combines them
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i v[4];
+        for (int j = 0; j < 4; ++j)
+        {
+            v[j] = scale_sse(in + (i + j) * 4, lo, hi, scale);
+            v[j] = _mm_mullo_epi32(_mm_and_si128(v[j], mask), shift);
+        }
+        __m128i packed = _mm_hadd_epi32(_mm_hadd_epi32(v[0], v[1]),
+                                        _mm_hadd_epi32(v[2], v[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    pack_snorm_2_10_10_10_scalar(in + i * 4, out + i, count - i);
+}
+
+// AVX2 kernels.
+
+// Scales eight floats clamped to [lo, hi] and rounds them to integers.
+__attribute__((target("avx2")))
+inline __m256i scale_avx(const float* in, __m256 lo, __m256 hi, __m256 scale)
+    noexcept
+{
+    __m256 value = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in), lo), hi);
+    return _mm256_cvtps_epi32(_mm256_mul_ps(value, scale));
+}
+
+__attribute__((target("avx2,f16c")))
+void pack_half_avx2(const float* in, uint16_t* out, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i lo = _mm256_cvtps_ph(_mm256_loadu_ps(in + i),
+                                     _MM_FROUND_TO_NEAREST_INT);
+        __m128i hi = _mm256_cvtps_ph(_mm256_loadu_ps(in + i + 8),
+                                     _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), hi);
+    }
+    pack_half_scalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void pack_unorm8_avx2(const float* in, uint8_t* out, size_t count)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(255.0f);
+    // Packing works within 128-bit lanes, leaving groups of four bytes in
+    // this order
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i a = scale_avx(in + i, zero, one, scale);
+        __m256i b = scale_avx(in + i + 8, zero, one, scale);
+        __m256i c = scale_avx(in + i + 16, zero, one, scale);
+        __m256i d = scale_avx(in + i + 24, zero, one, scale);
+        __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(a, b),
+                                             _mm256_packus_epi32(c, d));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                            _mm256_permutevar8x32_epi32(packed, order));
+    }
+    pack_unorm8_scalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void pack_unorm16_avx2(const float* in, uint16_t* out, size_t count)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(65535.0f);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        __m256i a = scale_avx(in + i, zero, one, scale);
+        __m256i b = scale_avx(in + i + 8, zero, one, scale);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b),
+                                                  _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    pack_unorm16_scalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void pack_snorm_2_10_10_10_avx2(const float* in, uint32_t* out, size_t count)
+{
+    const __m256 lo = _mm256_set1_ps(-1.0f);
+    const __m256 hi = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_setr_ps(511.0f, 511.0f, 511.0f, 1.0f,
+                                        511.0f, 511.0f, 511.0f, 1.0f);
+    const __m256i mask = _mm256_setr_epi32(0x3ff, 0x3ff, 0x3ff, 0x3,
+                                           0x3ff, 0x3ff, 0x3ff, 0x3);
+    const __m256i shift = _mm256_setr_epi32(0, 10, 20, 30, 0, 10, 20, 30);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i v[4];
+        for (int j = 0; j < 4; ++j)
+        {
+            v[j] = scale_avx(in + (i + j * 2) * 4, lo, hi, scale);
+            v[j] = _mm256_sllv_epi32(_mm256_and_si256(v[j], mask), shift);
+        }
+        __m256i packed = _mm256_hadd_epi32(_mm256_hadd_epi32(v[0], v[1]),
+                                           _mm256_hadd_epi32(v[2], v[3]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i),
+                            _mm256_permutevar8x32_epi32(packed, order));
+    }
+    pack_snorm_2_10_10_10_scalar(in + i * 4, out + i, count - i);
+}
+
+#endif // DEMONIA_PACKING_X86
+
+SimdLevel detect_simd_level()
+{
+#ifdef DEMONIA_PACKING_X86
+    unsigned int eax, ebx, ecx, edx;
+    bool f16c = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_F16C);
+    if (__builtin_cpu_supports("avx2") && f16c)
+        return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse4.1"))
+        return SimdLevel::SSE41;
+#endif
+    return SimdLevel::SCALAR;
+}
+
+// Returns a level lowered to one supported by the CPU.
+inline SimdLevel supported(SimdLevel level) noexcept
+{
+    SimdLevel highest = simd_level();
+    return level > highest ? highest : level;
+}
+
+}; // namespace
+
+const char* simd_level_name(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::SSE41: return "sse4.1";
+    case SimdLevel::AVX2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+SimdLevel simd_level()
+{
+    static const SimdLevel level = detect_simd_level();
+    return level;
+}
+
+void pack_half(const float* in, uint16_t* out, size_t count, SimdLevel level)
+{
+    switch (supported(level))
+    {
+#ifdef DEMONIA_PACKING_X86
+    case SimdLevel::AVX2: return pack_half_avx2(in, out, count);
+    case SimdLevel::SSE41: return pack_half_sse41(in, out, count);
+#endif
+    default: return pack_half_scalar(in, out, count);
+    }
+}
+
+void pack_unorm8(const float* in, uint8_t* out, size_t count,
+                 SimdLevel level)
+{
+    switch (supported(level))
+    {
+#ifdef DEMONIA_PACKING_X86
+    case SimdLevel::AVX2: return pack_unorm8_avx2(in, out, count);
+    case SimdLevel::SSE41: return pack_unorm8_sse41(in, out, count);
+#endif
+    default: return pack_unorm8_scalar(in, out, count);
+    }
+}
+
+void pack_unorm16(const float* in, uint16_t* out, size_t count,
+                  SimdLevel level)
+{
+    switch (supported(level))
+    {
+#ifdef DEMONIA_PACKING_X86
+    case SimdLevel::AVX2: return pack_unorm16_avx2(in, out, count);
+    case SimdLevel::SSE41: return pack_unorm16_sse41(in, out, count);
+#endif
+    default: return pack_unorm16_scalar(in, out, count);
+    }
+}
+
+void pack_snorm_2_10_10_10(const float* in, uint32_t* out, size_t count,
+                           SimdLevel level)
+{
+    switch (supported(level))
+    {
+#ifdef DEMONIA_PACKING_X86
+    case SimdLevel::AVX2: return pack_snorm_2_10_10_10_avx2(in, out, count);
+    case SimdLevel::SSE41: return pack_snorm_2_10_10_10_sse41(in, out, count);
+#endif
+    default: return pack_snorm_2_10_10_10_scalar(in, out, count);
+    }
+}
+
+// After F. Giesen's half_to_float: the exponent is rebiased in place, then
+// subnormals are normalised by subtracting a magic number.
+float unpack_half(uint16_t half) noexcept
+{
+    const uint32_t f16_exponent = 0x7c00u << 13;
+    const uint32_t denormal_magic_bits = 113u << 23;
+
+    uint32_t bits = (half & 0x7fffu) << 13;
+    uint32_t exponent = bits & f16_exponent;
+    bits += (127u - 15) << 23;
+    if (exponent == f16_exponent)
+    {
+        // Infinity or NaN
+        bits += (128u - 16) << 23;
+    }
+    else if (exponent == 0)
+    {
+        // Subnormal or zero
+        bits += 1u << 23;
+        float magic;
+        std::memcpy(&magic, &denormal_magic_bits, sizeof(magic));
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        value -= magic;
+        std::memcpy(&bits, &value, sizeof(bits));
+    }
+    bits |= static_cast<uint32_t>(half & 0x8000u) << 16;
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+}; // namespace demonia
@@ -0,0 +1,69 @@
+// Conversion of floats into packed vertex attribute formats.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_PACKING_HH_
+#define DEMONIA_SRC_PACKING_HH_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace demonia
+{
+
+// Instruction set extensions used by the packing kernels, in order of
+// preference.
+enum class SimdLevel
+{
+    SCALAR,
+    SSE41, // SSE4.1
+    AVX2   // AVX2 and F16C
+};
+
+// Returns the name of a SIMD level.
+const char* simd_level_name(SimdLevel level);
+
+// Returns the highest SIMD level supported by the CPU, detected once.
+SimdLevel simd_level();
+
+// Kernels converting arrays of floats into packed formats. Every level
+// produces identical results, rounding to nearest even, except for the
+// payloads of NaNs converted to halves. A level higher than simd_level() is
+// lowered to it.
+
+// Converts floats into IEEE 754 half-precision floats (GL_HALF_FLOAT).
+void pack_half(const float* in, uint16_t* out, size_t count,
+               SimdLevel level = simd_level());
+
+// Converts floats clamped to [0, 1] into normalized unsigned bytes.
+void pack_unorm8(const float* in, uint8_t* out, size_t count,
+                 SimdLevel level = simd_level());
+
+// Converts floats clamped to [0, 1] into normalized unsigned shorts.
+void pack_unorm16(const float* in, uint16_t* out, size_t count,
+                  SimdLevel level = simd_level());
+
+// Converts vectors of four floats clamped to [-1, 1] into signed normalized
+// 10-10-10-2 values (GL_INT_2_10_10_10_REV), with x in the lowest bits. Reads
+// 4 * count floats.
+void pack_snorm_2_10_10_10(const float* in, uint32_t* out, size_t count,
+                           SimdLevel level = simd_level());
+
+// Converts an IEEE 754 half-precision float back into a float, exactly.
+float unpack_half(uint16_t half) noexcept;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_PACKING_HH_
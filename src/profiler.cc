@@ -0,0 +1,279 @@
+// CPU and GPU frame-time instrumentation.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "profiler.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ios>
+#include <iomanip>
+#include <ostream>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+const char* const k_metric_names[] = {
+    "cpu_frame",
+    "cpu_poll",
+    "cpu_swap",
+    "gpu_clear",
+    "gpu_draw"
+};
+
+static_assert(sizeof(k_metric_names) / sizeof(*k_metric_names)
+                  == static_cast<std::size_t>(ProfileMetric::COUNT),
+              "every profile metric must be named");
+
+// Returns the index of the most significant set bit of a non-zero value.
+inline unsigned int most_significant_bit(uint64_t value) noexcept
+{
+    return 63 - __builtin_clzll(value);
+}
+
+}; // namespace
+
+unsigned int Histogram::bucket_index(uint64_t nanoseconds) noexcept
+{
+    if (nanoseconds < k_sub_bucket_count)
+        return nanoseconds;
+
+    unsigned int msb = most_significant_bit(nanoseconds);
+    unsigned int shift = msb - k_sub_bucket_bits;
+    unsigned int sub = (nanoseconds >> shift) - k_sub_bucket_count;
+    return k_sub_bucket_count + shift * k_sub_bucket_count + sub;
+}
+
+uint64_t Histogram::bucket_lower_bound(unsigned int index) noexcept
+{
+    if (index < k_sub_bucket_count)
+        return index;
+
+    unsigned int shift = (index - k_sub_bucket_count) / k_sub_bucket_count;
+    unsigned int sub = (index - k_sub_bucket_count) % k_sub_bucket_count;
+    return static_cast<uint64_t>(k_sub_bucket_count + sub) << shift;
+}
+
+void Histogram::add(uint64_t nanoseconds) noexcept
+{
+    ++m_buckets[bucket_index(nanoseconds)];
+    ++m_count;
+    m_sum += nanoseconds;
+    m_max = std::max(m_max, nanoseconds);
+}
+
+uint64_t Histogram::percentile(double fraction) const noexcept
+{
+    if (m_count == 0)
+        return 0;
+
+    uint64_t target = std::max<uint64_t>(
+            1, static_cast<uint64_t>(std::ceil(fraction * m_count)));
+    uint64_t cumulative = 0;
+    for (unsigned int i = 0; i < k_bucket_count; ++i)
+    {
+        cumulative += m_buckets[i];
+        if (cumulative >= target)
+        {
+            if (i + 1 == k_bucket_count)
+                return m_max;
+
+            /// Report the middle of the bucket, without exceeding the
+            /// largest recorded duration
+            uint64_t lower = bucket_lower_bound(i);
+            uint64_t width = bucket_lower_bound(i + 1) - lower;
+            return std::min(lower + width / 2, m_max);
+        }
+    }
+
+    return m_max;
+}
+
+Profiler::Profiler()
+{
+    for (auto& slot : m_queries)
+        glGenQueries(slot.size(), slot.data());
+}
+
+Profiler::~Profiler()
+{
+    for (auto& slot : m_queries)
+        glDeleteQueries(slot.size(), slot.data());
+}
+
+void Profiler::resolve(unsigned int slot, bool wait)
+{
+    for (std::size_t i = 0; i < k_gpu_metric_count; ++i)
+    {
+        if (!m_pending[slot][i])
+            continue;
+
+        GLuint query = m_queries[slot][i];
+        if (!wait)
+        {
+            GLint available = GL_FALSE;
+            glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+        }
+
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+        m_pending[slot][i] = false;
+        push(static_cast<ProfileMetric>(
+                 i + static_cast<std::size_t>(ProfileMetric::GPU_CLEAR)),
+             elapsed);
+    }
+}
+
+void Profiler::begin_frame()
+{
+    m_frame_start = Clock::now();
+    m_slot = (m_slot + 1) % k_gpu_latency;
+
+    for (unsigned int slot = 0; slot < k_gpu_latency; ++slot)
+        resolve(slot, false);
+
+    /// Queries still pending in the slot about to be reused are discarded
+    /// rather than waited upon, so that profiling never stalls the pipeline
+    for (bool& pending : m_pending[m_slot])
+    {
+        if (pending)
+            ++m_gpu_dropped;
+        pending = false;
+    }
+}
+
+void Profiler::end_frame()
+{
+    add_cpu(ProfileMetric::CPU_FRAME, Clock::now() - m_frame_start);
+
+    if (m_samples.size() >= m_samples.capacity() / 2)
+        collect();
+}
+
+void Profiler::begin_gpu(ProfileMetric metric)
+{
+    if (m_gpu_active)
+        end_gpu();
+
+    m_gpu_metric = metric;
+    m_gpu_active = true;
+    glBeginQuery(GL_TIME_ELAPSED, query(m_slot, metric));
+}
+
+void Profiler::end_gpu()
+{
+    if (!m_gpu_active)
+        return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    m_gpu_active = false;
+    m_pending[m_slot][static_cast<std::size_t>(m_gpu_metric)
+                      - static_cast<std::size_t>(ProfileMetric::GPU_CLEAR)]
+        = true;
+}
+
+void Profiler::add_cpu(ProfileMetric metric, Clock::duration duration)
+{
+    push(metric, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     duration).count());
+}
+
+void Profiler::push(ProfileMetric metric, uint64_t nanoseconds)
+{
+    if (!m_samples.push({metric, nanoseconds}))
+        ++m_samples_dropped;
+}
+
+void Profiler::collect()
+{
+    Sample sample;
+    while (m_samples.pop(sample))
+        m_histograms[static_cast<std::size_t>(sample.metric)].add(
+                sample.nanoseconds);
+}
+
+void Profiler::finish()
+{
+    end_gpu();
+    for (unsigned int slot = 0; slot < k_gpu_latency; ++slot)
+        resolve(slot, true);
+    collect();
+}
+
+void Profiler::report(std::ostream& os) const
+{
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::left << std::setw(12) << "Metric" << std::right
+       << std::setw(10) << "Count"
+       << std::setw(10) << "Mean"
+       << std::setw(10) << "p50"
+       << std::setw(10) << "p95"
+       << std::setw(10) << "p99"
+       << std::setw(10) << "Max" << " (ms)\n";
+
+    os << std::fixed << std::setprecision(3);
+    for (std::size_t i = 0; i < m_histograms.size(); ++i)
+    {
+        const Histogram& h = m_histograms[i];
+        if (h.count() == 0)
+            continue;
+
+        os << std::left << std::setw(12) << k_metric_names[i] << std::right
+           << std::setw(10) << h.count()
+           << std::setw(10) << h.mean() * 1e-6
+           << std::setw(10) << h.percentile(0.50) * 1e-6
+           << std::setw(10) << h.percentile(0.95) * 1e-6
+           << std::setw(10) << h.percentile(0.99) * 1e-6
+           << std::setw(10) << h.max() * 1e-6 << '\n';
+    }
+
+    if (m_gpu_dropped)
+        os << "GPU samples dropped: " << m_gpu_dropped << '\n';
+    if (m_samples_dropped)
+        os << "Samples dropped: " << m_samples_dropped << '\n';
+    os.flush();
+    os.flags(flags);
+}
+
+void Profiler::write_csv(std::ostream& os) const
+{
+    std::ios_base::fmtflags flags = os.flags();
+    os << "metric,count,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n"
+       << std::fixed << std::setprecision(6);
+    for (std::size_t i = 0; i < m_histograms.size(); ++i)
+    {
+        const Histogram& h = m_histograms[i];
+        os << k_metric_names[i] << ','
+           << h.count() << ','
+           << h.mean() * 1e-6 << ','
+           << h.percentile(0.50) * 1e-6 << ','
+           << h.percentile(0.95) * 1e-6 << ','
+           << h.percentile(0.99) * 1e-6 << ','
+           << h.max() * 1e-6 << '\n';
+    }
+    os.flush();
+    os.flags(flags);
+}
+
+}; // namespace demonia
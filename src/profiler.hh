@@ -0,0 +1,233 @@
+// CPU and GPU frame-time instrumentation.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_PROFILER_HH_
+#define DEMONIA_SRC_PROFILER_HH_
+
+#include "sample_ring.hh"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Timed stages of a frame. CPU metrics are measured with a steady clock, GPU
+// metrics with GL_TIME_ELAPSED timer queries.
+enum class ProfileMetric
+{
+    CPU_FRAME,
+    CPU_POLL,
+    CPU_SWAP,
+    GPU_CLEAR,
+    GPU_DRAW,
+    COUNT
+};
+
+// Histogram of durations in nanoseconds with logarithmic buckets, each split
+// into linear sub-buckets, giving percentiles within ~6% relative error over
+// the full 64-bit range in constant memory.
+typedef class Histogram
+{
+public:
+    // Records a duration.
+    void add(uint64_t nanoseconds) noexcept;
+
+    // Returns the approximate duration below which the given fraction of
+    // recorded durations lie, or 0 if nothing has been recorded.
+    uint64_t percentile(double fraction) const noexcept;
+
+    inline uint64_t count() const noexcept
+    {
+        return m_count;
+    }
+
+    inline uint64_t max() const noexcept
+    {
+        return m_max;
+    }
+
+    inline double mean() const noexcept
+    {
+        return m_count ? static_cast<double>(m_sum) / m_count : 0.0;
+    }
+
+private:
+    static const unsigned int k_sub_bucket_bits = 4;
+    static const unsigned int k_sub_bucket_count = 1 << k_sub_bucket_bits;
+    static const unsigned int k_bucket_count =
+        (64 - k_sub_bucket_bits + 1) * k_sub_bucket_count;
+
+    // Returns the index of the bucket containing a duration.
+    static unsigned int bucket_index(uint64_t nanoseconds) noexcept;
+
+    // Returns the smallest duration contained by a bucket.
+    static uint64_t bucket_lower_bound(unsigned int index) noexcept;
+
+    std::array<uint64_t, k_bucket_count> m_buckets{};
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_max = 0;
+} Histogram;
+
+// Measures CPU and GPU time spent in each stage of a frame. Samples are
+// queued in a lock-free ring and folded into histograms in batches by
+// collect(), so that recording a sample costs only a few stores. GPU timer
+// query results are read back without blocking up to k_gpu_latency frames
+// after they were issued.
+typedef class Profiler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    typedef struct Sample
+    {
+        ProfileMetric metric;
+        uint64_t nanoseconds;
+    } Sample;
+
+    // Number of frames for which GPU queries are kept in flight before their
+    // results are expected to be available.
+    static const unsigned int k_gpu_latency = 4;
+
+    // Creates the timer queries; requires a current GL context.
+    Profiler();
+
+    // Deletes the timer queries; requires the same GL context to be current.
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // Marks the start of a frame and reads back any available GPU results.
+    void begin_frame();
+
+    // Marks the end of a frame, recording its CPU duration and collecting
+    // queued samples once the ring is half full.
+    void end_frame();
+
+    // Starts timing a GPU stage. GPU stages must not overlap.
+    void begin_gpu(ProfileMetric metric);
+
+    // Stops timing the current GPU stage.
+    void end_gpu();
+
+    // Records the duration of a CPU stage.
+    void add_cpu(ProfileMetric metric, Clock::duration duration);
+
+    // Moves queued samples into the histograms. May be called from a thread
+    // other than the one recording samples, but by only one thread at a time
+    // and not concurrently with end_frame().
+    void collect();
+
+    // Waits for all outstanding GPU queries and collects their results.
+    void finish();
+
+    // Outputs a table of count, mean, p50, p95, p99 and maximum durations in
+    // milliseconds for each metric.
+    void report(std::ostream& os) const;
+
+    // Outputs the same statistics as report() as comma-separated values.
+    void write_csv(std::ostream& os) const;
+
+private:
+    static const std::size_t k_gpu_metric_count =
+        static_cast<std::size_t>(ProfileMetric::COUNT)
+        - static_cast<std::size_t>(ProfileMetric::GPU_CLEAR);
+
+    // Returns the timer query for a GPU metric in a frame slot.
+    inline GLuint& query(unsigned int slot, ProfileMetric metric) noexcept
+    {
+        return m_queries[slot][static_cast<std::size_t>(metric)
+                               - static_cast<std::size_t>(
+                                   ProfileMetric::GPU_CLEAR)];
+    }
+
+    // Reads back the results of available queries in a frame slot; waits for
+    // them if 'wait' is true.
+    void resolve(unsigned int slot, bool wait);
+
+    // Queues a sample, dropping it if the ring is full.
+    void push(ProfileMetric metric, uint64_t nanoseconds);
+
+    SampleRing<Sample, 1024> m_samples;
+    std::array<Histogram, static_cast<std::size_t>(ProfileMetric::COUNT)>
+        m_histograms;
+
+    std::array<std::array<GLuint, k_gpu_metric_count>, k_gpu_latency>
+        m_queries;
+    std::array<std::array<bool, k_gpu_metric_count>, k_gpu_latency>
+        m_pending{};
+    unsigned int m_slot = 0;
+    bool m_gpu_active = false;
+    ProfileMetric m_gpu_metric = ProfileMetric::GPU_CLEAR;
+    uint64_t m_gpu_dropped = 0;
+    uint64_t m_samples_dropped = 0;
+
+    Clock::time_point m_frame_start;
+} Profiler;
+
+// Records the time between its construction and destruction as a metric of
+// a profiler, or does nothing if the profiler is null. GPU metrics are timed
+// with a timer query; CPU metrics with a steady clock.
+typedef class ProfileScope
+{
+public:
+    inline ProfileScope(Profiler* profiler, ProfileMetric metric) noexcept
+            : m_profiler{profiler}, m_metric{metric}
+    {
+        if (!m_profiler)
+            return;
+
+        if (is_gpu_metric(m_metric))
+            m_profiler->begin_gpu(m_metric);
+        else
+            m_start = Profiler::Clock::now();
+    }
+
+    inline ~ProfileScope()
+    {
+        if (!m_profiler)
+            return;
+
+        if (is_gpu_metric(m_metric))
+            m_profiler->end_gpu();
+        else
+            m_profiler->add_cpu(m_metric, Profiler::Clock::now() - m_start);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    static inline bool is_gpu_metric(ProfileMetric metric) noexcept
+    {
+        return metric >= ProfileMetric::GPU_CLEAR;
+    }
+
+    Profiler* m_profiler;
+    ProfileMetric m_metric;
+    Profiler::Clock::time_point m_start;
+} ProfileScope;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_PROFILER_HH_
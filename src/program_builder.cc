@@ -0,0 +1,274 @@
+// Builds batches of shader programs with deferred status checks.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_exception.hh"
+#include "program_builder.hh"
+#include "program_cache.hh"
+#include "shader.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <ios>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+// Interval between completion polls while waiting in finish().
+const std::chrono::microseconds k_poll_interval(200);
+
+// Creates a shader and starts compiling it, without checking its status.
+GLuint submit_shader(const char* src, GLenum type)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &src, NULL);
+    glCompileShader(shader);
+    return shader;
+}
+
+}; // namespace
+
+ProgramBuilder::ProgramBuilder(ProgramCache* cache)
+        : cache{cache}
+{
+    /// Both extensions share their tokens; a thread count of all ones lets
+    /// the driver use as many compiler threads as it supports
+    if (GLEW_KHR_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        parallel = true;
+    }
+    else if (GLEW_ARB_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        parallel = true;
+    }
+}
+
+ProgramBuilder::~ProgramBuilder()
+{
+    release();
+}
+
+std::size_t ProgramBuilder::add(const char* vertex_src,
+                                const char* fragment_src)
+{
+    Job job;
+    job.vertex_src = vertex_src;
+    job.fragment_src = fragment_src;
+    jobs.push_back(job);
+    submitted = false;
+    return jobs.size() - 1;
+}
+
+std::size_t ProgramBuilder::add(const char* vertex_src,
+                                const char* fragment_src,
+                                std::unique_ptr<ShaderProgram>& target,
+                                const char* vertex_file,
+                                const char* fragment_file)
+{
+    std::size_t index = add(vertex_src, fragment_src);
+    jobs[index].target = &target;
+    jobs[index].vertex_file = vertex_file;
+    jobs[index].fragment_file = fragment_file;
+    return index;
+}
+
+void ProgramBuilder::submit()
+{
+    submit_time = Clock::now();
+
+    /// Issue every compile before any link, and every link before any status
+    /// query, so that nothing forces the driver to finish a job early
+    for (Job& job : jobs)
+    {
+        if (job.program)
+            continue;
+
+        job.program = glCreateProgram();
+        if (cache)
+        {
+            job.cache_key = cache->key({job.vertex_src, job.fragment_src});
+            job.cached = cache->load(job.program, job.cache_key);
+            if (job.cached)
+                continue;
+
+            /// glProgramParameteri is only loaded with
+            /// GL_ARB_get_program_binary
+            if (cache->is_supported())
+                glProgramParameteri(job.program,
+                                    GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                    GL_TRUE);
+        }
+
+        job.vertex_shader = submit_shader(job.vertex_src, GL_VERTEX_SHADER);
+        job.fragment_shader = submit_shader(job.fragment_src,
+                                            GL_FRAGMENT_SHADER);
+    }
+
+    for (Job& job : jobs)
+    {
+        if (job.cached || !job.vertex_shader)
+            continue;
+
+        glAttachShader(job.program, job.vertex_shader);
+        glAttachShader(job.program, job.fragment_shader);
+        glLinkProgram(job.program);
+    }
+
+    submitted = true;
+}
+
+bool ProgramBuilder::is_complete() const
+{
+    if (!parallel)
+        return true;
+
+    for (const Job& job : jobs)
+    {
+        if (job.cached)
+            continue;
+
+        GLint complete = GL_FALSE;
+        glGetProgramiv(job.program, GL_COMPLETION_STATUS_KHR, &complete);
+        if (!complete)
+            return false;
+    }
+
+    return true;
+}
+
+void ProgramBuilder::check(const Job& job)
+{
+    GLint success = GL_FALSE;
+    glGetProgramiv(job.program, GL_LINK_STATUS, &success);
+    if (success)
+        return;
+
+    /// A failed link is reported as the compile failure which caused it, if
+    /// any
+    char info_log[GL_INFO_LOG_LENGTH];
+    for (auto [shader, type] : {std::pair{job.vertex_shader, GL_VERTEX_SHADER},
+                                std::pair{job.fragment_shader,
+                                          GL_FRAGMENT_SHADER}})
+    {
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(shader, GL_INFO_LOG_LENGTH, NULL, info_log);
+            throw ShaderCompileException(info_log, type);
+        }
+    }
+
+    glGetProgramInfoLog(job.program, GL_INFO_LOG_LENGTH, NULL, info_log);
+    throw ProgramLinkException(info_log);
+}
+
+std::vector<std::unique_ptr<ShaderProgram>> ProgramBuilder::finish()
+{
+    if (!submitted)
+        submit();
+
+    while (!is_complete())
+        std::this_thread::sleep_for(k_poll_interval);
+
+    try
+    {
+        for (const Job& job : jobs)
+        {
+            if (!job.cached)
+                check(job);
+        }
+    }
+    catch (GlException&)
+    {
+        release();
+        throw;
+    }
+
+    build_time = Clock::now() - submit_time;
+
+    std::size_t compiled = 0;
+    for (const Job& job : jobs)
+        compiled += !job.cached;
+
+    std::vector<std::unique_ptr<ShaderProgram>> programs;
+    programs.reserve(jobs.size());
+    for (Job& job : jobs)
+    {
+        if (!job.cached)
+        {
+            glDetachShader(job.program, job.vertex_shader);
+            glDetachShader(job.program, job.fragment_shader);
+            glDeleteShader(job.vertex_shader);
+            glDeleteShader(job.fragment_shader);
+            job.vertex_shader = job.fragment_shader = 0;
+
+            /// Attribute an equal share of the batch to each compiled program
+            if (cache)
+                cache->store(job.program, job.cache_key,
+                             build_time / compiled);
+        }
+
+        GLuint program = job.program;
+        job.program = 0;
+        programs.emplace_back(new ShaderProgram(program));
+        if (job.target)
+            *job.target = std::move(programs.back());
+        if (job.target && job.vertex_file && job.fragment_file)
+            sources.push_back({job.vertex_file, job.fragment_file,
+                               job.target});
+    }
+
+    built += jobs.size();
+    jobs.clear();
+    submitted = false;
+    return programs;
+}
+
+void ProgramBuilder::release() noexcept
+{
+    for (Job& job : jobs)
+    {
+        glDeleteShader(job.vertex_shader);
+        glDeleteShader(job.fragment_shader);
+        glDeleteProgram(job.program);
+        job.vertex_shader = job.fragment_shader = job.program = 0;
+    }
+}
+
+void ProgramBuilder::report(std::ostream& os) const
+{
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3)
+       << "Programs built: " << built << " in "
+       << std::chrono::duration<double, std::milli>(build_time).count()
+       << " ms (parallel compile "
+       << (parallel ? "available" : "unavailable") << ")" << std::endl;
+    os.flags(flags);
+}
+
+}; // namespace demonia
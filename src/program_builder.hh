@@ -0,0 +1,137 @@
+// Builds batches of shader programs with deferred status checks.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_PROGRAM_BUILDER_HH_
+#define DEMONIA_SRC_PROGRAM_BUILDER_HH_
+
+#include "program_cache.hh"
+#include "shader.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Compiles and links a batch of shader programs without waiting on each one.
+// All shaders are compiled and all programs linked before any status is
+// queried, so drivers with background compiler threads can work on them
+// concurrently; with GL_KHR_parallel_shader_compile or
+// GL_ARB_parallel_shader_compile, completion can also be polled without
+// blocking.
+typedef class ProgramBuilder
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Creates a builder, loading and storing binaries through a program cache
+    // if one is given.
+    explicit ProgramBuilder(ProgramCache* cache = nullptr);
+
+    // Deletes the GL objects of any programs which were not finished.
+    ~ProgramBuilder();
+
+    ProgramBuilder(const ProgramBuilder&) = delete;
+    ProgramBuilder& operator=(const ProgramBuilder&) = delete;
+
+    // Queues a program of a vertex and fragment shader; returns its index in
+    // the result of finish(). The sources must outlive the builder.
+    std::size_t add(const char* vertex_src, const char* fragment_src);
+
+    // Queues a program which finish() moves into 'target' rather than
+    // returning, leaving a null entry at its index. The target must outlive
+    // the call to finish(). If the names of the files the sources were read
+    // from are given, relative to the shader directory, the finished program
+    // is listed by get_sources() for hot-reload; the names must outlive the
+    // builder.
+    std::size_t add(const char* vertex_src, const char* fragment_src,
+                    std::unique_ptr<ShaderProgram>& target,
+                    const char* vertex_file = nullptr,
+                    const char* fragment_file = nullptr);
+
+    // Loads cached programs and starts compiling and linking the rest.
+    void submit();
+
+    // Returns whether every submitted program has finished compiling and
+    // linking. Without a parallel compile extension, always true, as the
+    // driver blocks in finish() instead.
+    bool is_complete() const;
+
+    // Waits for every submitted program, submitting first if needed, and
+    // returns them in the order they were added. If any shader fails to
+    // compile, throws a ShaderCompileException; if any program fails to link,
+    // throws a ProgramLinkException.
+    std::vector<std::unique_ptr<ShaderProgram>> finish();
+
+    // Outputs the number of programs built and the time taken from
+    // submission to completion.
+    void report(std::ostream& os) const;
+
+    // Shader files and target of a finished program.
+    typedef struct Source
+    {
+        const char* vertex_file;
+        const char* fragment_file;
+        std::unique_ptr<ShaderProgram>* target;
+    } Source;
+
+    // Returns the sources of every finished program which was added with its
+    // file names.
+    inline const std::vector<Source>& get_sources() const noexcept
+    {
+        return sources;
+    }
+
+private:
+    typedef struct Job
+    {
+        const char* vertex_src;
+        const char* fragment_src;
+        std::unique_ptr<ShaderProgram>* target = nullptr;
+        const char* vertex_file = nullptr;
+        const char* fragment_file = nullptr;
+        uint64_t cache_key = 0;
+        bool cached = false;
+        GLuint program = 0;
+        GLuint vertex_shader = 0;
+        GLuint fragment_shader = 0;
+    } Job;
+
+    // Checks the status of a job's program, throwing if it failed.
+    static void check(const Job& job);
+
+    // Deletes the GL objects of every job.
+    void release() noexcept;
+
+    ProgramCache* cache;
+    std::vector<Job> jobs;
+    std::vector<Source> sources;
+    bool submitted = false;
+    bool parallel = false;
+    Clock::time_point submit_time;
+    Clock::duration build_time{0};
+    std::size_t built = 0;
+} ProgramBuilder;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_PROGRAM_BUILDER_HH_
@@ -0,0 +1,237 @@
+// On-disk cache of linked program binaries.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "hash.hh"
+#include "program_cache.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <ios>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+const char k_magic[4] = {'D', 'M', 'P', 'B'};
+const uint32_t k_format_version = 1;
+
+// Header preceding the binary in a cache entry.
+typedef struct EntryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;        // Binary format reported by the driver
+    uint32_t length;        // Binary length in bytes
+    int64_t compile_time;   // Nanoseconds taken to compile and link
+} EntryHeader;
+
+// Folds a string, including its terminator, into a 64-bit FNV-1a hash.
+uint64_t hash_string(uint64_t hash, const char* str) noexcept
+{
+    if (!str)
+        str = "";
+    return fnv1a(str, std::strlen(str) + 1, hash);
+}
+
+}; // namespace
+
+ProgramCache::ProgramCache(const std::string& directory)
+        : directory{directory}
+{
+    driver_hash = Fnv1a<uint64_t>::k_offset;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+        driver_hash = hash_string(driver_hash, reinterpret_cast<const char*>(
+                                      glGetString(name)));
+
+    GLint format_count = 0;
+    if (GLEW_ARB_get_program_binary)
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    supported = format_count > 0 && !error;
+}
+
+std::string ProgramCache::default_directory()
+{
+    const char* xdg_cache = std::getenv("XDG_CACHE_HOME");
+    if (xdg_cache && *xdg_cache)
+        return std::string(xdg_cache) + "/demonia";
+
+    const char* home = std::getenv("HOME");
+    return std::string(home ? home : ".") + "/.cache/demonia";
+}
+
+uint64_t ProgramCache::key(std::initializer_list<const char*> sources) const
+    noexcept
+{
+    uint64_t hash = driver_hash;
+    for (const char* src : sources)
+        hash = hash_string(hash, src);
+    return hash;
+}
+
+std::string ProgramCache::path(uint64_t key) const
+{
+    std::ostringstream name;
+    name << directory << '/' << std::hex << std::setw(16) << std::setfill('0')
+         << key << ".bin";
+    return name.str();
+}
+
+bool ProgramCache::load(GLuint program, uint64_t key)
+{
+    if (!supported)
+    {
+        ++misses;
+        return false;
+    }
+
+    Clock::time_point start = Clock::now();
+    std::string entry_path = path(key);
+    std::ifstream file(entry_path, std::ios::binary);
+
+    EntryHeader header;
+    std::vector<char> binary;
+    bool valid = false;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        && std::memcmp(header.magic, k_magic, sizeof(k_magic)) == 0
+        && header.version == k_format_version && header.key == key)
+    {
+        /// Check the length against the file before allocating, so that a
+        /// corrupt entry cannot make us allocate up to 4 GiB
+        std::streamoff binary_start = file.tellg();
+        file.seekg(0, std::ios::end);
+        if (file.tellg() - binary_start == header.length)
+        {
+            file.seekg(binary_start);
+            binary.resize(header.length);
+            valid = static_cast<bool>(file.read(binary.data(),
+                                                binary.size()));
+        }
+    }
+    file.close();
+
+    if (valid)
+    {
+        glProgramBinary(program, header.format, binary.data(), binary.size());
+
+        /// The driver rejects binaries from other builds or hardware by
+        /// failing the link
+        GLint success = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        valid = success == GL_TRUE;
+    }
+
+    if (!valid)
+    {
+        std::remove(entry_path.c_str());
+        ++misses;
+        return false;
+    }
+
+    ++hits;
+    time_saved += std::chrono::nanoseconds(header.compile_time)
+                  - (Clock::now() - start);
+    return true;
+}
+
+void ProgramCache::store(GLuint program, uint64_t key,
+                         Clock::duration compile_time)
+{
+    if (!supported)
+        return;
+
+    EntryHeader header;
+    std::memcpy(header.magic, k_magic, sizeof(k_magic));
+    header.version = k_format_version;
+    header.key = key;
+    header.compile_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            compile_time).count();
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, NULL, &format, binary.data());
+    header.format = format;
+    header.length = length;
+
+    /// Write to a temporary file unique to this process and store, and
+    /// rename it so that concurrent runs never read a partial entry nor
+    /// write into the same temporary file
+    static std::atomic<unsigned int> temp_count{0};
+    std::string entry_path = path(key);
+    std::string temp_path = entry_path + "." + std::to_string(getpid()) + "."
+                            + std::to_string(temp_count++) + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), binary.size());
+        if (!file)
+        {
+            file.close();
+            std::remove(temp_path.c_str());
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, entry_path, error);
+    if (error)
+        std::remove(temp_path.c_str());
+}
+
+void ProgramCache::report(std::ostream& os) const
+{
+    unsigned int total = hits + misses;
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1)
+       << "Program cache: " << hits << " hits, " << misses << " misses ("
+       << (total ? 100.0 * hits / total : 0.0) << "% hit rate), "
+       << std::setprecision(3)
+       << std::chrono::duration<double, std::milli>(time_saved).count()
+       << " ms saved";
+    if (!supported)
+        os << " (program binaries unsupported)";
+    os << std::endl;
+    os.flags(flags);
+}
+
+}; // namespace demonia
@@ -0,0 +1,87 @@
+// On-disk cache of linked program binaries.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_PROGRAM_CACHE_HH_
+#define DEMONIA_SRC_PROGRAM_CACHE_HH_
+
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Stores linked program binaries in a directory, keyed by a hash of their
+// sources and the GL vendor, renderer and version, so that later runs can
+// skip compilation and linking. Requires GL_ARB_get_program_binary and at
+// least one binary format; otherwise every lookup misses and nothing is
+// stored.
+typedef class ProgramCache
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Uses the given cache directory, creating it if needed, for the driver
+    // of the current GL context.
+    explicit ProgramCache(const std::string& directory);
+
+    // Returns the default cache directory: $XDG_CACHE_HOME/demonia, or
+    // ~/.cache/demonia.
+    static std::string default_directory();
+
+    // Returns whether program binaries can be retrieved and loaded.
+    inline bool is_supported() const noexcept
+    {
+        return supported;
+    }
+
+    // Returns the key of a program linked from the given sources.
+    uint64_t key(std::initializer_list<const char*> sources) const noexcept;
+
+    // Loads a cached binary into a program. Returns true if the program was
+    // linked successfully from the binary; otherwise the program must be
+    // compiled and linked from source, and the stale entry is removed.
+    bool load(GLuint program, uint64_t key);
+
+    // Stores the binary of a program linked from source after a miss,
+    // recording the time taken to compile and link it as the cost a later hit
+    // saves. The program should have been linked with
+    // GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+    void store(GLuint program, uint64_t key, Clock::duration compile_time);
+
+    // Outputs the number of hits and misses, hit rate and the startup time
+    // saved by hits.
+    void report(std::ostream& os) const;
+
+private:
+    // Returns the path of the entry for a key.
+    std::string path(uint64_t key) const;
+
+    std::string directory;
+    uint64_t driver_hash;
+    bool supported = false;
+    unsigned int hits = 0;
+    unsigned int misses = 0;
+    Clock::duration time_saved{0};
+} ProgramCache;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_PROGRAM_CACHE_HH_
@@ -0,0 +1,164 @@
+// Scene of many small draws submitted through a render queue.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_state.hh"
+#include "program_builder.hh"
+#include "queue_scene.hh"
+#include "render_queue.hh"
+#include "shader.hh"
+#include "vertices.hh"
+
+#include <algorithm>
+#include <ostream>
+#include <random>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+const char* vertex_shader_src =
+#include "shaders/color.vert"
+;
+
+const char* fragment_shader_src =
+#include "shaders/color.frag"
+;
+
+const char* vertex_shader_file = "color.vert";
+const char* fragment_shader_file = "color.frag";
+
+}; // namespace
+
+QueueScene::QueueScene(bool sorted)
+        : queue(sorted)
+{
+}
+
+QueueScene::~QueueScene()
+{
+    GlState::current().delete_vertex_arrays(2, vaos);
+    GlState::current().delete_buffers(1, &ebo);
+    GlState::current().delete_buffers(2, vbos);
+}
+
+void QueueScene::load(ProgramBuilder& programs)
+{
+    typedef Vertices<Position, Color> Mesh;
+
+    programs.add(vertex_shader_src, fragment_shader_src, program,
+                 vertex_shader_file, fragment_shader_file);
+
+    // Corners of each quad: two triangles of the unindexed mesh, or the
+    // four vertices of the indexed mesh
+    const float step = 2.0f / k_grid_size;
+    const float unindexed_corners[6][2] = {{0, 0}, {1, 0}, {1, 1},
+                                           {0, 0}, {1, 1}, {0, 1}};
+    const float indexed_corners[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+
+    std::vector<Mesh::Vertex> unindexed;
+    std::vector<Mesh::Vertex> indexed;
+    for (unsigned int row = 0; row < k_grid_size; ++row)
+    {
+        for (unsigned int column = 0; column < k_grid_size; ++column)
+        {
+            bool is_indexed = (row + column) % 2;
+            std::vector<Mesh::Vertex>& mesh = is_indexed ? indexed
+                                                         : unindexed;
+            GLint first = mesh.size();
+            Color color({static_cast<float>(column) / k_grid_size,
+                         static_cast<float>(row) / k_grid_size,
+                         is_indexed ? 1.0f : 0.25f});
+            auto add_corner = [&](const float corner[2])
+                {
+                    mesh.emplace_back(
+                            Position({-1.0f + (column + corner[0]) * step,
+                                      -1.0f + (row + corner[1]) * step,
+                                      0.0f}),
+                            color);
+                };
+
+            DrawCommand draw{};
+            draw.mode = GL_TRIANGLES;
+            if (is_indexed)
+            {
+                for (const float* corner : indexed_corners)
+                    add_corner(corner);
+                draw.first = 0;
+                draw.count = 6;
+                draw.base_vertex = first;
+            }
+            else
+            {
+                for (const float* corner : unindexed_corners)
+                    add_corner(corner);
+                draw.first = first;
+                draw.count = 6;
+            }
+            draw.vao = is_indexed ? 1 : 0; // Resolved below
+            commands.push_back(draw);
+        }
+    }
+
+    Mesh unindexed_mesh(std::move(unindexed));
+    Mesh indexed_mesh(std::move(indexed), {0, 1, 2, 0, 2, 3});
+    glGenBuffers(2, vbos);
+    glGenBuffers(1, &ebo);
+    glGenVertexArrays(2, vaos);
+    unindexed_mesh.use(vaos[0], vbos[0]);
+    indexed_mesh.use(vaos[1], vbos[1], ebo);
+
+    GLenum index_type = indexed_mesh.get_indices().get_type();
+    std::mt19937 random(0);
+    std::shuffle(commands.begin(), commands.end(), random);
+    for (DrawCommand& draw : commands)
+    {
+        bool is_indexed = draw.vao == 1;
+        draw.vao = vaos[is_indexed];
+        draw.index_type = is_indexed ? index_type : 0;
+    }
+}
+
+void QueueScene::prepare()
+{
+    /// Seeded afresh so that the keys are the same when called again
+    std::mt19937 random(0);
+    std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+    for (DrawCommand& draw : commands)
+    {
+        draw.program = program->get_id();
+        draw.key = RenderQueue::make_key(0, draw.program, draw.vao,
+                                         draw.material, depth(random));
+    }
+}
+
+void QueueScene::draw(double time)
+{
+    for (const DrawCommand& command : commands)
+        queue.submit(command);
+    queue.flush();
+}
+
+void QueueScene::report(std::ostream& os) const
+{
+    queue.report(os);
+}
+
+}; // namespace demonia
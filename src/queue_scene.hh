@@ -0,0 +1,70 @@
+// Scene of many small draws submitted through a render queue.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_QUEUE_SCENE_HH_
+#define DEMONIA_SRC_QUEUE_SCENE_HH_
+
+#include "program_builder.hh"
+#include "render_queue.hh"
+#include "scene.hh"
+#include "shader.hh"
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Draws a grid of k_grid_size² quads covering the viewport, each submitted
+// to a render queue as its own draw in a shuffled order. Alternate quads
+// come from an unindexed mesh and from an indexed mesh which draws every
+// quad from the same six indices with a base vertex, so that a sorted queue
+// merges them into one multi-draw call per mesh.
+typedef class QueueScene : public Scene
+{
+public:
+    // Number of quads along each side of the grid.
+    static const unsigned int k_grid_size = 64;
+
+    // Creates the scene, sorting the queue unless sorted is false.
+    explicit QueueScene(bool sorted = true);
+
+    ~QueueScene() override;
+
+    void load(ProgramBuilder& programs) override;
+
+    void prepare() override;
+
+    void draw(double time) override;
+
+    // Outputs the draws submitted and issued per frame.
+    void report(std::ostream& os) const override;
+
+private:
+    RenderQueue queue;
+    std::unique_ptr<ShaderProgram> program;
+    CommandList commands; // In submission order
+    GLuint vbos[2] = {};
+    GLuint ebo = 0;
+    GLuint vaos[2] = {};
+} QueueScene;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_QUEUE_SCENE_HH_
@@ -0,0 +1,223 @@
+// Queue of draw calls sorted by state and merged before issue.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_state.hh"
+#include "render_queue.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ios>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+// Widths of the fields of a sort key, from the most significant.
+const unsigned int k_pass_bits = 4;
+const unsigned int k_program_bits = 12;
+const unsigned int k_vao_bits = 16;
+const unsigned int k_material_bits = 16;
+const unsigned int k_depth_bits = 16;
+
+static_assert(k_pass_bits + k_program_bits + k_vao_bits + k_material_bits
+                  + k_depth_bits == 64,
+              "sort key fields must fill 64 bits");
+
+inline uint64_t field(uint64_t value, unsigned int bits, unsigned int shift)
+    noexcept
+{
+    return (value & ((uint64_t{1} << bits) - 1)) << shift;
+}
+
+// Returns whether two draws can be issued in one call.
+inline bool compatible(const DrawCommand& a, const DrawCommand& b) noexcept
+{
+    return a.program == b.program && a.vao == b.vao
+           && a.material == b.material && a.mode == b.mode
+           && a.index_type == b.index_type;
+}
+
+}; // namespace
+
+uint64_t RenderQueue::make_key(unsigned int pass, GLuint program, GLuint vao,
+                               uint16_t material, float depth,
+                               bool back_to_front) noexcept
+{
+    depth = depth < 0.0f ? 0.0f : depth > 1.0f ? 1.0f : depth;
+    uint64_t quantized = depth * ((1 << k_depth_bits) - 1) + 0.5f;
+    if (back_to_front)
+        quantized = ((1 << k_depth_bits) - 1) - quantized;
+
+    unsigned int shift = 64;
+    uint64_t key = field(pass, k_pass_bits, shift -= k_pass_bits);
+    key |= field(program, k_program_bits, shift -= k_program_bits);
+    key |= field(vao, k_vao_bits, shift -= k_vao_bits);
+    key |= field(material, k_material_bits, shift -= k_material_bits);
+    key |= field(quantized, k_depth_bits, shift -= k_depth_bits);
+    return key;
+}
+
+RenderQueue::RenderQueue(bool sorted)
+        : m_sorting{sorted}
+{
+}
+
+void RenderQueue::flush(const MaterialBinder& bind_material)
+{
+    ++m_flushes;
+    m_submitted += m_commands.size();
+    if (m_commands.empty())
+        return;
+
+    m_order.resize(m_commands.size());
+    for (size_t i = 0; i < m_commands.size(); ++i)
+        m_order[i] = {m_commands[i].key, static_cast<uint32_t>(i)};
+    if (m_sorting)
+        sort();
+
+    // Issue each run of compatible draws, changing only the state which
+    // differs from the previous run
+    const DrawCommand* last = nullptr;
+    size_t begin = 0;
+    for (size_t i = 1; i <= m_order.size(); ++i)
+    {
+        const DrawCommand& first = m_commands[m_order[begin].index];
+        if (i < m_order.size()
+            && compatible(first, m_commands[m_order[i].index]))
+            continue;
+
+        if (!last || last->program != first.program)
+        {
+            GlState::current().use_program(first.program);
+            ++m_program_changes;
+        }
+        if (!last || last->vao != first.vao)
+        {
+            GlState::current().bind_vertex_array(first.vao);
+            ++m_vao_changes;
+        }
+        if (bind_material && (!last || last->material != first.material))
+            bind_material(first.material);
+
+        issue(begin, i);
+        last = &first;
+        begin = i;
+    }
+
+    m_commands.clear();
+}
+
+void RenderQueue::sort()
+{
+    const unsigned int digit_bits = 8;
+    const size_t bucket_count = size_t{1} << digit_bits;
+
+    m_scratch.resize(m_order.size());
+    for (unsigned int shift = 0; shift < 64; shift += digit_bits)
+    {
+        std::array<size_t, bucket_count> counts{};
+        for (const SortEntry& entry : m_order)
+            ++counts[(entry.key >> shift) & (bucket_count - 1)];
+
+        // Keys sharing this digit are already in order
+        size_t digit = (m_order.front().key >> shift) & (bucket_count - 1);
+        if (counts[digit] == m_order.size())
+            continue;
+
+        size_t offset = 0;
+        for (size_t& count : counts)
+        {
+            size_t next = offset + count;
+            count = offset;
+            offset = next;
+        }
+        for (const SortEntry& entry : m_order)
+            m_scratch[counts[(entry.key >> shift) & (bucket_count - 1)]++] =
+                entry;
+        m_order.swap(m_scratch);
+    }
+}
+
+void RenderQueue::issue(size_t begin, size_t end)
+{
+    const DrawCommand& first = m_commands[m_order[begin].index];
+    ++m_issued;
+
+    if (end - begin == 1)
+    {
+        if (first.index_type == 0)
+            glDrawArrays(first.mode, first.first, first.count);
+        else
+            glDrawElementsBaseVertex(first.mode, first.count,
+                                     first.index_type,
+                                     reinterpret_cast<const void*>(
+                                         static_cast<intptr_t>(first.first)),
+                                     first.base_vertex);
+        return;
+    }
+
+    m_counts.clear();
+    if (first.index_type == 0)
+    {
+        m_firsts.clear();
+        for (size_t i = begin; i < end; ++i)
+        {
+            const DrawCommand& command = m_commands[m_order[i].index];
+            m_firsts.push_back(command.first);
+            m_counts.push_back(command.count);
+        }
+        glMultiDrawArrays(first.mode, m_firsts.data(), m_counts.data(),
+                          m_counts.size());
+        return;
+    }
+
+    m_offsets.clear();
+    m_base_vertices.clear();
+    for (size_t i = begin; i < end; ++i)
+    {
+        const DrawCommand& command = m_commands[m_order[i].index];
+        m_counts.push_back(command.count);
+        m_offsets.push_back(reinterpret_cast<const void*>(
+                static_cast<intptr_t>(command.first)));
+        m_base_vertices.push_back(command.base_vertex);
+    }
+    glMultiDrawElementsBaseVertex(first.mode, m_counts.data(),
+                                  first.index_type, m_offsets.data(),
+                                  m_counts.size(), m_base_vertices.data());
+}
+
+void RenderQueue::report(std::ostream& os) const
+{
+    double flushes = m_flushes ? m_flushes : 1;
+
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1)
+       << "Draws per frame: " << m_submitted / flushes << " submitted, "
+       << m_issued / flushes << " issued ("
+       << m_program_changes / flushes << " program and "
+       << m_vao_changes / flushes << " vertex array changes)" << std::endl;
+    os.flags(flags);
+}
+
+}; // namespace demonia
@@ -0,0 +1,123 @@
+// Queue of draw calls sorted by state and merged before issue.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_RENDER_QUEUE_HH_
+#define DEMONIA_SRC_RENDER_QUEUE_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Draw call submitted to a RenderQueue.
+typedef struct DrawCommand
+{
+    uint64_t key;      // From RenderQueue::make_key()
+    GLuint program;
+    GLuint vao;
+    uint16_t material; // Passed to the material binder when it changes
+    GLenum mode;
+    GLenum index_type; // 0 if not indexed
+    GLint first;       // First vertex, or byte offset of the first index
+    GLsizei count;
+    GLint base_vertex; // Added to each index
+} DrawCommand;
+
+// Draws recorded by one thread, to be submitted to a RenderQueue on the
+// render thread.
+typedef std::vector<DrawCommand> CommandList;
+
+// Collects the draw calls of a frame, sorts them by a 64-bit key so that
+// draws sharing state are adjacent, and issues each run of draws sharing a
+// program, Vertex Array Object, material, mode and index type as a single
+// glMultiDrawArrays or glMultiDrawElementsBaseVertex call.
+typedef class RenderQueue
+{
+public:
+    typedef std::function<void(uint16_t material)> MaterialBinder;
+
+    // Returns a sort key ordering draws by pass, then program, Vertex Array
+    // Object and material, then depth in [0, 1], front to back unless
+    // back_to_front, as for blended passes. Names are truncated to the
+    // width of their fields.
+    static uint64_t make_key(unsigned int pass, GLuint program, GLuint vao,
+                             uint16_t material, float depth,
+                             bool back_to_front = false) noexcept;
+
+    // Creates a queue which sorts its draws unless sorted is false, in which
+    // case only draws adjacent in submission order are merged.
+    explicit RenderQueue(bool sorted = true);
+
+    inline void submit(const DrawCommand& command)
+    {
+        m_commands.push_back(command);
+    }
+
+    inline void submit(const CommandList& commands)
+    {
+        m_commands.insert(m_commands.end(), commands.begin(), commands.end());
+    }
+
+    // Sorts, merges and issues the submitted draws, then empties the queue.
+    // The material binder is called before the first draw of each material.
+    // Leaves the last program and Vertex Array Object bound.
+    void flush(const MaterialBinder& bind_material = nullptr);
+
+    // Outputs the mean draws submitted and issued, and state changes, per
+    // flush.
+    void report(std::ostream& os) const;
+
+private:
+    typedef struct SortEntry
+    {
+        uint64_t key;
+        uint32_t index;
+    } SortEntry;
+
+    // Sorts m_order by key with a least significant digit radix sort,
+    // skipping digits shared by every key.
+    void sort();
+
+    // Issues the draws of m_order in [begin, end), which share state.
+    void issue(size_t begin, size_t end);
+
+    bool m_sorting;
+    CommandList m_commands;
+    std::vector<SortEntry> m_order;
+    std::vector<SortEntry> m_scratch;
+
+    // Arguments of multi-draw calls
+    std::vector<GLint> m_firsts;
+    std::vector<GLsizei> m_counts;
+    std::vector<const void*> m_offsets;
+    std::vector<GLint> m_base_vertices;
+
+    uint64_t m_flushes = 0;
+    uint64_t m_submitted = 0;
+    uint64_t m_issued = 0;
+    uint64_t m_program_changes = 0;
+    uint64_t m_vao_changes = 0;
+} RenderQueue;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_RENDER_QUEUE_HH_
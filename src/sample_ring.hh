@@ -0,0 +1,85 @@
+// Lock-free single-producer, single-consumer ring buffer.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_SAMPLE_RING_HH_
+#define DEMONIA_SRC_SAMPLE_RING_HH_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace demonia
+{
+
+// Fixed-capacity FIFO queue which may be pushed to by one thread and popped
+// from by another without locking. Capacity must be a power of two.
+template<typename T, std::size_t Capacity>
+class SampleRing
+{
+public:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "ring capacity must be a power of two");
+
+    // Appends a value; returns false without blocking if the ring is full.
+    // Must only be called by the producer thread.
+    bool push(const T& value) noexcept
+    {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        m_data[head & (Capacity - 1)] = value;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Removes the oldest value into 'value'; returns false if the ring is
+    // empty. Must only be called by the consumer thread.
+    bool pop(T& value) noexcept
+    {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (m_head.load(std::memory_order_acquire) == tail)
+            return false;
+
+        value = m_data[tail & (Capacity - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns the number of values in the ring. Exact only when called from
+    // the producer or consumer thread while the other is idle.
+    std::size_t size() const noexcept
+    {
+        return m_head.load(std::memory_order_acquire)
+               - m_tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr std::size_t capacity() noexcept
+    {
+        return Capacity;
+    }
+
+private:
+    /// Indices increase monotonically and are kept on separate cache lines
+    /// so that the producer and consumer do not contend
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+    alignas(64) std::array<T, Capacity> m_data;
+};
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_SAMPLE_RING_HH_
@@ -0,0 +1,110 @@
+// Sets of objects drawn by the GL handler.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "bodies_scene.hh"
+#include "color_stream_scene.hh"
+#include "frustum_scene.hh"
+#include "instanced_scene.hh"
+#include "job_scene.hh"
+#include "mesh_scene.hh"
+#include "options.hh"
+#include "queue_scene.hh"
+#include "scene.hh"
+#include "sprite_scene.hh"
+#include "streamed_mesh_scene.hh"
+#include "strip_grid_scene.hh"
+#include "textured_scene.hh"
+#include "triangle_scene.hh"
+#include "vertices.hh"
+
+#include <string>
+#include <vector>
+
+namespace demonia
+{
+
+const std::vector<std::string>& scene_names()
+{
+    static const std::vector<std::string> names{
+        "triangle",
+        "triangle-packed",
+        "stream-interleaved",
+        "stream-separate",
+        "stream-interleaved-ring",
+        "stream-separate-ring",
+        "instanced",
+        "uninstanced",
+        "strips",
+        "queue",
+        "queue-unsorted",
+        "jobs",
+        "bodies",
+        "mesh",
+        "mesh-streamed",
+        "textures",
+        "sprites",
+        "sprites-atlas",
+        "frustum"
+    };
+    return names;
+}
+
+Scene* create_scene(const Options& options)
+{
+    const std::string& name = options.scene;
+    if (name == "triangle")
+        return new TriangleScene();
+    if (name == "triangle-packed")
+        return new TriangleScene(true);
+    if (name == "stream-interleaved")
+        return new ColorStreamScene<InterleavedStorage>();
+    if (name == "stream-separate")
+        return new ColorStreamScene<SeparateStorage>();
+    if (name == "stream-interleaved-ring")
+        return new ColorStreamScene<InterleavedStorage>(true);
+    if (name == "stream-separate-ring")
+        return new ColorStreamScene<SeparateStorage>(true);
+    if (name == "instanced")
+        return new InstancedScene(true);
+    if (name == "uninstanced")
+        return new InstancedScene(false);
+    if (name == "strips")
+        return new StripGridScene();
+    if (name == "queue")
+        return new QueueScene(true);
+    if (name == "queue-unsorted")
+        return new QueueScene(false);
+    if (name == "jobs")
+        return new JobScene();
+    if (name == "bodies")
+        return new BodiesScene();
+    if (name == "mesh")
+        return new MeshScene(options.mesh_path);
+    if (name == "mesh-streamed")
+        return new StreamedMeshScene(options.mesh_path,
+                                     options.stream_budget);
+    if (name == "textures")
+        return new TexturedScene();
+    if (name == "sprites")
+        return new SpriteScene(false);
+    if (name == "sprites-atlas")
+        return new SpriteScene(true);
+    if (name == "frustum")
+        return new FrustumScene();
+    return nullptr;
+}
+
+}; // namespace demonia
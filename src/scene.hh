@@ -0,0 +1,96 @@
+// Sets of objects drawn by the GL handler.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_SCENE_HH_
+#define DEMONIA_SRC_SCENE_HH_
+
+#include "options.hh"
+#include "program_builder.hh"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace demonia
+{
+
+// Set of objects loaded and drawn by the GL handler, which can be selected
+// at runtime to exercise different rendering paths.
+typedef class Scene
+{
+public:
+    virtual ~Scene() = default;
+
+    // Creates the GL objects of the scene and adds its programs to a
+    // builder, which the GL handler finishes in one batch with its own once
+    // load() returns; the programs cannot be used until prepare(). Called
+    // once with the GL context current. Throws a GlException if an object
+    // could not be created.
+    virtual void load(ProgramBuilder& programs) = 0;
+
+    // Sets up state depending on the programs added in load(), such as
+    // constant uniforms, once they have been built. Called with the default
+    // colour program in use, and again whenever hot-reload replaces any of
+    // the programs.
+    virtual void prepare()
+    {
+    }
+
+    // Updates and draws the scene for a frame, given the time in seconds
+    // since the first frame. Scenes drawing with the default program can
+    // rely on it being in use; those with their own program must use it.
+    virtual void draw(double time) = 0;
+
+    // Returns whether the scene changes with the time given to draw(), so
+    // that in on-demand rendering it is redrawn at each animation tick
+    // rather than only when invalidated.
+    virtual bool is_animated() const
+    {
+        return false;
+    }
+
+    // Returns whether the scene is simulated by update() on an update thread
+    // at a fixed time step, separately from draw().
+    virtual bool is_simulated() const
+    {
+        return false;
+    }
+
+    // Advances the simulation by one time step of 'step' seconds, to 'time'
+    // seconds since the first frame. Called on the update thread while
+    // draw() runs on the render thread, so state read by draw() must be
+    // published through a TripleBuffer.
+    virtual void update(double time, double step)
+    {
+    }
+
+    // Outputs statistics specific to the scene.
+    virtual void report(std::ostream& os) const
+    {
+    }
+} Scene;
+
+// Returns the names of the available scenes.
+const std::vector<std::string>& scene_names();
+
+// Creates the scene named by a set of options, or returns null if there is
+// none. The scene must be deleted while the GL context it was loaded in is
+// current.
+Scene* create_scene(const Options& options);
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_SCENE_HH_
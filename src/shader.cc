@@ -15,59 +15,31 @@
 // along with this program. If not, see <https://www.gnu.org/licenses/>.
 
 #include "gl_exception.hh"
+#include "gl_state.hh"
 #include "shader.hh"
 
-#include <cstddef>
-
 #include <GL/glew.h>
 
 namespace demonia
 {
 
-GLuint ShaderProgram::compile_shader(const char* src, GLenum type)
+ShaderProgram::ShaderProgram(GLuint id)
+        : id{id}
 {
-    GLuint shader = glCreateShader(type);
-    glShaderSource(shader, 1, &src, NULL);
-    glCompileShader(shader);
-
-    int success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success)
+    try
     {
-        char info_log[GL_INFO_LOG_LENGTH];
-        glGetShaderInfoLog(shader, GL_INFO_LOG_LENGTH, NULL, info_log);
-        throw ShaderCompileException(info_log, type);
+        uniforms.build(id);
     }
-
-    return shader;
-}
-
-ShaderProgram::ShaderProgram(const char* vertex_src, const char* fragment_src)
-{
-    GLuint vertex_shader = compile_shader(vertex_src, GL_VERTEX_SHADER);
-    GLuint fragment_shader = compile_shader(fragment_src, GL_FRAGMENT_SHADER);
-    id = glCreateProgram();
-    glAttachShader(id, vertex_shader);
-    glAttachShader(id, fragment_shader);
-
-    glLinkProgram(id);
-
-    glDeleteShader(fragment_shader);
-    glDeleteShader(vertex_shader);
-
-    int success;
-    glGetProgramiv(id, GL_LINK_STATUS, &success);
-    if (!success)
+    catch (ProgramLinkException&)
     {
-        char info_log[GL_INFO_LOG_LENGTH];
-        glGetProgramInfoLog(id, GL_INFO_LOG_LENGTH, NULL, info_log);
-        throw ProgramLinkException(info_log);
+        GlState::current().delete_program(id);
+        throw;
     }
 }
 
 ShaderProgram::~ShaderProgram()
 {
-    glDeleteProgram(id);
+    GlState::current().delete_program(id);
 }
 
 }; // namespace demonia
@@ -16,42 +16,64 @@
 #ifndef DEMONIA_SRC_SHADER_HH_
 #define DEMONIA_SRC_SHADER_HH_
 
+#include "gl_state.hh"
+#include "uniform.hh"
+
 #include <GL/glew.h>
 
 namespace demonia
 {
 
-// Creates a portable, compiled and linked shader program.
+// Compiled and linked shader program, created by a ProgramBuilder.
 typedef class ShaderProgram
 {
 public:
-    // Compiles a vertex and fragment shader from their GLSL source code and
-    // links them into a program. If a shader fails to compile, throws a
-    // ShaderCompileException. If linking of shaders into a program fails,
-    // throws a ProgramLinkException.
-    ShaderProgram(const char* vertex_src, const char* fragment_src);
-
     ~ShaderProgram();
 
     // Use/activate the shader program for GL operations.
     inline void use() const noexcept
     {
-        glUseProgram(id);
+        GlState::current().use_program(id);
     }
 
-    // Modifies a uniform value shared between shaders.
+    // Modifies a uniform value shared between shaders. The program must be in
+    // use. The upload is skipped if the value is unchanged. Returns false if
+    // the uniform is not active or its type does not match T; see
+    // UniformTraits for the supported types.
     template<typename T>
-    inline void set_uniform(const char* name, T value) const noexcept
+    inline bool set_uniform(UniformName name, const T& value) noexcept
     {
-        glUniform1i(glGetUniformLocation(id, name), value);
+        return uniforms.set(name, &value, 1);
+    }
+
+    // Modifies the first 'count' elements of a uniform array.
+    template<typename T>
+    inline bool set_uniform(UniformName name, const T* values, GLsizei count)
+        noexcept
+    {
+        return uniforms.set(name, values, count);
+    }
+
+    // Returns the GL name of the program.
+    inline GLuint get_id() const noexcept
+    {
+        return id;
+    }
+
+    // Returns the table of active uniforms reflected at link time.
+    inline const UniformTable& get_uniforms() const noexcept
+    {
+        return uniforms;
     }
 
 private:
-    // Compiles a shader of a given type from its GLSL source code and returns
-    // its identifier.
-    static GLuint compile_shader(const char *src, GLenum type);
+    friend class ProgramBuilder;
+
+    // Takes ownership of a linked program.
+    explicit ShaderProgram(GLuint id);
 
     unsigned int id;
+    UniformTable uniforms;
 } ShaderProgram;
 
 }; // namespace demonia
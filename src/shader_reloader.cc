@@ -0,0 +1,312 @@
+// Recompiles shader programs in the background when their files change.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_exception.hh"
+#include "program_builder.hh"
+#include "shader.hh"
+#include "shader_reloader.hh"
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+// Time to wait after a change for further changes, as editors often save
+// a file in several steps.
+const int k_debounce_ms = 50;
+
+// Throws a std::system_error for the current value of errno.
+[[noreturn]] void throw_errno(const std::string& what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+}; // namespace
+
+ShaderReloader::ShaderReloader(const std::string& directory,
+                               ContextBinder bind_context)
+        : directory{directory}, bind_context{std::move(bind_context)}
+{
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0)
+        throw_errno("inotify_init1");
+
+    /// Editors commonly replace files by renaming a temporary file over them
+    if (inotify_add_watch(inotify_fd, directory.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+    {
+        int error = errno;
+        close(inotify_fd);
+        throw std::system_error(error, std::generic_category(),
+                                "failed to watch '" + directory + "'");
+    }
+
+    stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (stop_fd < 0)
+    {
+        int error = errno;
+        close(inotify_fd);
+        throw std::system_error(error, std::generic_category(), "eventfd");
+    }
+}
+
+ShaderReloader::~ShaderReloader()
+{
+    if (thread.joinable())
+    {
+        uint64_t one = 1;
+        if (write(stop_fd, &one, sizeof(one)) == sizeof(one))
+            thread.join();
+        else
+            thread.detach();
+    }
+
+    /// Programs never taken by the render thread are deleted in its context
+    for (auto& entry : entries)
+    {
+        if (entry->fence)
+            glDeleteSync(entry->fence);
+    }
+
+    close(stop_fd);
+    close(inotify_fd);
+}
+
+std::size_t ShaderReloader::watch(const std::string& vertex_file,
+                                  const std::string& fragment_file)
+{
+    entries.emplace_back(new Entry);
+    entries.back()->vertex_file = vertex_file;
+    entries.back()->fragment_file = fragment_file;
+    return entries.size() - 1;
+}
+
+std::size_t ShaderReloader::watch(const std::string& vertex_file,
+                                  const std::string& fragment_file,
+                                  std::unique_ptr<ShaderProgram>& target)
+{
+    std::size_t index = watch(vertex_file, fragment_file);
+    entries[index]->target = &target;
+    return index;
+}
+
+void ShaderReloader::start()
+{
+    thread = std::thread(&ShaderReloader::run, this);
+}
+
+bool ShaderReloader::update(std::size_t index, ShaderProgram*& program)
+{
+    std::unique_ptr<ShaderProgram> rebuilt = take(*entries[index]);
+    if (!rebuilt)
+        return false;
+
+    delete program;
+    program = rebuilt.release();
+    return true;
+}
+
+bool ShaderReloader::update_targets()
+{
+    bool replaced = false;
+    for (auto& entry : entries)
+    {
+        if (!entry->target)
+            continue;
+
+        std::unique_ptr<ShaderProgram> rebuilt = take(*entry);
+        if (rebuilt)
+        {
+            *entry->target = std::move(rebuilt);
+            replaced = true;
+        }
+    }
+    return replaced;
+}
+
+std::unique_ptr<ShaderProgram> ShaderReloader::take(Entry& entry)
+{
+    if (!entry.ready.load(std::memory_order_acquire))
+        return nullptr;
+
+    std::unique_lock<std::mutex> lock(entry.mutex, std::try_to_lock);
+    if (!lock.owns_lock() || !entry.program)
+        return nullptr;
+
+    /// The background context flushed after the fence, so polling it here
+    /// cannot wait forever
+    GLenum status = glClientWaitSync(entry.fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+        return nullptr;
+
+    glDeleteSync(entry.fence);
+    entry.fence = 0;
+    entry.ready.store(false, std::memory_order_relaxed);
+    return std::move(entry.program);
+}
+
+std::string ShaderReloader::read_source(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file)
+        throw_errno("failed to read '" + path + "'");
+
+    std::string src((std::istreambuf_iterator<char>(file)),
+                    std::istreambuf_iterator<char>());
+
+    static const std::string k_prefix = "R\"\"(";
+    static const std::string k_suffix = ")\"\"";
+    std::string::size_type begin = src.find(k_prefix);
+    std::string::size_type end = src.rfind(k_suffix);
+    if (begin != std::string::npos && end != std::string::npos
+        && end > begin)
+    {
+        begin += k_prefix.size();
+        src = src.substr(begin, end - begin);
+    }
+
+    return src;
+}
+
+void ShaderReloader::rebuild(Entry& entry)
+{
+    std::string vertex_src;
+    std::string fragment_src;
+    std::unique_ptr<ShaderProgram> program;
+    try
+    {
+        vertex_src = read_source(directory + "/" + entry.vertex_file);
+        fragment_src = read_source(directory + "/" + entry.fragment_file);
+
+        ProgramBuilder builder;
+        builder.add(vertex_src.c_str(), fragment_src.c_str());
+        program = std::move(builder.finish().front());
+    }
+    catch (ShaderCompileException& e)
+    {
+        std::cerr << "Failed to reload "
+                  << (e.get_shader_type() == GL_VERTEX_SHADER
+                          ? entry.vertex_file : entry.fragment_file)
+                  << "; keeping the previous program." << std::endl
+                  << e.what();
+        return;
+    }
+    catch (std::exception& e)
+    {
+        std::cerr << "Failed to reload " << entry.vertex_file << " and "
+                  << entry.fragment_file << "; keeping the previous program."
+                  << std::endl << e.what() << std::endl;
+        return;
+    }
+
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    std::lock_guard<std::mutex> lock(entry.mutex);
+    if (entry.fence)
+        glDeleteSync(entry.fence);
+    entry.program = std::move(program);
+    entry.fence = fence;
+    entry.ready.store(true, std::memory_order_release);
+
+    std::cerr << "Reloaded " << entry.vertex_file << " and "
+              << entry.fragment_file << "." << std::endl;
+}
+
+void ShaderReloader::run()
+{
+    bind_context(true);
+
+    pollfd fds[] = {
+        {stop_fd, POLLIN, 0},
+        {inotify_fd, POLLIN, 0}
+    };
+    alignas(inotify_event) char buffer[4096];
+    std::set<std::string> changed;
+
+    while (true)
+    {
+        /// Wait indefinitely for the first change, then briefly for more
+        int timeout = changed.empty() ? -1 : k_debounce_ms;
+        int ready = poll(fds, 2, timeout);
+        if (ready < 0 && errno != EINTR)
+            break;
+        if (fds[0].revents & POLLIN)
+            break;
+
+        if (ready > 0 && (fds[1].revents & POLLIN))
+        {
+            ssize_t length;
+            while ((length = read(inotify_fd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* p = buffer; p < buffer + length;)
+                {
+                    auto event = reinterpret_cast<inotify_event*>(p);
+                    if (event->len)
+                        changed.insert(event->name);
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+            continue;
+        }
+
+        if (ready == 0)
+        {
+            for (auto& entry : entries)
+            {
+                if (changed.count(entry->vertex_file)
+                    || changed.count(entry->fragment_file))
+                    rebuild(*entry);
+            }
+            changed.clear();
+        }
+    }
+
+    /// Unpublished programs are deleted while their context is current
+    for (auto& entry : entries)
+    {
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        entry->program.reset();
+    }
+
+    bind_context(false);
+}
+
+}; // namespace demonia
@@ -0,0 +1,124 @@
+// Recompiles shader programs in the background when their files change.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_SHADER_RELOADER_HH_
+#define DEMONIA_SRC_SHADER_RELOADER_HH_
+
+#include "shader.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Watches shader source files with inotify and recompiles the programs using
+// them on a background thread with its own GL context, which must share
+// objects with the render context. Rebuilt programs are handed over to the
+// render thread between frames once a fence shows they are complete; if a
+// rebuild fails, its errors are logged and the current program is kept.
+typedef class ShaderReloader
+{
+public:
+    // Makes the shared context current on the calling thread if given true,
+    // or releases it if given false.
+    typedef std::function<void(bool)> ContextBinder;
+
+    // Watches files in a directory, binding the shared context on the
+    // background thread through 'bind_context'. If the directory cannot be
+    // watched, throws a std::system_error.
+    ShaderReloader(const std::string& directory, ContextBinder bind_context);
+
+    // Stops the background thread.
+    ~ShaderReloader();
+
+    ShaderReloader(const ShaderReloader&) = delete;
+    ShaderReloader& operator=(const ShaderReloader&) = delete;
+
+    // Registers a program of a vertex and fragment shader, named relative to
+    // the watched directory; returns its index. Must be called before
+    // start().
+    std::size_t watch(const std::string& vertex_file,
+                      const std::string& fragment_file);
+
+    // Registers a program as watch() does, which update_targets() replaces in
+    // 'target'. The target must outlive the reloader.
+    std::size_t watch(const std::string& vertex_file,
+                      const std::string& fragment_file,
+                      std::unique_ptr<ShaderProgram>& target);
+
+    // Starts watching for changes on the background thread.
+    void start();
+
+    // Replaces a program with its rebuilt version if one is complete.
+    // Never blocks. Returns whether the program was replaced, in which case
+    // the previous program has been deleted and the new one must be put in
+    // use. Must be called on the render thread.
+    bool update(std::size_t index, ShaderProgram*& program);
+
+    // Replaces the program in the target of every program registered with one
+    // by its rebuilt version if one is complete, as update() does. Returns
+    // whether any program was replaced. Must be called on the render thread.
+    bool update_targets();
+
+    // Reads a shader source file. Files wrapped in a raw string literal for
+    // embedding with #include are unwrapped. If the file cannot be read,
+    // throws a std::system_error.
+    static std::string read_source(const std::string& path);
+
+private:
+    typedef struct Entry
+    {
+        std::string vertex_file;
+        std::string fragment_file;
+        std::unique_ptr<ShaderProgram>* target = nullptr;
+
+        /// Written by the background thread, taken by the render thread
+        std::mutex mutex;
+        std::atomic<bool> ready{false};
+        std::unique_ptr<ShaderProgram> program;
+        GLsync fence = 0;
+    } Entry;
+
+    // Takes the rebuilt program of an entry if one is complete, or returns
+    // null.
+    std::unique_ptr<ShaderProgram> take(Entry& entry);
+
+    // Body of the background thread.
+    void run();
+
+    // Rebuilds a program and publishes it; logs errors on failure.
+    void rebuild(Entry& entry);
+
+    std::string directory;
+    ContextBinder bind_context;
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::thread thread;
+    int inotify_fd = -1;
+    int stop_fd = -1; // eventfd signalled to stop the thread
+} ShaderReloader;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_SHADER_RELOADER_HH_
@@ -0,0 +1,37 @@
+// GL vertex shader drawing a mesh file coloured by its normals.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+R""(
+#version 330 core
+layout (location = 0) in vec3 viPos;
+layout (location = 1) in vec4 viNormal;
+layout (location = 2) in vec2 viTexCoord;
+uniform vec3 uCenter;
+uniform float uScale;
+uniform float uAngle;
+uniform vec2 uOffset;
+out vec3 voColor;
+
+void main()
+{
+    float c = cos(uAngle);
+    float s = sin(uAngle);
+    mat3 rotation = mat3(c, 0.0, -s, 0.0, 1.0, 0.0, s, 0.0, c);
+    vec3 position = rotation * ((viPos - uCenter) * uScale);
+    gl_Position = vec4(position.xy + uOffset, position.z * 0.5, 1.0);
+    voColor = (rotation * viNormal.xyz) * 0.5 + 0.5;
+}
+)""
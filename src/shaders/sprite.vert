@@ -0,0 +1,29 @@
+// GL vertex shader drawing sprites from an array texture.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+R""(
+#version 330 core
+layout (location = 0) in vec3 viPos;
+layout (location = 1) in vec2 viTexCoord;
+layout (location = 2) in float viLayer;
+out vec3 voTexCoord;
+
+void main()
+{
+    gl_Position = vec4(viPos, 1.0);
+    voTexCoord = vec3(viTexCoord, viLayer);
+}
+)""
@@ -0,0 +1,209 @@
+// Scene drawing sprites with or without a texture atlas.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_state.hh"
+#include "program_builder.hh"
+#include "render_queue.hh"
+#include "shader.hh"
+#include "sprite_scene.hh"
+#include "texture_atlas.hh"
+#include "vertices.hh"
+
+#include <cstdint>
+#include <algorithm>
+#include <iomanip>
+#include <ios>
+#include <ostream>
+#include <random>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+const char* vertex_shader_src =
+#include "shaders/sprite.vert"
+;
+
+const char* fragment_shader_src =
+#include "shaders/sprite.frag"
+;
+
+const char* vertex_shader_file = "sprite.vert";
+const char* fragment_shader_file = "sprite.frag";
+
+typedef Vertices<Position, PackedTexCoord, TexLayer> Sprites;
+
+// Returns the RGBA8 texels of a generated image: a square of a colour picked
+// by its index inside a darker border 2 texels wide.
+std::vector<uint32_t> generate_image(unsigned int index, GLsizei width,
+                                     GLsizei height)
+{
+    uint32_t r = index * 97 % 256;
+    uint32_t g = (index * 57 + 128) % 256;
+    uint32_t b = (index * 31 + 64) % 256;
+    uint32_t fill = 0xff000000u | b << 16 | g << 8 | r;
+    uint32_t border = 0xff000000u | (b >> 1) << 16 | (g >> 1) << 8 | r >> 1;
+
+    std::vector<uint32_t> texels(width * height);
+    for (GLsizei y = 0; y < height; ++y)
+    {
+        for (GLsizei x = 0; x < width; ++x)
+        {
+            bool edge = x < 2 || y < 2 || x >= width - 2 || y >= height - 2;
+            texels[y * width + x] = edge ? border : fill;
+        }
+    }
+    return texels;
+}
+
+}; // namespace
+
+SpriteScene::SpriteScene(bool atlas)
+        : m_atlas{atlas}
+{
+}
+
+SpriteScene::~SpriteScene()
+{
+    GlState::current().delete_vertex_arrays(1, &vao);
+    GlState::current().delete_buffers(1, &vbo);
+}
+
+void SpriteScene::load(ProgramBuilder& programs)
+{
+    programs.add(vertex_shader_src, fragment_shader_src, program,
+                 vertex_shader_file, fragment_shader_file);
+
+    // Generate the images, into one atlas or into an atlas of one image
+    // each
+    std::mt19937 random(0);
+    std::uniform_int_distribution<GLsizei> size(8, 64);
+    std::vector<std::size_t> regions(k_image_count);
+    std::vector<GLsizei> widths(k_image_count);
+    std::vector<GLsizei> heights(k_image_count);
+    for (unsigned int i = 0; i < k_image_count; ++i)
+    {
+        widths[i] = size(random);
+        heights[i] = size(random);
+        std::vector<uint32_t> texels = generate_image(i, widths[i],
+                                                      heights[i]);
+        if (!m_atlas || atlases.empty())
+        {
+            GLsizei layer_size = m_atlas ? 1024
+                : std::max(widths[i], heights[i])
+                  + 2 * TextureAtlas::k_padding;
+            atlases.emplace_back(new TextureAtlas(layer_size));
+        }
+        regions[i] = atlases.back()->add(widths[i], heights[i],
+                                         texels.data());
+    }
+    for (std::unique_ptr<TextureAtlas>& atlas : atlases)
+        atlas->build();
+
+    // Place the sprites at random, two triangles each
+    const float corners[6][2] = {{0, 0}, {1, 0}, {1, 1},
+                                 {0, 0}, {1, 1}, {0, 1}};
+    std::uniform_real_distribution<float> position(-1.0f, 0.9f);
+    std::uniform_int_distribution<unsigned int> image(0, k_image_count - 1);
+    std::vector<Sprites::Vertex> data;
+    std::vector<unsigned int> images(k_sprite_count);
+    for (unsigned int i = 0; i < k_sprite_count; ++i)
+    {
+        images[i] = image(random);
+        float x = position(random);
+        float y = position(random);
+        float depth = static_cast<float>(i) / k_sprite_count;
+        for (const float* corner : corners)
+        {
+            data.emplace_back(
+                    Position({x + corner[0] * widths[images[i]] / 640.0f,
+                              y + corner[1] * heights[images[i]] / 640.0f,
+                              depth}),
+                    PackedTexCoord::from(corner[0], corner[1]),
+                    TexLayer());
+        }
+    }
+
+    Sprites sprites(std::move(data));
+    for (unsigned int i = 0; i < k_sprite_count; ++i)
+    {
+        const TextureAtlas& atlas = *atlases[m_atlas ? 0 : images[i]];
+        atlas.remap(sprites, i * 6, 6, regions[images[i]]);
+    }
+    glGenBuffers(1, &vbo);
+    glGenVertexArrays(1, &vao);
+    sprites.use(vao, vbo);
+
+    for (unsigned int i = 0; i < k_sprite_count; ++i)
+    {
+        DrawCommand draw{};
+        draw.vao = vao;
+        draw.material = m_atlas ? 0 : images[i];
+        draw.mode = GL_TRIANGLES;
+        draw.first = i * 6;
+        draw.count = 6;
+        commands.push_back(draw);
+    }
+}
+
+void SpriteScene::prepare()
+{
+    for (DrawCommand& draw : commands)
+    {
+        draw.program = program->get_id();
+        draw.key = RenderQueue::make_key(0, draw.program, draw.vao,
+                                         draw.material,
+                                         static_cast<float>(draw.first / 6)
+                                         / k_sprite_count);
+    }
+
+    program->use();
+    program->set_uniform("uTexture", 0);
+}
+
+void SpriteScene::draw(double time)
+{
+    GlState::current().active_texture(GL_TEXTURE0);
+    queue.submit(commands);
+    queue.flush([this](uint16_t material)
+                {
+                    atlases[material]->bind();
+                    ++m_binds;
+                });
+    ++m_frames;
+}
+
+void SpriteScene::report(std::ostream& os) const
+{
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1)
+       << "Sprites: " << k_sprite_count << " of " << k_image_count
+       << " images in " << atlases.size() << " textures, texture binds per "
+       << "frame: " << (m_frames ? static_cast<double>(m_binds) / m_frames
+                                 : 0.0)
+       << std::endl;
+    os.flags(flags);
+    queue.report(os);
+    if (m_atlas)
+        atlases.front()->report(os);
+}
+
+}; // namespace demonia
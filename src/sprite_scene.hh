@@ -0,0 +1,78 @@
+// Scene drawing sprites with or without a texture atlas.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_SPRITE_SCENE_HH_
+#define DEMONIA_SRC_SPRITE_SCENE_HH_
+
+#include "program_builder.hh"
+#include "render_queue.hh"
+#include "scene.hh"
+#include "shader.hh"
+#include "texture_atlas.hh"
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Draws k_sprite_count sprites, each showing one of k_image_count generated
+// images of random sizes, submitted to a sorted render queue with the image
+// as the material. With an atlas, every image is packed into one array
+// texture and the texture coordinates and layers of the sprites are
+// remapped, so that all of them share a material and are drawn by one
+// call; otherwise each image has a texture of its own, bound for each run
+// of sprites showing it.
+typedef class SpriteScene : public Scene
+{
+public:
+    static const unsigned int k_image_count = 256;
+    static const unsigned int k_sprite_count = 4096;
+
+    // Creates the scene, packing the images into an atlas if given true.
+    explicit SpriteScene(bool atlas = true);
+
+    ~SpriteScene() override;
+
+    void load(ProgramBuilder& programs) override;
+
+    void prepare() override;
+
+    void draw(double time) override;
+
+    // Outputs the texture binds and the draws submitted and issued per
+    // frame, and the packing of the atlas.
+    void report(std::ostream& os) const override;
+
+private:
+    bool m_atlas;
+    RenderQueue queue;
+    std::unique_ptr<ShaderProgram> program;
+    std::vector<std::unique_ptr<TextureAtlas>> atlases; // One per material
+    CommandList commands;
+    GLuint vbo = 0; // Vertex Buffer Object
+    GLuint vao = 0; // Vertex Array Object
+    uint64_t m_frames = 0;
+    uint64_t m_binds = 0;
+} SpriteScene;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_SPRITE_SCENE_HH_
@@ -0,0 +1,105 @@
+// Scene drawing mesh files as they are streamed in.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "geometry_streamer.hh"
+#include "mesh_file.hh"
+#include "program_builder.hh"
+#include "shader.hh"
+#include "streamed_mesh_scene.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+const char* vertex_shader_src =
+#include "shaders/mesh.vert"
+;
+
+const char* fragment_shader_src =
+#include "shaders/color.frag"
+;
+
+const char* vertex_shader_file = "mesh.vert";
+const char* fragment_shader_file = "color.frag";
+
+}; // namespace
+
+StreamedMeshScene::StreamedMeshScene(const std::string& path,
+                                     std::size_t budget)
+        : m_path{path}, m_budget{budget}
+{
+}
+
+void StreamedMeshScene::load(ProgramBuilder& programs)
+{
+    programs.add(vertex_shader_src, fragment_shader_src, program,
+                 vertex_shader_file, fragment_shader_file);
+    streamer.reset(new GeometryStreamer(m_budget));
+    for (unsigned int i = 0; i < k_copy_count; ++i)
+        copies.push_back(streamer->request(m_path));
+}
+
+void StreamedMeshScene::draw(double time)
+{
+    streamer->upload();
+
+    program->use();
+    program->set_uniform("uAngle", static_cast<GLfloat>(time * 0.5));
+    const float step = 2.0f / k_grid_size;
+    for (unsigned int i = 0; i < k_copy_count; ++i)
+    {
+        if (!streamer->is_resident(copies[i]))
+            continue;
+
+        /// Fit the bounds of the copy into its cell of the grid
+        const MeshFileHeader& header = streamer->get_header(copies[i]);
+        std::array<GLfloat, 3> center;
+        GLfloat extent = 0.0f;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            center[axis] = (header.bounds_min[axis]
+                            + header.bounds_max[axis]) / 2.0f;
+            extent = std::max(extent, header.bounds_max[axis]
+                                      - header.bounds_min[axis]);
+        }
+        std::array<GLfloat, 2> offset{
+            -1.0f + (i % k_grid_size + 0.5f) * step,
+            -1.0f + (i / k_grid_size + 0.5f) * step};
+
+        program->set_uniform("uCenter", center);
+        program->set_uniform("uScale", extent > 0.0f
+                                       ? 0.75f * step / extent : step);
+        program->set_uniform("uOffset", offset);
+        streamer->draw(copies[i], GL_TRIANGLES);
+    }
+}
+
+void StreamedMeshScene::report(std::ostream& os) const
+{
+    streamer->report(os);
+}
+
+}; // namespace demonia
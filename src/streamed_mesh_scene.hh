@@ -0,0 +1,70 @@
+// Scene drawing mesh files as they are streamed in.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_STREAMED_MESH_SCENE_HH_
+#define DEMONIA_SRC_STREAMED_MESH_SCENE_HH_
+
+#include "geometry_streamer.hh"
+#include "program_builder.hh"
+#include "scene.hh"
+#include "shader.hh"
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace demonia
+{
+
+// Streams k_copy_count copies of a mesh file as separate meshes through a
+// GeometryStreamer and draws each one in a grid as soon as it is resident,
+// so that the first frame is drawn without waiting for any of them to load.
+typedef class StreamedMeshScene : public Scene
+{
+public:
+    // Number of copies along each side of the grid.
+    static const unsigned int k_grid_size = 8;
+    static const unsigned int k_copy_count = k_grid_size * k_grid_size;
+
+    // Creates a scene streaming copies of the mesh file at 'path', uploading
+    // at most 'budget' bytes per frame.
+    StreamedMeshScene(const std::string& path, std::size_t budget);
+
+    void load(ProgramBuilder& programs) override;
+
+    void draw(double time) override;
+
+    bool is_animated() const override
+    {
+        return true;
+    }
+
+    // Outputs the statistics of the streamer.
+    void report(std::ostream& os) const override;
+
+private:
+    std::string m_path;
+    std::size_t m_budget;
+    std::unique_ptr<ShaderProgram> program;
+    std::unique_ptr<GeometryStreamer> streamer;
+    std::vector<GeometryStreamer::MeshId> copies;
+} StreamedMeshScene;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_STREAMED_MESH_SCENE_HH_
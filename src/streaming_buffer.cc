@@ -0,0 +1,145 @@
+// Ring buffer for streaming per-frame data to the GL.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_exception.hh"
+#include "gl_state.hh"
+#include "streaming_buffer.hh"
+
+#include <chrono>
+#include <cstring>
+#include <ios>
+#include <iomanip>
+#include <ostream>
+#include <string>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+StreamingBuffer::StreamingBuffer(GLenum target, GLsizeiptr region_size)
+        : m_target{target}, m_region_size{region_size}
+{
+    glGenBuffers(1, &m_id);
+    GlState::current().bind_buffer(m_target, m_id);
+    glBufferData(m_target, m_region_size * k_region_count, nullptr,
+                 GL_STREAM_DRAW);
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+    for (GLsync fence : m_fences)
+        glDeleteSync(fence);
+    GlState::current().delete_buffers(1, &m_id);
+}
+
+void StreamingBuffer::begin_frame()
+{
+    m_region = (m_region + 1) % k_region_count;
+    m_head = 0;
+    ++m_frames;
+
+    GLsync& fence = m_fences[m_region];
+    if (!fence)
+        return;
+
+    // Poll first so that a stall is only counted if the GPU is behind
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        ++m_stalls;
+        Clock::time_point start = Clock::now();
+        do
+        {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                      1000000);
+        } while (status == GL_TIMEOUT_EXPIRED);
+        m_stall_time += Clock::now() - start;
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void StreamingBuffer::end_frame()
+{
+    GLsync& fence = m_fences[m_region];
+    glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void* StreamingBuffer::map(GLsizeiptr size, GLintptr& offset,
+                           GLsizeiptr alignment)
+{
+    GLsizeiptr head = (m_head + alignment - 1) / alignment * alignment;
+    if (head + size > m_region_size)
+    {
+        std::string info_log = "Streaming buffer region of "
+            + std::to_string(m_region_size) + " bytes has no room for "
+            + std::to_string(size) + " more bytes.\n";
+        throw BufferException(info_log.substr(0, GL_INFO_LOG_LENGTH - 1)
+                                  .c_str());
+    }
+
+    offset = m_region * m_region_size + head;
+    GlState::current().bind_buffer(m_target, m_id);
+    void* data = glMapBufferRange(m_target, offset, size,
+                                  GL_MAP_WRITE_BIT
+                                  | GL_MAP_UNSYNCHRONIZED_BIT
+                                  | GL_MAP_INVALIDATE_RANGE_BIT);
+    if (!data)
+        throw BufferException("Failed to map streaming buffer range.\n");
+
+    m_head = head + size;
+    m_bytes_written += size;
+    return data;
+}
+
+void StreamingBuffer::unmap()
+{
+    GlState::current().bind_buffer(m_target, m_id);
+    glUnmapBuffer(m_target);
+}
+
+GLintptr StreamingBuffer::write(const void* data, GLsizeiptr size,
+                                GLsizeiptr alignment)
+{
+    GLintptr offset;
+    std::memcpy(map(size, offset, alignment), data, size);
+    unmap();
+    return offset;
+}
+
+void StreamingBuffer::bind() const
+{
+    GlState::current().bind_buffer(m_target, m_id);
+}
+
+void StreamingBuffer::report(std::ostream& os) const
+{
+    double stall_ms = std::chrono::duration<double, std::milli>(
+            m_stall_time).count();
+
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(3)
+       << "Streaming buffer: " << m_stalls << " stalls in " << m_frames
+       << " frames (" << stall_ms << " ms waiting), "
+       << (m_frames ? m_bytes_written / m_frames : 0) / (1024.0 * 1024.0)
+       << " MiB written per frame" << std::endl;
+    os.flags(flags);
+}
+
+}; // namespace demonia
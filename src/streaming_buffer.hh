@@ -0,0 +1,113 @@
+// Ring buffer for streaming per-frame data to the GL.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_STREAMING_BUFFER_HH_
+#define DEMONIA_SRC_STREAMING_BUFFER_HH_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Buffer object for data written once per frame, split into a ring of
+// regions, one per frame in flight. Writes map their range with
+// GL_MAP_UNSYNCHRONIZED_BIT, so the driver never waits for the GPU to finish
+// reading the buffer; instead, a fence is placed after each frame's commands
+// and the region is only reused once its fence has been signalled, which
+// only blocks if the GPU is more than k_region_count - 1 frames behind.
+typedef class StreamingBuffer
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static const unsigned int k_region_count = 3;
+
+    // Creates a buffer bound to a target with a region of a size in bytes
+    // for each frame in flight.
+    StreamingBuffer(GLenum target, GLsizeiptr region_size);
+
+    ~StreamingBuffer();
+
+    StreamingBuffer(const StreamingBuffer&) = delete;
+    StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+    // Moves to the next region, waiting for the GPU to finish reading it
+    // from k_region_count frames ago if necessary.
+    void begin_frame();
+
+    // Fences the commands of the frame which read the current region. Must
+    // be called after the last draw using data written during the frame.
+    void end_frame();
+
+    // Allocates a range of the current region and maps it for writing,
+    // returning a pointer to it and setting the offset of the range in the
+    // buffer, which is aligned to a multiple of alignment. The range must be
+    // unmapped before drawing. Throws a BufferException if the region has
+    // too little space left or the range could not be mapped.
+    void* map(GLsizeiptr size, GLintptr& offset, GLsizeiptr alignment = 16);
+
+    // Unmaps the range mapped by map().
+    void unmap();
+
+    // Copies data into a newly allocated range of the current region,
+    // returning its offset in the buffer.
+    GLintptr write(const void* data, GLsizeiptr size,
+                   GLsizeiptr alignment = 16);
+
+    // Binds the buffer to its target.
+    void bind() const;
+
+    inline GLuint get_id() const noexcept
+    {
+        return m_id;
+    }
+
+    inline GLsizeiptr get_region_size() const noexcept
+    {
+        return m_region_size;
+    }
+
+    // Returns the number of frames in which begin_frame() had to wait for
+    // the GPU.
+    inline uint64_t stalls() const noexcept
+    {
+        return m_stalls;
+    }
+
+    // Outputs stall counts and times, and the amount of data written.
+    void report(std::ostream& os) const;
+
+private:
+    GLenum m_target;
+    GLuint m_id = 0;
+    GLsizeiptr m_region_size;
+    std::array<GLsync, k_region_count> m_fences{};
+    unsigned int m_region = k_region_count - 1;
+    GLsizeiptr m_head = 0; // Write position within the current region
+    uint64_t m_frames = 0;
+    uint64_t m_stalls = 0;
+    Clock::duration m_stall_time{0};
+    uint64_t m_bytes_written = 0;
+} StreamingBuffer;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_STREAMING_BUFFER_HH_
@@ -0,0 +1,91 @@
+// Scene of an indexed grid of triangle strips.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_state.hh"
+#include "indices.hh"
+#include "program_builder.hh"
+#include "strip_grid_scene.hh"
+#include "vertices.hh"
+
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+StripGridScene::~StripGridScene()
+{
+    GlState::current().delete_vertex_arrays(1, &vao);
+    GlState::current().delete_buffers(1, &ebo);
+    GlState::current().delete_buffers(1, &vbo);
+}
+
+void StripGridScene::load(ProgramBuilder& programs)
+{
+    const float step = 2.0f / (k_grid_size - 1);
+    std::vector<Mesh::Vertex> data;
+    data.reserve(k_grid_size * k_grid_size);
+    for (unsigned int row = 0; row < k_grid_size; ++row)
+    {
+        for (unsigned int column = 0; column < k_grid_size; ++column)
+        {
+            float u = static_cast<float>(column) / (k_grid_size - 1);
+            float v = static_cast<float>(row) / (k_grid_size - 1);
+            data.emplace_back(Position({-1.0f + column * step,
+                                        -1.0f + row * step, 0.0f}),
+                              Color({u, v, 1.0f - u * v}));
+        }
+    }
+
+    // One strip between each pair of rows
+    std::vector<GLuint> indices;
+    indices.reserve((k_grid_size - 1) * (k_grid_size * 2 + 1));
+    for (unsigned int row = 0; row + 1 < k_grid_size; ++row)
+    {
+        if (row > 0)
+            indices.push_back(Indices::k_restart);
+        for (unsigned int column = 0; column < k_grid_size; ++column)
+        {
+            indices.push_back((row + 1) * k_grid_size + column);
+            indices.push_back(row * k_grid_size + column);
+        }
+    }
+
+    mesh.reset(new Mesh(std::move(data), indices));
+    glGenBuffers(1, &vbo);
+    glGenBuffers(1, &ebo);
+    glGenVertexArrays(1, &vao);
+    mesh->use(vao, vbo, ebo);
+}
+
+void StripGridScene::draw(double time)
+{
+    GlState::current().bind_vertex_array(vao);
+    mesh->draw(GL_TRIANGLE_STRIP);
+}
+
+void StripGridScene::report(std::ostream& os) const
+{
+    const Indices& indices = mesh->get_indices();
+    os << "Indices: " << indices.size() << " of "
+       << index_type_size(indices.get_type()) << " bytes ("
+       << indices.bytes() << " bytes, "
+       << indices.size() * sizeof(GLuint) << " as GLuint)" << std::endl;
+}
+
+}; // namespace demonia
@@ -0,0 +1,62 @@
+// Scene of an indexed grid of triangle strips.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_STRIP_GRID_SCENE_HH_
+#define DEMONIA_SRC_STRIP_GRID_SCENE_HH_
+
+#include "program_builder.hh"
+#include "scene.hh"
+#include "vertices.hh"
+
+#include <memory>
+#include <ostream>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Draws a grid of k_grid_size² shared vertices covering the viewport as one
+// triangle strip per row, separated by primitive restarts, in a single
+// indexed draw call. The grid is sized so that its indices fit in
+// GL_UNSIGNED_SHORT.
+typedef class StripGridScene : public Scene
+{
+public:
+    // Number of vertices along each side of the grid.
+    static const unsigned int k_grid_size = 255;
+
+    ~StripGridScene() override;
+
+    void load(ProgramBuilder& programs) override;
+
+    void draw(double time) override;
+
+    // Outputs the index type and the size of the index buffer.
+    void report(std::ostream& os) const override;
+
+private:
+    typedef Vertices<Position, Color> Mesh;
+
+    std::unique_ptr<Mesh> mesh;
+    GLuint vbo = 0; // Vertex Buffer Object
+    GLuint ebo = 0; // Element Buffer Object
+    GLuint vao = 0; // Vertex Array Object
+} StripGridScene;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_STRIP_GRID_SCENE_HH_
@@ -0,0 +1,189 @@
+// Two-dimensional textures with immutable storage.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_exception.hh"
+#include "gl_state.hh"
+#include "texture.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+// GL enumerants and block size of a texture format.
+typedef struct FormatInfo
+{
+    GLenum internal_format;
+    GLenum format;      // Pixel format of uncompressed data
+    GLenum type;        // Pixel type of uncompressed data
+    GLsizei block_size; // Bytes per block, or per texel if uncompressed
+    const char* name;
+} FormatInfo;
+
+const FormatInfo& format_info(TextureFormat format) noexcept
+{
+    static const FormatInfo infos[] = {
+        {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, "rgba8"},
+        {GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 0, 0, 8, "bc1"},
+        {GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0, 0, 16, "bc3"},
+        {GL_COMPRESSED_RED_RGTC1, 0, 0, 8, "bc4"},
+        {GL_COMPRESSED_RG_RGTC2, 0, 0, 16, "bc5"}
+    };
+    return infos[static_cast<int>(format)];
+}
+
+}; // namespace
+
+const char* texture_format_name(TextureFormat format) noexcept
+{
+    return format_info(format).name;
+}
+
+bool texture_format_supported(TextureFormat format) noexcept
+{
+    switch (format)
+    {
+    case TextureFormat::BC1:
+    case TextureFormat::BC3:
+        return GLEW_EXT_texture_compression_s3tc;
+    default:
+        return true;
+    }
+}
+
+std::size_t texture_row_size(TextureFormat format, GLsizei width) noexcept
+{
+    GLsizei blocks = texture_format_compressed(format) ? (width + 3) / 4
+                                                       : width;
+    return static_cast<std::size_t>(blocks) * format_info(format).block_size;
+}
+
+std::size_t texture_image_size(TextureFormat format, GLsizei width,
+                               GLsizei height) noexcept
+{
+    GLsizei row_height = texture_row_height(format);
+    return texture_row_size(format, width)
+           * ((height + row_height - 1) / row_height);
+}
+
+GLsizei texture_level_count(GLsizei width, GLsizei height) noexcept
+{
+    GLsizei levels = 1;
+    for (GLsizei size = std::max(width, height); size > 1; size >>= 1)
+        ++levels;
+    return levels;
+}
+
+Texture::Texture(TextureFormat format, GLsizei width, GLsizei height,
+                 GLsizei levels)
+        : m_format{format}, m_width{width}, m_height{height},
+          m_levels{levels ? levels : texture_level_count(width, height)},
+          m_resident_level{m_levels}
+{
+    if (!texture_format_supported(format))
+    {
+        std::string info_log = std::string("Texture format ")
+            + texture_format_name(format) + " is not supported.\n";
+        throw TextureException(info_log.c_str());
+    }
+    if (width < 1 || height < 1
+        || m_levels > texture_level_count(width, height))
+        throw TextureException("Invalid texture size.\n");
+
+    const FormatInfo& info = format_info(format);
+    GlState& state = GlState::current();
+    glGenTextures(1, &m_id);
+    state.bind_texture(GL_TEXTURE_2D, m_id);
+    state.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (GLEW_ARB_texture_storage)
+    {
+        glTexStorage2D(GL_TEXTURE_2D, m_levels, info.internal_format, width,
+                       height);
+    }
+    else
+    {
+        for (GLint level = 0; level < m_levels; ++level)
+        {
+            if (texture_format_compressed(format))
+                glCompressedTexImage2D(GL_TEXTURE_2D, level,
+                                       info.internal_format,
+                                       level_width(level),
+                                       level_height(level), 0,
+                                       level_size(level), nullptr);
+            else
+                glTexImage2D(GL_TEXTURE_2D, level, info.internal_format,
+                             level_width(level), level_height(level), 0,
+                             info.format, info.type, nullptr);
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, m_levels - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    /// Show single-channel formats as grey rather than red
+    if (format == TextureFormat::BC4)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+    }
+}
+
+Texture::~Texture()
+{
+    GlState::current().delete_textures(1, &m_id);
+}
+
+void Texture::bind() const noexcept
+{
+    GlState::current().bind_texture(GL_TEXTURE_2D, m_id);
+}
+
+void Texture::upload(GLint level, GLsizei y, GLsizei height,
+                     const void* data) const noexcept
+{
+    const FormatInfo& info = format_info(m_format);
+    bind();
+    if (texture_format_compressed(m_format))
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, y,
+                                  level_width(level), height,
+                                  info.internal_format,
+                                  texture_image_size(m_format,
+                                                     level_width(level),
+                                                     height),
+                                  data);
+    else
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, y, level_width(level),
+                        height, info.format, info.type, data);
+}
+
+void Texture::set_resident_level(GLint level) noexcept
+{
+    m_resident_level = level;
+    bind();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+}
+
+}; // namespace demonia
@@ -0,0 +1,155 @@
+// Two-dimensional textures with immutable storage.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_TEXTURE_HH_
+#define DEMONIA_SRC_TEXTURE_HH_
+
+#include <cstddef>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Formats of texture data, uncompressed or in blocks of 4x4 texels.
+enum class TextureFormat
+{
+    RGBA8, // 8-bit unsigned normalized red, green, blue and alpha
+    BC1,   // S3TC DXT1 RGB with 1-bit alpha, 8 bytes per block
+    BC3,   // S3TC DXT5 RGBA, 16 bytes per block
+    BC4,   // RGTC1 red, 8 bytes per block
+    BC5    // RGTC2 red and green, 16 bytes per block
+};
+
+// Returns the name of a texture format.
+const char* texture_format_name(TextureFormat format) noexcept;
+
+// Returns whether the GL supports a texture format: the S3TC formats require
+// GL_EXT_texture_compression_s3tc, while the others are core.
+bool texture_format_supported(TextureFormat format) noexcept;
+
+// Returns whether a texture format is compressed in blocks.
+constexpr bool texture_format_compressed(TextureFormat format) noexcept
+{
+    return format != TextureFormat::RGBA8;
+}
+
+// Returns the texel rows in each row of data of a texture format: 4 for
+// compressed formats and 1 otherwise.
+constexpr GLsizei texture_row_height(TextureFormat format) noexcept
+{
+    return texture_format_compressed(format) ? 4 : 1;
+}
+
+// Returns the size in bytes of a row of data of a texture format, of texels
+// or of blocks, for a width in texels.
+std::size_t texture_row_size(TextureFormat format, GLsizei width) noexcept;
+
+// Returns the size in bytes of an image of a texture format.
+std::size_t texture_image_size(TextureFormat format, GLsizei width,
+                               GLsizei height) noexcept;
+
+// Returns the number of mip levels in a full chain for a size.
+GLsizei texture_level_count(GLsizei width, GLsizei height) noexcept;
+
+// Two-dimensional texture with storage for a chain of mip levels allocated
+// once, with glTexStorage2D if GL_ARB_texture_storage is available and with
+// an image per level otherwise. Sampling is limited to the levels from the
+// finest resident level to the coarsest, so that levels can be filled in
+// from coarsest to finest while the texture is drawn.
+typedef class Texture
+{
+public:
+    // Allocates a texture of a format and size with a number of mip levels,
+    // or a full chain if 0. Throws a TextureException if the format is not
+    // supported or the size is invalid.
+    Texture(TextureFormat format, GLsizei width, GLsizei height,
+            GLsizei levels = 0);
+
+    ~Texture();
+
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    // Binds the texture to GL_TEXTURE_2D of the active texture unit.
+    void bind() const noexcept;
+
+    // Fills a band of rows of a mip level, starting at row y, from data in
+    // the layout of the format, or from an offset into the buffer bound to
+    // GL_PIXEL_UNPACK_BUFFER. For compressed formats, y and height must be
+    // multiples of 4 unless the band reaches the bottom of the level.
+    void upload(GLint level, GLsizei y, GLsizei height, const void* data)
+        const noexcept;
+
+    // Makes a mip level and every coarser level available for sampling.
+    void set_resident_level(GLint level) noexcept;
+
+    // Returns whether any level is resident.
+    inline bool is_drawable() const noexcept
+    {
+        return m_resident_level < m_levels;
+    }
+
+    inline GLuint get_id() const noexcept
+    {
+        return m_id;
+    }
+
+    inline TextureFormat get_format() const noexcept
+    {
+        return m_format;
+    }
+
+    inline GLsizei get_level_count() const noexcept
+    {
+        return m_levels;
+    }
+
+    // Returns the finest resident mip level, or the level count if none.
+    inline GLint get_resident_level() const noexcept
+    {
+        return m_resident_level;
+    }
+
+    inline GLsizei level_width(GLint level) const noexcept
+    {
+        return m_width >> level ? m_width >> level : 1;
+    }
+
+    inline GLsizei level_height(GLint level) const noexcept
+    {
+        return m_height >> level ? m_height >> level : 1;
+    }
+
+    // Returns the size in bytes of a mip level.
+    inline std::size_t level_size(GLint level) const noexcept
+    {
+        return texture_image_size(m_format, level_width(level),
+                                  level_height(level));
+    }
+
+private:
+    TextureFormat m_format;
+    GLsizei m_width;
+    GLsizei m_height;
+    GLsizei m_levels;
+    GLint m_resident_level;
+    GLuint m_id = 0;
+} Texture;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_TEXTURE_HH_
@@ -0,0 +1,278 @@
+// Packing of images into the layers of an array texture.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_exception.hh"
+#include "gl_state.hh"
+#include "texture_atlas.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <ios>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+SkylinePacker::SkylinePacker(GLsizei width, GLsizei height)
+        : m_width{width}, m_height{height}, m_skyline{{0, 0, width}}
+{
+}
+
+bool SkylinePacker::insert(GLsizei width, GLsizei height, GLsizei& x,
+                           GLsizei& y)
+{
+    std::size_t best = m_skyline.size();
+    GLsizei best_y = 0;
+    for (std::size_t i = 0; i < m_skyline.size(); ++i)
+    {
+        GLsizei fit_y = fit(i, width, height);
+        if (fit_y >= 0 && (best == m_skyline.size() || fit_y < best_y))
+        {
+            best = i;
+            best_y = fit_y;
+        }
+    }
+    if (best == m_skyline.size())
+        return false;
+
+    x = m_skyline[best].x;
+    y = best_y;
+    m_skyline.insert(m_skyline.begin() + best, {x, y + height, width});
+
+    // Cut the segments now under the rectangle
+    for (std::size_t i = best + 1; i < m_skyline.size();)
+    {
+        Segment& segment = m_skyline[i];
+        GLsizei overlap = x + width - segment.x;
+        if (overlap <= 0)
+            break;
+        if (overlap < segment.width)
+        {
+            segment.x += overlap;
+            segment.width -= overlap;
+            break;
+        }
+        m_skyline.erase(m_skyline.begin() + i);
+    }
+
+    // Merge neighbouring segments of the same height
+    for (std::size_t i = 0; i + 1 < m_skyline.size();)
+    {
+        if (m_skyline[i].y == m_skyline[i + 1].y)
+        {
+            m_skyline[i].width += m_skyline[i + 1].width;
+            m_skyline.erase(m_skyline.begin() + i + 1);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    m_area += static_cast<uint64_t>(width) * height;
+    return true;
+}
+
+double SkylinePacker::occupancy() const noexcept
+{
+    return static_cast<double>(m_area) / (static_cast<double>(m_width)
+                                          * m_height);
+}
+
+GLsizei SkylinePacker::fit(std::size_t i, GLsizei width, GLsizei height)
+    const noexcept
+{
+    if (m_skyline[i].x + width > m_width)
+        return -1;
+
+    GLsizei y = 0;
+    for (GLsizei left = width; left > 0; left -= m_skyline[i++].width)
+    {
+        y = std::max(y, m_skyline[i].y);
+        if (y + height > m_height)
+            return -1;
+    }
+    return y;
+}
+
+TextureAtlas::TextureAtlas(GLsizei layer_size)
+        : m_layer_size{layer_size}
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    GlState::current().delete_textures(1, &m_id);
+}
+
+std::size_t TextureAtlas::add(GLsizei width, GLsizei height,
+                              const void* pixels)
+{
+    Image image{width + 2 * k_padding, height + 2 * k_padding, {}};
+    image.texels.resize(static_cast<std::size_t>(image.width)
+                        * image.height);
+
+    /// Copy the edges of the image into its border
+    const uint32_t* in = static_cast<const uint32_t*>(pixels);
+    for (GLsizei y = 0; y < image.height; ++y)
+    {
+        GLsizei source_y = std::clamp(y - k_padding, 0, height - 1);
+        for (GLsizei x = 0; x < image.width; ++x)
+        {
+            GLsizei source_x = std::clamp(x - k_padding, 0, width - 1);
+            image.texels[y * image.width + x] =
+                in[source_y * width + source_x];
+        }
+    }
+
+    m_images.push_back(std::move(image));
+    return m_images.size() - 1;
+}
+
+void TextureAtlas::build()
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    std::vector<std::size_t> order(m_images.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [this](std::size_t a, std::size_t b)
+                     {
+                         return m_images[a].height > m_images[b].height;
+                     });
+
+    std::vector<GLsizei> xs(m_images.size());
+    std::vector<GLsizei> ys(m_images.size());
+    m_regions.resize(m_images.size());
+    for (std::size_t index : order)
+    {
+        const Image& image = m_images[index];
+        if (image.width > m_layer_size || image.height > m_layer_size)
+        {
+            std::string info_log = "Image of " + std::to_string(image.width)
+                + "x" + std::to_string(image.height)
+                + " texels does not fit in a texture atlas layer.\n";
+            throw TextureException(info_log.c_str());
+        }
+
+        std::size_t layer = 0;
+        while (layer < m_layers.size()
+               && !m_layers[layer].insert(image.width, image.height,
+                                          xs[index], ys[index]))
+            ++layer;
+        if (layer == m_layers.size())
+        {
+            m_layers.emplace_back(m_layer_size, m_layer_size);
+            m_layers.back().insert(image.width, image.height, xs[index],
+                                   ys[index]);
+        }
+
+        GLfloat size = m_layer_size;
+        m_regions[index] = {
+            static_cast<GLfloat>(layer),
+            (xs[index] + k_padding) / size,
+            (ys[index] + k_padding) / size,
+            (xs[index] + image.width - k_padding) / size,
+            (ys[index] + image.height - k_padding) / size};
+    }
+    m_pack_time = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+
+    GLint max_layers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    if (static_cast<GLint>(m_layers.size()) > max_layers)
+        throw TextureException("Texture atlas has too many layers.\n");
+
+    GlState& state = GlState::current();
+    glGenTextures(1, &m_id);
+    state.bind_texture(GL_TEXTURE_2D_ARRAY, m_id);
+    state.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (GLEW_ARB_texture_storage)
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, m_layer_size,
+                       m_layer_size, m_layers.size());
+    else
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, m_layer_size,
+                     m_layer_size, m_layers.size(), 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S,
+                    GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T,
+                    GL_CLAMP_TO_EDGE);
+
+    /// Compose each layer on the CPU to upload it in one call
+    std::vector<uint32_t> texels(static_cast<std::size_t>(m_layer_size)
+                                 * m_layer_size);
+    for (std::size_t layer = 0; layer < m_layers.size(); ++layer)
+    {
+        std::fill(texels.begin(), texels.end(), 0);
+        for (std::size_t index = 0; index < m_images.size(); ++index)
+        {
+            if (m_regions[index].layer != layer)
+                continue;
+            const Image& image = m_images[index];
+            for (GLsizei y = 0; y < image.height; ++y)
+            {
+                std::memcpy(&texels[(ys[index] + y) * m_layer_size
+                                    + xs[index]],
+                            &image.texels[y * image.width],
+                            image.width * sizeof(uint32_t));
+            }
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_layer_size,
+                        m_layer_size, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                        texels.data());
+    }
+
+    m_images.clear();
+    m_images.shrink_to_fit();
+}
+
+void TextureAtlas::bind() const noexcept
+{
+    GlState::current().bind_texture(GL_TEXTURE_2D_ARRAY, m_id);
+}
+
+void TextureAtlas::report(std::ostream& os) const
+{
+    double occupancy = 0.0;
+    for (const SkylinePacker& layer : m_layers)
+        occupancy += layer.occupancy();
+
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1)
+       << "Texture atlas: " << m_regions.size() << " images in "
+       << m_layers.size() << " layers of " << m_layer_size << "x"
+       << m_layer_size << ", "
+       << (m_layers.empty() ? 0.0 : 100.0 * occupancy / m_layers.size())
+       << "% occupied, packed in " << std::setprecision(3)
+       << m_pack_time * 1000.0 << " ms" << std::endl;
+    os.flags(flags);
+}
+
+}; // namespace demonia
@@ -0,0 +1,173 @@
+// Packing of images into the layers of an array texture.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_TEXTURE_ATLAS_HH_
+#define DEMONIA_SRC_TEXTURE_ATLAS_HH_
+
+#include "vertices.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Packs rectangles into a bin with the bottom-left skyline heuristic. The
+// skyline is the upper edge of the packed rectangles, kept as a list of
+// horizontal segments; each rectangle is placed on the segment where its
+// top would be lowest, the leftmost on ties, and the space it leaves below
+// itself is given up.
+typedef class SkylinePacker
+{
+public:
+    SkylinePacker(GLsizei width, GLsizei height);
+
+    // Reserves space for a rectangle and sets its position, returning
+    // false if it does not fit.
+    bool insert(GLsizei width, GLsizei height, GLsizei& x, GLsizei& y);
+
+    // Returns the fraction of the bin covered by the packed rectangles.
+    double occupancy() const noexcept;
+
+private:
+    typedef struct Segment
+    {
+        GLsizei x;
+        GLsizei y;
+        GLsizei width;
+    } Segment;
+
+    // Returns the height at which a rectangle of a width starting at
+    // segment i would rest, or -1 if it would overflow the bin.
+    GLsizei fit(std::size_t i, GLsizei width, GLsizei height) const noexcept;
+
+    GLsizei m_width;
+    GLsizei m_height;
+    std::vector<Segment> m_skyline; // Ordered by x, covering the width
+    uint64_t m_area = 0;
+} SkylinePacker;
+
+// Packs RGBA8 images into the layers of a GL_TEXTURE_2D_ARRAY, so that
+// draws with different images can share one texture binding and be batched.
+// Each image is surrounded by a border of k_padding texels copied from its
+// edges, which keeps linear filtering from bleeding in its neighbours.
+typedef class TextureAtlas
+{
+public:
+    // Region of the atlas holding an image.
+    typedef struct Region
+    {
+        GLfloat layer;
+        GLfloat u0, v0; // Texture coordinates of the bottom-left corner
+        GLfloat u1, v1; // Texture coordinates of the top-right corner
+    } Region;
+
+    static const GLsizei k_padding = 1;
+
+    // Creates an empty atlas with square layers of a size in texels.
+    explicit TextureAtlas(GLsizei layer_size = 1024);
+
+    ~TextureAtlas();
+
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    // Copies an image of rows of RGBA8 texels, from the bottom row up, into
+    // the atlas and returns its index. Must be called before build().
+    std::size_t add(GLsizei width, GLsizei height, const void* pixels);
+
+    // Packs the images, tallest first, into as many layers as needed and
+    // creates the array texture. Throws a TextureException if an image does
+    // not fit in a layer or the layers exceed GL_MAX_ARRAY_TEXTURE_LAYERS.
+    void build();
+
+    inline const Region& get_region(std::size_t image) const noexcept
+    {
+        return m_regions[image];
+    }
+
+    // Remaps the PackedTexCoord texture coordinates of count vertices from
+    // first, given in [0, 1] over an image, to the region of the image in
+    // the atlas, and sets their TexLayer if they have one.
+    template<typename V>
+    void remap(V& vertices, std::size_t first, std::size_t count,
+               std::size_t image) const
+    {
+        typedef typename V::Vertex Vertex;
+        constexpr std::size_t texcoord =
+            vertex_attribute_index<PackedTexCoord, Vertex>::value;
+        constexpr std::size_t layer =
+            vertex_attribute_index<TexLayer, Vertex>::value;
+        static_assert(texcoord < V::Layout::count,
+                      "vertices must have texture coordinates");
+
+        const Region& region = m_regions[image];
+        for (std::size_t i = first; i < first + count; ++i)
+        {
+            Vertex& vertex = vertices.get_data()[i];
+            PackedTexCoord::Data& uv = get<texcoord>(vertex).m_data;
+            GLfloat u = uv.u / 65535.0f;
+            GLfloat v = uv.v / 65535.0f;
+            get<texcoord>(vertex) = PackedTexCoord::from(
+                    region.u0 + u * (region.u1 - region.u0),
+                    region.v0 + v * (region.v1 - region.v0));
+            if constexpr (layer < V::Layout::count)
+                get<layer>(vertex).m_data = region.layer;
+        }
+    }
+
+    // Binds the array texture to GL_TEXTURE_2D_ARRAY of the active texture
+    // unit.
+    void bind() const noexcept;
+
+    inline GLuint get_id() const noexcept
+    {
+        return m_id;
+    }
+
+    inline GLsizei get_layer_count() const noexcept
+    {
+        return m_layers.size();
+    }
+
+    // Outputs the number of images and layers, the occupancy of the layers
+    // and the time taken to pack them.
+    void report(std::ostream& os) const;
+
+private:
+    // Image added to the atlas, with its padding.
+    typedef struct Image
+    {
+        GLsizei width;
+        GLsizei height;
+        std::vector<uint32_t> texels;
+    } Image;
+
+    GLsizei m_layer_size;
+    std::vector<Image> m_images;
+    std::vector<Region> m_regions;
+    std::vector<SkylinePacker> m_layers;
+    GLuint m_id = 0;
+    double m_pack_time = 0.0; // Seconds
+} TextureAtlas;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_TEXTURE_ATLAS_HH_
@@ -0,0 +1,314 @@
+// Asynchronous streaming of texture mip levels through pixel buffers.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_exception.hh"
+#include "gl_state.hh"
+#include "texture.hh"
+#include "texture_streamer.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ios>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+// Alignment of bands in a slot, enough for any texel or block.
+const std::size_t k_band_alignment = 16;
+
+}; // namespace
+
+TextureStreamer::TextureStreamer(std::size_t slot_size)
+        : m_slot_size{slot_size}
+{
+    GlState& state = GlState::current();
+    for (Slot& slot : m_slots)
+    {
+        glGenBuffers(1, &slot.pbo);
+        state.bind_buffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, m_slot_size, nullptr,
+                     GL_STREAM_DRAW);
+    }
+    state.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    m_thread = std::thread(&TextureStreamer::run, this);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_worker_wake.notify_all();
+    m_thread.join();
+
+    GlState& state = GlState::current();
+    for (Slot& slot : m_slots)
+    {
+        if (slot.state == Slot::State::DECODING
+            || slot.state == Slot::State::DECODED)
+        {
+            state.bind_buffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        glDeleteSync(slot.fence);
+        state.delete_buffers(1, &slot.pbo);
+    }
+}
+
+void TextureStreamer::request(Texture& texture, Decoder decoder)
+{
+    std::size_t row_size = texture_row_size(texture.get_format(),
+                                            texture.level_width(0));
+    GLsizei row_height = texture_row_height(texture.get_format());
+    if (row_size > m_slot_size)
+    {
+        std::string info_log = "Texture rows of "
+            + std::to_string(row_size) + " bytes exceed the "
+            + std::to_string(m_slot_size) + "-byte streaming buffers.\n";
+        throw TextureException(info_log.c_str());
+    }
+
+    std::unique_ptr<Stream> stream(new Stream());
+    stream->texture = &texture;
+    stream->decoder = std::move(decoder);
+    stream->band_rows = m_slot_size / row_size * row_height;
+    stream->next_level = texture.get_level_count() - 1;
+    for (GLint level = 0; level < texture.get_level_count(); ++level)
+    {
+        GLsizei height = texture.level_height(level);
+        stream->bands.push_back((height + stream->band_rows - 1)
+                                / stream->band_rows);
+    }
+
+    if (is_complete())
+        m_first_request = Clock::now();
+    m_streams.push_back(std::move(stream));
+}
+
+void TextureStreamer::update()
+{
+    Clock::time_point start = Clock::now();
+    GlState& state = GlState::current();
+    std::size_t frame_bytes = 0;
+
+    // Retire the bands whose copies have completed
+    for (Slot& slot : m_slots)
+    {
+        if (slot.state != Slot::State::COPYING
+            || glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            continue;
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+        slot.state = Slot::State::FREE;
+        for (const Band& band : slot.bands)
+            retire(band);
+        slot.bands.clear();
+    }
+
+    // Copy the decoded bands into their textures
+    std::vector<Slot*> decoded;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (Slot& slot : m_slots)
+        {
+            if (slot.state == Slot::State::DECODED)
+                decoded.push_back(&slot);
+        }
+    }
+    for (Slot* slot : decoded)
+    {
+        state.bind_buffer(GL_PIXEL_UNPACK_BUFFER, slot->pbo);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        slot->data = nullptr;
+        for (const Band& band : slot->bands)
+        {
+            const Texture& texture = *band.stream->texture;
+            texture.upload(band.level, band.y, band.height,
+                           reinterpret_cast<const void*>(band.offset));
+            frame_bytes += texture_image_size(
+                    texture.get_format(), texture.level_width(band.level),
+                    band.height);
+        }
+        slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        slot->state = Slot::State::COPYING;
+        m_bands += slot->bands.size();
+    }
+
+    // Hand the free buffers to the worker
+    bool queued = false;
+    for (Slot& slot : m_slots)
+    {
+        if (slot.state == Slot::State::FREE)
+        {
+            if (!map(slot))
+                break;
+            queued = true;
+        }
+    }
+    state.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (queued)
+        m_worker_wake.notify_one();
+
+    ++m_updates;
+    m_update_time += Clock::now() - start;
+    if (frame_bytes > 0)
+    {
+        ++m_frames;
+        m_bytes_uploaded += frame_bytes;
+        m_max_frame_bytes = std::max(m_max_frame_bytes, frame_bytes);
+    }
+}
+
+void TextureStreamer::report(std::ostream& os) const
+{
+    typedef std::chrono::duration<double, std::milli> Milliseconds;
+
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1)
+       << "Texture streaming: " << m_completed << " of " << m_streams.size()
+       << " textures resident, " << m_bytes_uploaded / (1024.0 * 1024.0)
+       << " MiB in " << m_bands << " bands over " << m_frames << " frames"
+       << std::endl
+       << "Uploaded per frame (KiB): mean "
+       << (m_frames ? m_bytes_uploaded / m_frames : 0) / 1024.0 << ", max "
+       << m_max_frame_bytes / 1024.0 << std::setprecision(3)
+       << "; update time (ms): mean "
+       << (m_updates ? Milliseconds(m_update_time).count() / m_updates
+                     : 0.0)
+       << std::endl;
+    if (is_complete() && !m_streams.empty())
+    {
+        os << "Time to full residency: "
+           << Milliseconds(m_residency_time).count() << " ms" << std::endl;
+    }
+    os.flags(flags);
+}
+
+void TextureStreamer::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_worker_wake.wait(lock, [this]
+                           {
+                               return m_stopping || !m_jobs.empty();
+                           });
+        if (m_stopping)
+            return;
+
+        Slot& slot = *m_jobs.front();
+        m_jobs.pop_front();
+        lock.unlock();
+        for (const Band& band : slot.bands)
+        {
+            band.stream->decoder(band.level, band.y, band.height,
+                                 static_cast<unsigned char*>(slot.data)
+                                 + band.offset);
+        }
+        lock.lock();
+        slot.state = Slot::State::DECODED;
+    }
+}
+
+bool TextureStreamer::map(Slot& slot)
+{
+    std::size_t size = 0;
+    for (;;)
+    {
+        Stream* stream = nullptr;
+        for (std::unique_ptr<Stream>& candidate : m_streams)
+        {
+            if (candidate->next_level >= 0
+                && (!stream || candidate->next_level > stream->next_level))
+                stream = candidate.get();
+        }
+        if (!stream)
+            break;
+
+        const Texture& texture = *stream->texture;
+        GLint level = stream->next_level;
+        GLsizei level_height = texture.level_height(level);
+        GLsizei height = std::min(stream->band_rows,
+                                  level_height - stream->next_y);
+        std::size_t offset = (size + k_band_alignment - 1)
+                             / k_band_alignment * k_band_alignment;
+        std::size_t end = offset + texture_image_size(
+                texture.get_format(), texture.level_width(level), height);
+        if (end > m_slot_size)
+            break;
+
+        slot.bands.push_back({stream, level, stream->next_y, height,
+                              offset});
+        size = end;
+        stream->next_y += height;
+        if (stream->next_y >= level_height)
+        {
+            --stream->next_level;
+            stream->next_y = 0;
+        }
+    }
+    if (slot.bands.empty())
+        return false;
+
+    /// The fence of the slot has been signalled, so mapping it never waits
+    GlState::current().bind_buffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+    slot.data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                 GL_MAP_WRITE_BIT
+                                 | GL_MAP_INVALIDATE_BUFFER_BIT
+                                 | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!slot.data)
+        throw BufferException("Failed to map pixel buffer.\n");
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    slot.state = Slot::State::DECODING;
+    m_jobs.push_back(&slot);
+    return true;
+}
+
+void TextureStreamer::retire(const Band& band)
+{
+    Stream& stream = *band.stream;
+    --stream.bands[band.level];
+
+    GLint resident = stream.texture->get_resident_level();
+    GLint level = resident;
+    while (level > 0 && stream.bands[level - 1] == 0)
+        --level;
+    if (level == resident)
+        return;
+
+    stream.texture->set_resident_level(level);
+    if (level == 0 && ++m_completed == m_streams.size())
+        m_residency_time = Clock::now() - m_first_request;
+}
+
+}; // namespace demonia
@@ -0,0 +1,169 @@
+// Asynchronous streaming of texture mip levels through pixel buffers.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_TEXTURE_STREAMER_HH_
+#define DEMONIA_SRC_TEXTURE_STREAMER_HH_
+
+#include "texture.hh"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Streams the mip levels of textures from coarsest to finest through a ring
+// of k_slot_count Pixel Buffer Objects. The render thread maps a free
+// buffer and hands it to a worker thread, which decodes as many bands of
+// rows of levels as fit straight into the mapping; in a later frame the
+// render thread unmaps it, copies the bands into their textures and fences
+// the copies. Buffers are only mapped again once their fence has been
+// signalled, so the render thread never waits for the worker or the GPU,
+// and a level becomes sampleable once every band of it and of the coarser
+// levels is complete.
+typedef class TextureStreamer
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Writes rows [y, y + height) of a mip level into data, in the layout of
+    // the format of the texture. Called on the worker thread.
+    typedef std::function<void(GLint level, GLsizei y, GLsizei height,
+                               void* data)> Decoder;
+
+    static const unsigned int k_slot_count = 4;
+
+    // Creates a ring of buffers of slot_size bytes, which bounds the size of
+    // each band, and starts the worker thread. Must be called with the GL
+    // context current.
+    explicit TextureStreamer(std::size_t slot_size = 4 * 1024 * 1024);
+
+    // Stops the worker thread and deletes the buffers. Must be called with
+    // the GL context current.
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Queues every mip level of a texture to be filled by a decoder. The
+    // texture must outlive the streamer or its completion. Throws a
+    // TextureException if a row of data of the texture exceeds a slot.
+    void request(Texture& texture, Decoder decoder);
+
+    // Uploads bands decoded since the last call, retires those whose copies
+    // have completed and hands free buffers to the worker. Called once per
+    // frame by the render thread; never blocks.
+    void update();
+
+    // Returns whether every requested texture is fully resident.
+    inline bool is_complete() const noexcept
+    {
+        return m_completed == m_streams.size();
+    }
+
+    // Outputs the bytes uploaded per frame, the time spent in update() and
+    // the time taken for every texture to become fully resident.
+    void report(std::ostream& os) const;
+
+private:
+    // Texture being streamed.
+    typedef struct Stream
+    {
+        Texture* texture;
+        Decoder decoder;
+        GLsizei band_rows;                // Texel rows per band
+        std::vector<unsigned int> bands;  // Bands left per level
+        GLint next_level;                 // Level of the next band
+        GLsizei next_y = 0;               // First row of the next band
+    } Stream;
+
+    // Rows of a mip level of a stream, at an offset into a slot.
+    typedef struct Band
+    {
+        Stream* stream;
+        GLint level;
+        GLsizei y;
+        GLsizei height;
+        std::size_t offset;
+    } Band;
+
+    // Pixel Buffer Object of the ring and the bands it holds.
+    typedef struct Slot
+    {
+        enum class State
+        {
+            FREE,
+            DECODING, // Mapped, being filled by the worker thread
+            DECODED,  // Mapped and filled
+            COPYING   // Unmapped, copy fenced
+        };
+
+        GLuint pbo = 0;
+        std::atomic<State> state{State::FREE}; // Set to DECODED by the worker
+        std::vector<Band> bands;
+        void* data = nullptr;
+        GLsync fence = nullptr;
+    } Slot;
+
+    // Body of the worker thread.
+    void run();
+
+    // Maps a free slot for the next bands of the coarsest levels left of
+    // any stream and queues it for the worker. Returns false if no band is
+    // left.
+    bool map(Slot& slot);
+
+    // Counts a band of a stream as complete and makes its levels which
+    // have become complete sampleable.
+    void retire(const Band& band);
+
+    std::size_t m_slot_size;
+    std::array<Slot, k_slot_count> m_slots;
+    std::vector<std::unique_ptr<Stream>> m_streams;
+    std::size_t m_completed = 0; // Fully resident streams
+
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_worker_wake;
+    bool m_stopping = false;
+    std::deque<Slot*> m_jobs; // Slots to decode
+
+    Clock::time_point m_first_request;
+    Clock::duration m_residency_time{0}; // First request to all resident
+    Clock::duration m_update_time{0};    // Spent in update()
+    uint64_t m_updates = 0;
+    uint64_t m_frames = 0; // Updates which uploaded data
+    uint64_t m_bands = 0;
+    uint64_t m_bytes_uploaded = 0;
+    std::size_t m_max_frame_bytes = 0;
+} TextureStreamer;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_TEXTURE_STREAMER_HH_
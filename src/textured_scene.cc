@@ -0,0 +1,234 @@
+// Scene drawing textures as their mip levels are streamed in.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_state.hh"
+#include "program_builder.hh"
+#include "shader.hh"
+#include "texture.hh"
+#include "texture_streamer.hh"
+#include "textured_scene.hh"
+#include "vertices.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <ostream>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+const char* vertex_shader_src =
+#include "shaders/textured.vert"
+;
+
+const char* fragment_shader_src =
+#include "shaders/textured.frag"
+;
+
+const char* vertex_shader_file = "textured.vert";
+const char* fragment_shader_file = "textured.frag";
+
+const TextureFormat k_formats[] = {
+    TextureFormat::RGBA8,
+    TextureFormat::BC1,
+    TextureFormat::BC3,
+    TextureFormat::BC4,
+    TextureFormat::BC5
+};
+
+typedef std::array<GLubyte, 4> Rgba;
+
+// Returns the colour of a texture at (u, v) in [0, 1]: a checkerboard of
+// 8 squares along each side in a colour picked by its index, fading in
+// alpha from bottom to top.
+Rgba texel(unsigned int index, float u, float v)
+{
+    GLubyte r = index * 97 % 256;
+    GLubyte g = (index * 57 + 128) % 256;
+    GLubyte b = (index * 31 + 64) % 256;
+    bool dark = (static_cast<int>(u * 8.0f) + static_cast<int>(v * 8.0f))
+                & 1;
+    int shift = dark ? 1 : 0;
+    return {static_cast<GLubyte>(r >> shift),
+            static_cast<GLubyte>(g >> shift),
+            static_cast<GLubyte>(b >> shift),
+            static_cast<GLubyte>(128 + v * 127.0f)};
+}
+
+// Writes a BC4 block of one value.
+void encode_bc4(GLubyte value, unsigned char* out)
+{
+    out[0] = value;
+    out[1] = value;
+    std::memset(out + 2, 0, 6);
+}
+
+// Writes a BC1 colour block of one colour.
+void encode_bc1(const Rgba& color, unsigned char* out)
+{
+    uint16_t rgb565 = (color[0] >> 3) << 11 | (color[1] >> 2) << 5
+                      | color[2] >> 3;
+    uint32_t indices = 0;
+    std::memcpy(out, &rgb565, 2);
+    std::memcpy(out + 2, &rgb565, 2);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+// Writes a block of a compressed format filled with one colour.
+void encode_block(TextureFormat format, const Rgba& color, unsigned char* out)
+{
+    switch (format)
+    {
+    case TextureFormat::BC1:
+        encode_bc1(color, out);
+        break;
+    case TextureFormat::BC3:
+        encode_bc4(color[3], out);
+        encode_bc1(color, out + 8);
+        break;
+    case TextureFormat::BC4:
+        encode_bc4(color[0], out);
+        break;
+    default:
+        encode_bc4(color[0], out);
+        encode_bc4(color[1], out + 8);
+        break;
+    }
+}
+
+// Generates rows [y, y + height) of a mip level of a texture, encoding each
+// block of a compressed format as the colour at its centre.
+void generate(const Texture& texture, unsigned int index, GLint level,
+              GLsizei y, GLsizei height, void* data)
+{
+    TextureFormat format = texture.get_format();
+    GLsizei width = texture.level_width(level);
+    float level_height = texture.level_height(level);
+    GLsizei row_height = texture_row_height(format);
+    std::size_t row_size = texture_row_size(format, width);
+    std::size_t texel_size = texture_format_compressed(format)
+        ? row_size / ((width + 3) / 4) : 4;
+
+    unsigned char* out = static_cast<unsigned char*>(data);
+    for (GLsizei row = 0; row < height; row += row_height)
+    {
+        float v = (y + row + 0.5f * std::min(row_height, height - row))
+                  / level_height;
+        for (GLsizei x = 0; x < width; x += row_height)
+        {
+            float u = (x + 0.5f * std::min(row_height, width - x)) / width;
+            Rgba color = texel(index, u, v);
+            if (texture_format_compressed(format))
+                encode_block(format, color, out);
+            else
+                std::copy(color.begin(), color.end(), out);
+            out += texel_size;
+        }
+    }
+}
+
+}; // namespace
+
+TexturedScene::~TexturedScene()
+{
+    streamer.reset();
+    GlState::current().delete_vertex_arrays(1, &vao);
+    GlState::current().delete_buffers(1, &vbo);
+}
+
+void TexturedScene::load(ProgramBuilder& programs)
+{
+    programs.add(vertex_shader_src, fragment_shader_src, program,
+                 vertex_shader_file, fragment_shader_file);
+    quad.reset(new Quad({
+        {Position({-1.0f, -1.0f, 0.0f}), PackedTexCoord::from(0.0f, 0.0f)},
+        {Position({1.0f, -1.0f, 0.0f}), PackedTexCoord::from(1.0f, 0.0f)},
+        {Position({-1.0f, 1.0f, 0.0f}), PackedTexCoord::from(0.0f, 1.0f)},
+        {Position({1.0f, 1.0f, 0.0f}), PackedTexCoord::from(1.0f, 1.0f)}
+    }));
+    glGenBuffers(1, &vbo);
+    glGenVertexArrays(1, &vao);
+    quad->use(vao, vbo);
+
+    streamer.reset(new TextureStreamer());
+    for (unsigned int i = 0; i < k_texture_count; ++i)
+    {
+        TextureFormat format = k_formats[i % std::size(k_formats)];
+        if (!texture_format_supported(format))
+            format = TextureFormat::RGBA8;
+        textures.emplace_back(new Texture(format, k_texture_size,
+                                          k_texture_size));
+
+        const Texture& texture = *textures.back();
+        streamer->request(*textures.back(),
+                          [&texture, i](GLint level, GLsizei y,
+                                        GLsizei height, void* data)
+                          {
+                              generate(texture, i, level, y, height, data);
+                          });
+    }
+}
+
+void TexturedScene::prepare()
+{
+    program->use();
+    program->set_uniform("uTexture", 0);
+    program->set_uniform("uScale", 0.9f / k_grid_size);
+}
+
+void TexturedScene::draw(double time)
+{
+    streamer->update();
+
+    program->use();
+    GlState& state = GlState::current();
+    state.active_texture(GL_TEXTURE0);
+    state.bind_vertex_array(vao);
+    const float step = 2.0f / k_grid_size;
+    for (unsigned int i = 0; i < k_texture_count; ++i)
+    {
+        if (!textures[i]->is_drawable())
+            continue;
+
+        std::array<GLfloat, 2> offset{
+            -1.0f + (i % k_grid_size + 0.5f) * step,
+            -1.0f + (i / k_grid_size + 0.5f) * step};
+        program->set_uniform("uOffset", offset);
+        textures[i]->bind();
+        quad->draw(GL_TRIANGLE_STRIP);
+    }
+}
+
+void TexturedScene::report(std::ostream& os) const
+{
+    os << "Textures: " << textures.size() << " of " << k_texture_size << "x"
+       << k_texture_size << " (";
+    for (std::size_t i = 0; i < textures.size() && i < std::size(k_formats);
+         ++i)
+        os << (i ? ", " : "")
+           << texture_format_name(textures[i]->get_format());
+    os << ")" << std::endl;
+    streamer->report(os);
+}
+
+}; // namespace demonia
@@ -0,0 +1,82 @@
+// Scene drawing textures as their mip levels are streamed in.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_TEXTURED_SCENE_HH_
+#define DEMONIA_SRC_TEXTURED_SCENE_HH_
+
+#include "program_builder.hh"
+#include "scene.hh"
+#include "shader.hh"
+#include "texture.hh"
+#include "texture_streamer.hh"
+#include "vertices.hh"
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Draws a grid of k_texture_count quads, each with its own texture of
+// k_texture_size texels square, cycling through the texture formats and
+// falling back to RGBA8 for those which are not supported. The textures are
+// generated on the worker thread of a TextureStreamer and streamed from
+// their coarsest mip level to their finest, and each quad is drawn as soon
+// as its coarsest level is resident.
+typedef class TexturedScene : public Scene
+{
+public:
+    // Number of quads along each side of the grid.
+    static const unsigned int k_grid_size = 4;
+    static const unsigned int k_texture_count = k_grid_size * k_grid_size;
+    static const GLsizei k_texture_size = 1024;
+
+    ~TexturedScene() override;
+
+    void load(ProgramBuilder& programs) override;
+
+    void prepare() override;
+
+    void draw(double time) override;
+
+    // Returns whether textures are still being streamed, so that in
+    // on-demand rendering frames keep being drawn until they are resident.
+    bool is_animated() const override
+    {
+        return streamer && !streamer->is_complete();
+    }
+
+    // Outputs the formats of the textures and the statistics of the
+    // streamer.
+    void report(std::ostream& os) const override;
+
+private:
+    typedef Vertices<Position, PackedTexCoord> Quad;
+
+    std::unique_ptr<ShaderProgram> program;
+    std::unique_ptr<Quad> quad;
+    std::vector<std::unique_ptr<Texture>> textures;
+    std::unique_ptr<TextureStreamer> streamer; // Uses the textures
+    GLuint vbo = 0; // Vertex Buffer Object
+    GLuint vao = 0; // Vertex Array Object
+} TexturedScene;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_TEXTURED_SCENE_HH_
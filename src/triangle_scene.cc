@@ -0,0 +1,57 @@
+// Scene of a single coloured triangle.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_state.hh"
+#include "program_builder.hh"
+#include "triangle_scene.hh"
+#include "vertices.hh"
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+TriangleScene::TriangleScene(bool packed)
+        : m_packed{packed}
+{
+}
+
+TriangleScene::~TriangleScene()
+{
+    GlState::current().delete_vertex_arrays(1, &vao);
+    GlState::current().delete_buffers(1, &vbo);
+}
+
+void TriangleScene::load(ProgramBuilder& programs)
+{
+    glGenBuffers(1, &vbo);
+    glGenVertexArrays(1, &vao);
+    if (m_packed)
+        vertices_packed_color_2d_triangle.use(vao, vbo);
+    else
+        vertices_color_2d_triangle.use(vao, vbo);
+}
+
+void TriangleScene::draw(double time)
+{
+    GlState::current().bind_vertex_array(vao);
+    if (m_packed)
+        vertices_packed_color_2d_triangle.draw(GL_TRIANGLES);
+    else
+        vertices_color_2d_triangle.draw(GL_TRIANGLES);
+}
+
+}; // namespace demonia
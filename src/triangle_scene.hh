@@ -0,0 +1,49 @@
+// Scene of a single coloured triangle.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_TRIANGLE_SCENE_HH_
+#define DEMONIA_SRC_TRIANGLE_SCENE_HH_
+
+#include "program_builder.hh"
+#include "scene.hh"
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Draws vertices_color_2d_triangle, or vertices_packed_color_2d_triangle
+// if packed, with the default colour program.
+typedef class TriangleScene : public Scene
+{
+public:
+    explicit TriangleScene(bool packed = false);
+
+    ~TriangleScene() override;
+
+    void load(ProgramBuilder& programs) override;
+
+    void draw(double time) override;
+
+private:
+    bool m_packed;
+    GLuint vbo = 0; // Vertex Buffer Object
+    GLuint vao = 0; // Vertex Array Object
+} TriangleScene;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_TRIANGLE_SCENE_HH_
@@ -0,0 +1,90 @@
+// Lock-free triple buffer for publishing state between threads.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_TRIPLE_BUFFER_HH_
+#define DEMONIA_SRC_TRIPLE_BUFFER_HH_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace demonia
+{
+
+// Passes the latest of a series of values from one writer thread to one
+// reader thread without locking or either waiting on the other. The writer
+// fills a back buffer and publishes it by swapping it with the middle one;
+// the reader swaps the middle buffer with its front one whenever a new
+// value has been published since its last read, so values published in the
+// meantime are dropped.
+template<typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    // Creates a buffer of which every value is a copy of 'initial'.
+    explicit TripleBuffer(const T& initial)
+            : m_buffers{{initial, initial, initial}}
+    {
+    }
+
+    // Returns the buffer to fill with the next value, which holds an older
+    // value and must be overwritten entirely. Must only be called by the
+    // writer thread.
+    inline T& write_buffer() noexcept
+    {
+        return m_buffers[m_back];
+    }
+
+    // Publishes the write buffer as the latest value. Must only be called by
+    // the writer thread.
+    inline void publish() noexcept
+    {
+        uint8_t middle = m_middle.exchange(m_back | k_fresh,
+                                           std::memory_order_acq_rel);
+        m_back = middle & k_index_mask;
+    }
+
+    // Returns the latest published value, which stays unchanged until the
+    // next read. Must only be called by the reader thread.
+    inline const T& read() noexcept
+    {
+        if (m_middle.load(std::memory_order_relaxed) & k_fresh)
+        {
+            uint8_t middle = m_middle.exchange(m_front,
+                                               std::memory_order_acq_rel);
+            m_front = middle & k_index_mask;
+        }
+        return m_buffers[m_front];
+    }
+
+private:
+    /// The middle index is tagged when it holds a value not yet read
+    static const uint8_t k_index_mask = 3;
+    static const uint8_t k_fresh = 4;
+
+    std::array<T, 3> m_buffers;
+
+    /// Each thread's index is kept on its own cache line
+    alignas(64) uint8_t m_back = 0;
+    alignas(64) std::atomic<uint8_t> m_middle{1};
+    alignas(64) uint8_t m_front = 2;
+};
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_TRIPLE_BUFFER_HH_
@@ -638,8 +638,12 @@ public:
     {
     };
 
+    // Non-const lvalues of the same type are copied by the implicit copy
+    // constructor and assignment operator, not converted element-wise.
     template<typename OtherTuple, typename std::enable_if<
-                detail::TupleConvertible<OtherTuple, Tuple>::value,
+                detail::TupleConvertible<OtherTuple, Tuple>::value
+                && !std::is_same<typename std::decay<OtherTuple>::type,
+                                 Tuple>::value,
                 bool>::type = false>
     Tuple(OtherTuple&& t)
             : impl_(std::forward<OtherTuple>(t))
@@ -647,7 +651,9 @@ public:
     }
 
     template<typename OtherTuple, typename std::enable_if<
-                detail::TupleAssignable<Tuple, OtherTuple>::value,
+                detail::TupleAssignable<Tuple, OtherTuple>::value
+                && !std::is_same<typename std::decay<OtherTuple>::type,
+                                 Tuple>::value,
                 bool>::type = false>
     Tuple& operator=(OtherTuple&& t)
     {
@@ -710,7 +716,7 @@ public:
 // get
 
 template<size_t I, typename... Ts>
-inline typename tuple_element<I, Tuple<Ts...>>::tuple& get(Tuple<Ts...>& t)
+inline typename tuple_element<I, Tuple<Ts...>>::type& get(Tuple<Ts...>& t)
 {
     typedef typename tuple_element<I, Tuple<Ts...>>::type Type;
     return static_cast<detail::TupleLeaf<I, Type>&>(t.impl_).get();
@@ -0,0 +1,185 @@
+// Reflected shader uniforms with type-correct, redundancy-filtered setters.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "gl_exception.hh"
+#include "uniform.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+namespace
+{
+
+// Scalar kind and component count of a GLSL type.
+typedef struct TypeShape
+{
+    enum Kind
+    {
+        FLOAT,
+        INT,
+        UNSIGNED_INT,
+        BOOL,
+        DOUBLE,
+        SAMPLER
+    } kind;
+    unsigned int components;
+} TypeShape;
+
+TypeShape type_shape(GLenum type) noexcept
+{
+    switch (type)
+    {
+    case GL_FLOAT: return {TypeShape::FLOAT, 1};
+    case GL_FLOAT_VEC2: return {TypeShape::FLOAT, 2};
+    case GL_FLOAT_VEC3: return {TypeShape::FLOAT, 3};
+    case GL_FLOAT_VEC4: return {TypeShape::FLOAT, 4};
+    case GL_FLOAT_MAT2: return {TypeShape::FLOAT, 4};
+    case GL_FLOAT_MAT2x3: return {TypeShape::FLOAT, 6};
+    case GL_FLOAT_MAT2x4: return {TypeShape::FLOAT, 8};
+    case GL_FLOAT_MAT3x2: return {TypeShape::FLOAT, 6};
+    case GL_FLOAT_MAT3: return {TypeShape::FLOAT, 9};
+    case GL_FLOAT_MAT3x4: return {TypeShape::FLOAT, 12};
+    case GL_FLOAT_MAT4x2: return {TypeShape::FLOAT, 8};
+    case GL_FLOAT_MAT4x3: return {TypeShape::FLOAT, 12};
+    case GL_FLOAT_MAT4: return {TypeShape::FLOAT, 16};
+    case GL_INT: return {TypeShape::INT, 1};
+    case GL_INT_VEC2: return {TypeShape::INT, 2};
+    case GL_INT_VEC3: return {TypeShape::INT, 3};
+    case GL_INT_VEC4: return {TypeShape::INT, 4};
+    case GL_UNSIGNED_INT: return {TypeShape::UNSIGNED_INT, 1};
+    case GL_UNSIGNED_INT_VEC2: return {TypeShape::UNSIGNED_INT, 2};
+    case GL_UNSIGNED_INT_VEC3: return {TypeShape::UNSIGNED_INT, 3};
+    case GL_UNSIGNED_INT_VEC4: return {TypeShape::UNSIGNED_INT, 4};
+    case GL_BOOL: return {TypeShape::BOOL, 1};
+    case GL_BOOL_VEC2: return {TypeShape::BOOL, 2};
+    case GL_BOOL_VEC3: return {TypeShape::BOOL, 3};
+    case GL_BOOL_VEC4: return {TypeShape::BOOL, 4};
+    case GL_DOUBLE: return {TypeShape::DOUBLE, 1};
+    case GL_DOUBLE_VEC2: return {TypeShape::DOUBLE, 2};
+    case GL_DOUBLE_VEC3: return {TypeShape::DOUBLE, 3};
+    case GL_DOUBLE_VEC4: return {TypeShape::DOUBLE, 4};
+    /// Every remaining opaque type is a sampler, set as a texture unit index
+    default: return {TypeShape::SAMPLER, 1};
+    }
+}
+
+}; // namespace
+
+bool UniformTable::is_compatible(GLenum reflected, GLenum setter) noexcept
+{
+    if (reflected == setter)
+        return true;
+
+    TypeShape r = type_shape(reflected);
+    TypeShape s = type_shape(setter);
+    switch (r.kind)
+    {
+    case TypeShape::BOOL:
+        /// A mat2 has as many components as a bvec4 but is not a vector
+        return r.components == s.components && setter != GL_FLOAT_MAT2
+               && (s.kind == TypeShape::FLOAT || s.kind == TypeShape::INT
+                   || s.kind == TypeShape::UNSIGNED_INT);
+    case TypeShape::SAMPLER:
+        return setter == GL_INT;
+    default:
+        return false;
+    }
+}
+
+std::size_t UniformTable::type_size(GLenum type) noexcept
+{
+    TypeShape shape = type_shape(type);
+    return shape.components
+           * (shape.kind == TypeShape::DOUBLE ? sizeof(GLdouble)
+                                              : sizeof(GLint));
+}
+
+void UniformTable::build(GLuint program)
+{
+    m_entries.clear();
+    m_shadow.clear();
+
+    GLint count = 0;
+    GLint max_length = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    /// Keep the load factor at or below one half so probes stay short
+    std::size_t capacity = 1;
+    while (capacity < 2 * static_cast<std::size_t>(count))
+        capacity <<= 1;
+    m_entries.resize(count > 0 ? capacity : 0);
+
+    std::vector<char> name(max_length + 1);
+    std::size_t shadow_size = 0;
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, i, name.size(), &length, &size, &type,
+                           name.data());
+
+        /// Uniforms in blocks have no location and are set through buffers
+        GLint location = glGetUniformLocation(program, name.data());
+        if (location < 0)
+            continue;
+
+        /// Arrays are reported as 'name[0]' but addressed by 'name'
+        if (length > 3 && std::strcmp(name.data() + length - 3, "[0]") == 0)
+            length -= 3;
+
+        uint32_t hash = UniformName::hash(name.data(), length);
+        if (index_of(hash) >= 0)
+        {
+            std::string msg = "Uniform name hash collision for '"
+                              + std::string(name.data(), length) + "'.\n";
+            throw ProgramLinkException(msg.c_str());
+        }
+
+        uint32_t mask = m_entries.size() - 1;
+        uint32_t slot = hash & mask;
+        while (m_entries[slot].location >= 0)
+            slot = (slot + 1) & mask;
+
+        Entry& entry = m_entries[slot];
+        entry.hash = hash;
+        entry.location = location;
+        entry.type = type;
+        entry.size = size;
+        entry.offset = shadow_size;
+        entry.shadowed = false;
+        shadow_size += type_size(type) * size;
+    }
+
+    m_shadow.resize(shadow_size);
+}
+
+void UniformTable::invalidate() noexcept
+{
+    for (Entry& entry : m_entries)
+        entry.shadowed = false;
+}
+
+}; // namespace demonia
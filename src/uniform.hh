@@ -0,0 +1,326 @@
+// Reflected shader uniforms with type-correct, redundancy-filtered setters.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_UNIFORM_HH_
+#define DEMONIA_SRC_UNIFORM_HH_
+
+#include "hash.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <GL/glew.h>
+
+namespace demonia
+{
+
+// Name of a uniform, identified by its 32-bit FNV-1a hash. Constructing it
+// from a string literal is a constant expression, so a name declared
+// constexpr, or passed as a literal to an inlined setter, is hashed at compile
+// time.
+typedef class UniformName
+{
+public:
+    template<std::size_t N>
+    constexpr UniformName(const char (&name)[N]) noexcept
+            : m_hash{hash(name, N - 1)}
+    {
+    }
+
+    constexpr UniformName(const char* name, std::size_t length) noexcept
+            : m_hash{hash(name, length)}
+    {
+    }
+
+    constexpr uint32_t get_hash() const noexcept
+    {
+        return m_hash;
+    }
+
+    static constexpr uint32_t hash(const char* name, std::size_t length)
+        noexcept
+    {
+        return fnv1a<uint32_t>(name, length);
+    }
+
+private:
+    uint32_t m_hash;
+} UniformName;
+
+// Column-major matrix of floats for use as a uniform value.
+template<std::size_t Columns, std::size_t Rows>
+struct UniformMatrix
+{
+    static_assert(Columns >= 2 && Columns <= 4 && Rows >= 2 && Rows <= 4,
+                  "uniform matrices must have 2 to 4 columns and rows");
+
+    std::array<GLfloat, Columns * Rows> data;
+};
+
+// Maps a C++ uniform value type to its GLSL type and upload function.
+// Supported types are GLfloat, GLint and GLuint, std::array vectors of 2 to 4
+// of those, and UniformMatrix.
+template<typename T>
+struct UniformTraits;
+
+template<>
+struct UniformTraits<GLfloat>
+{
+    static constexpr GLenum type = GL_FLOAT;
+
+    static void upload(GLint location, GLsizei count, const GLfloat* values)
+        noexcept
+    {
+        glUniform1fv(location, count, values);
+    }
+};
+
+template<>
+struct UniformTraits<GLint>
+{
+    static constexpr GLenum type = GL_INT;
+
+    static void upload(GLint location, GLsizei count, const GLint* values)
+        noexcept
+    {
+        glUniform1iv(location, count, values);
+    }
+};
+
+template<>
+struct UniformTraits<GLuint>
+{
+    static constexpr GLenum type = GL_UNSIGNED_INT;
+
+    static void upload(GLint location, GLsizei count, const GLuint* values)
+        noexcept
+    {
+        glUniform1uiv(location, count, values);
+    }
+};
+
+template<std::size_t N>
+struct UniformTraits<std::array<GLfloat, N>>
+{
+    static_assert(N >= 2 && N <= 4, "uniform vectors must have 2 to 4 \
+                                     components");
+    static constexpr GLenum type = N == 2 ? GL_FLOAT_VEC2
+                                 : N == 3 ? GL_FLOAT_VEC3 : GL_FLOAT_VEC4;
+
+    static void upload(GLint location, GLsizei count,
+                       const std::array<GLfloat, N>* values) noexcept
+    {
+        const GLfloat* data = values->data();
+        if constexpr (N == 2)
+            glUniform2fv(location, count, data);
+        else if constexpr (N == 3)
+            glUniform3fv(location, count, data);
+        else
+            glUniform4fv(location, count, data);
+    }
+};
+
+template<std::size_t N>
+struct UniformTraits<std::array<GLint, N>>
+{
+    static_assert(N >= 2 && N <= 4, "uniform vectors must have 2 to 4 \
+                                     components");
+    static constexpr GLenum type = N == 2 ? GL_INT_VEC2
+                                 : N == 3 ? GL_INT_VEC3 : GL_INT_VEC4;
+
+    static void upload(GLint location, GLsizei count,
+                       const std::array<GLint, N>* values) noexcept
+    {
+        const GLint* data = values->data();
+        if constexpr (N == 2)
+            glUniform2iv(location, count, data);
+        else if constexpr (N == 3)
+            glUniform3iv(location, count, data);
+        else
+            glUniform4iv(location, count, data);
+    }
+};
+
+template<std::size_t N>
+struct UniformTraits<std::array<GLuint, N>>
+{
+    static_assert(N >= 2 && N <= 4, "uniform vectors must have 2 to 4 \
+                                     components");
+    static constexpr GLenum type = N == 2 ? GL_UNSIGNED_INT_VEC2
+                                 : N == 3 ? GL_UNSIGNED_INT_VEC3
+                                 : GL_UNSIGNED_INT_VEC4;
+
+    static void upload(GLint location, GLsizei count,
+                       const std::array<GLuint, N>* values) noexcept
+    {
+        const GLuint* data = values->data();
+        if constexpr (N == 2)
+            glUniform2uiv(location, count, data);
+        else if constexpr (N == 3)
+            glUniform3uiv(location, count, data);
+        else
+            glUniform4uiv(location, count, data);
+    }
+};
+
+template<std::size_t Columns, std::size_t Rows>
+struct UniformTraits<UniformMatrix<Columns, Rows>>
+{
+    static constexpr GLenum types[3][3] = {
+        {GL_FLOAT_MAT2, GL_FLOAT_MAT2x3, GL_FLOAT_MAT2x4},
+        {GL_FLOAT_MAT3x2, GL_FLOAT_MAT3, GL_FLOAT_MAT3x4},
+        {GL_FLOAT_MAT4x2, GL_FLOAT_MAT4x3, GL_FLOAT_MAT4}
+    };
+    static constexpr GLenum type = types[Columns - 2][Rows - 2];
+
+    static void upload(GLint location, GLsizei count,
+                       const UniformMatrix<Columns, Rows>* values) noexcept
+    {
+        const GLfloat* data = values->data.data();
+        if constexpr (Columns == 2 && Rows == 2)
+            glUniformMatrix2fv(location, count, GL_FALSE, data);
+        else if constexpr (Columns == 2 && Rows == 3)
+            glUniformMatrix2x3fv(location, count, GL_FALSE, data);
+        else if constexpr (Columns == 2 && Rows == 4)
+            glUniformMatrix2x4fv(location, count, GL_FALSE, data);
+        else if constexpr (Columns == 3 && Rows == 2)
+            glUniformMatrix3x2fv(location, count, GL_FALSE, data);
+        else if constexpr (Columns == 3 && Rows == 3)
+            glUniformMatrix3fv(location, count, GL_FALSE, data);
+        else if constexpr (Columns == 3 && Rows == 4)
+            glUniformMatrix3x4fv(location, count, GL_FALSE, data);
+        else if constexpr (Columns == 4 && Rows == 2)
+            glUniformMatrix4x2fv(location, count, GL_FALSE, data);
+        else if constexpr (Columns == 4 && Rows == 3)
+            glUniformMatrix4x3fv(location, count, GL_FALSE, data);
+        else
+            glUniformMatrix4fv(location, count, GL_FALSE, data);
+    }
+};
+
+// Table of the active default-block uniforms of a linked program, addressed
+// by name hash with open addressing. Keeps a shadow copy of every uniform's
+// value so that uploads which would not change it are skipped.
+typedef class UniformTable
+{
+public:
+    typedef struct Entry
+    {
+        uint32_t hash;
+        GLint location = -1; // Unused slot if negative
+        GLenum type;
+        GLsizei size;        // Number of array elements
+        uint32_t offset;     // Offset of the shadow copy in bytes
+        bool shadowed;       // Whether the shadow copy holds the value
+    } Entry;
+
+    // Enumerates the active uniforms of a linked program. If two uniform
+    // names have the same hash, throws a ProgramLinkException.
+    void build(GLuint program);
+
+    // Returns the entry for a uniform, or null if the uniform is not active.
+    inline const Entry* find(UniformName name) const noexcept
+    {
+        int index = index_of(name.get_hash());
+        return index < 0 ? nullptr : &m_entries[index];
+    }
+
+    // Uploads up to 'count' array elements of a uniform of the program
+    // currently in use, unless they are equal to the shadowed values. Returns
+    // false if the uniform is not active or its type does not match T.
+    template<typename T>
+    bool set(UniformName name, const T* values, GLsizei count) noexcept
+    {
+        int index = index_of(name.get_hash());
+        if (index < 0)
+            return false;
+
+        Entry& entry = m_entries[index];
+        if (!is_compatible(entry.type, UniformTraits<T>::type))
+            return false;
+
+        if (count > entry.size)
+            count = entry.size;
+
+        std::size_t bytes = sizeof(T) * count;
+        unsigned char* shadow = m_shadow.data() + entry.offset;
+        if (entry.shadowed && std::memcmp(shadow, values, bytes) == 0)
+        {
+            ++m_skipped;
+            return true;
+        }
+
+        std::memcpy(shadow, values, bytes);
+        /// Only a write of the whole array leaves every element known
+        entry.shadowed = count == entry.size;
+        UniformTraits<T>::upload(entry.location, count, values);
+        ++m_uploaded;
+        return true;
+    }
+
+    // Invalidates the shadowed values, forcing the next set of each uniform
+    // to be uploaded.
+    void invalidate() noexcept;
+
+    // Returns the number of uploads performed and skipped as redundant.
+    inline uint64_t uploaded() const noexcept
+    {
+        return m_uploaded;
+    }
+
+    inline uint64_t skipped() const noexcept
+    {
+        return m_skipped;
+    }
+
+private:
+    // Returns the index of the entry with the given hash, or -1.
+    inline int index_of(uint32_t hash) const noexcept
+    {
+        if (m_entries.empty())
+            return -1;
+
+        uint32_t mask = m_entries.size() - 1;
+        for (uint32_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            const Entry& entry = m_entries[i];
+            if (entry.location < 0)
+                return -1;
+            if (entry.hash == hash)
+                return i;
+        }
+    }
+
+    // Returns whether a setter of a given GLSL type may upload a uniform of
+    // the reflected type; booleans accept any scalar type of the same width
+    // and samplers accept integers.
+    static bool is_compatible(GLenum reflected, GLenum setter) noexcept;
+
+    // Returns the size in bytes of a value of a reflected uniform type.
+    static std::size_t type_size(GLenum type) noexcept;
+
+    std::vector<Entry> m_entries;
+    std::vector<unsigned char> m_shadow;
+    uint64_t m_uploaded = 0;
+    uint64_t m_skipped = 0;
+} UniformTable;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_UNIFORM_HH_
@@ -0,0 +1,108 @@
+// Fixed time step update thread.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#include "update_thread.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <ios>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <utility>
+
+namespace demonia
+{
+
+const unsigned int UpdateThread::k_max_catch_up = 8;
+
+UpdateThread::UpdateThread(UpdateFunction update, double rate)
+        : m_update{std::move(update)}, m_step{1.0 / rate}
+{
+}
+
+UpdateThread::~UpdateThread()
+{
+    stop();
+}
+
+void UpdateThread::start(Clock::time_point start_time)
+{
+    m_start_time = start_time;
+    m_stopping = false;
+    m_thread = std::thread(&UpdateThread::run, this);
+}
+
+void UpdateThread::stop()
+{
+    if (!m_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+void UpdateThread::report(std::ostream& os) const
+{
+    std::ios_base::fmtflags flags = os.flags();
+    os << std::fixed << std::setprecision(1)
+       << "Updates: " << m_updates << " at "
+       << (m_elapsed > 0.0 ? m_updates / m_elapsed : 0.0)
+       << " per second (target " << 1.0 / m_step << "), " << m_late
+       << " late, " << m_dropped << " dropped" << std::endl;
+    os.flags(flags);
+}
+
+void UpdateThread::run()
+{
+    std::chrono::duration<double> step(m_step);
+    uint64_t tick = 0; // Updates scheduled, including those dropped
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        Clock::time_point deadline = m_start_time
+            + std::chrono::duration_cast<Clock::duration>((tick + 1) * step);
+        if (m_wake.wait_until(lock, deadline, [this]() { return m_stopping; }))
+            break;
+
+        Clock::time_point now = Clock::now();
+        if (now - deadline > k_max_catch_up * step)
+        {
+            uint64_t behind = (now - deadline) / step;
+            m_dropped += behind;
+            tick += behind;
+        }
+        else if (now - deadline > step)
+        {
+            ++m_late;
+        }
+
+        ++tick;
+        lock.unlock();
+        m_update(tick * m_step, m_step);
+        ++m_updates;
+        m_elapsed = std::chrono::duration<double>(
+                Clock::now() - m_start_time).count();
+        lock.lock();
+    }
+}
+
+}; // namespace demonia
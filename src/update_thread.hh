@@ -0,0 +1,87 @@
+// Fixed time step update thread.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_UPDATE_THREAD_HH_
+#define DEMONIA_SRC_UPDATE_THREAD_HH_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+namespace demonia
+{
+
+// Calls an update function at a fixed rate on a background thread, so that
+// the simulation advances at the same rate however long frames take to
+// render. Updates which fall behind their deadlines are run back to back
+// to catch up; if more than k_max_catch_up behind, the missed updates are
+// dropped instead and the schedule restarts from the current time.
+typedef class UpdateThread
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Function advancing a simulation to 'time' seconds since the start by
+    // one time step of 'step' seconds.
+    typedef std::function<void(double time, double step)> UpdateFunction;
+
+    static const unsigned int k_max_catch_up;
+
+    // Creates a thread calling 'update' at 'rate' updates per second.
+    UpdateThread(UpdateFunction update, double rate);
+
+    // Stops the thread if started.
+    ~UpdateThread();
+
+    UpdateThread(const UpdateThread&) = delete;
+    UpdateThread& operator=(const UpdateThread&) = delete;
+
+    // Starts the thread, scheduling update n at start_time plus n steps.
+    void start(Clock::time_point start_time);
+
+    // Stops the thread, without waiting for the next update.
+    void stop();
+
+    // Outputs the achieved update rate and the late and dropped updates.
+    void report(std::ostream& os) const;
+
+private:
+    // Body of the background thread.
+    void run();
+
+    UpdateFunction m_update;
+    double m_step;
+    Clock::time_point m_start_time;
+    std::thread m_thread;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+
+    /// Written by the background thread, read after it has been joined
+    uint64_t m_updates = 0;
+    uint64_t m_late = 0; // Started more than a step after their deadline
+    uint64_t m_dropped = 0;
+    double m_elapsed = 0.0;
+} UpdateThread;
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_UPDATE_THREAD_HH_
@@ -14,14 +14,15 @@
 // You should have received a copy of the GNU General Public License
 // along with this program. If not, see <https://www.gnu.org/licenses/>.
 
+#include "packing.hh"
 #include "vertices.hh"
 
+#include <cstddef>
+#include <cstdint>
+
 namespace demonia
 {
 
-constexpr VertexAttribute::Metadata Position::metadata{3, GL_FLOAT, false};
-constexpr VertexAttribute::Metadata Color::metadata{3, GL_FLOAT, false};
-
 Position::Position(Data data)
         : m_data{data}
 {
@@ -32,4 +33,102 @@ Color::Color(Data data)
 {
 };
 
+HalfPosition::HalfPosition(Data data)
+        : m_data{data}
+{
+};
+
+void HalfPosition::pack(const GLfloat* in, HalfPosition* out, size_t count)
+{
+    static_assert(sizeof(HalfPosition) == sizeof(GLhalf) * 4);
+    pack_half(in, reinterpret_cast<uint16_t*>(out), count * 4);
+}
+
+HalfPosition HalfPosition::from(GLfloat x, GLfloat y, GLfloat z)
+{
+    const GLfloat in[4] = {x, y, z, 1.0f};
+    HalfPosition out;
+    pack(in, &out, 1);
+    return out;
+}
+
+Position::Data HalfPosition::unpack() const noexcept
+{
+    return {unpack_half(m_data.x), unpack_half(m_data.y),
+            unpack_half(m_data.z)};
+}
+
+PackedNormal::PackedNormal(Data data)
+        : m_data{data}
+{
+};
+
+void PackedNormal::pack(const GLfloat* in, PackedNormal* out, size_t count)
+{
+    static_assert(sizeof(PackedNormal) == sizeof(GLuint));
+    pack_snorm_2_10_10_10(in, reinterpret_cast<uint32_t*>(out), count);
+}
+
+PackedNormal PackedNormal::from(GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+    const GLfloat in[4] = {x, y, z, w};
+    PackedNormal out;
+    pack(in, &out, 1);
+    return out;
+}
+
+PackedColor::PackedColor(Data data)
+        : m_data{data}
+{
+};
+
+void PackedColor::pack(const GLfloat* in, PackedColor* out, size_t count)
+{
+    static_assert(sizeof(PackedColor) == sizeof(GLubyte) * 4);
+    pack_unorm8(in, reinterpret_cast<uint8_t*>(out), count * 4);
+}
+
+PackedColor PackedColor::from(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+{
+    const GLfloat in[4] = {r, g, b, a};
+    PackedColor out;
+    pack(in, &out, 1);
+    return out;
+}
+
+PackedTexCoord::PackedTexCoord(Data data)
+        : m_data{data}
+{
+};
+
+void PackedTexCoord::pack(const GLfloat* in, PackedTexCoord* out,
+                          size_t count)
+{
+    static_assert(sizeof(PackedTexCoord) == sizeof(GLushort) * 2);
+    pack_unorm16(in, reinterpret_cast<uint16_t*>(out), count * 2);
+}
+
+PackedTexCoord PackedTexCoord::from(GLfloat u, GLfloat v)
+{
+    const GLfloat in[2] = {u, v};
+    PackedTexCoord out;
+    pack(in, &out, 1);
+    return out;
+}
+
+TexLayer::TexLayer(Data data)
+        : m_data{data}
+{
+};
+
+Offset::Offset(Data data)
+        : m_data{data}
+{
+};
+
+Tint::Tint(Data data)
+        : m_data{data}
+{
+};
+
 }; // namespace demonia
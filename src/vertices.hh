@@ -17,16 +17,24 @@
 #ifndef DEMONIA_SRC_VERTICES_HH_
 #define DEMONIA_SRC_VERTICES_HH_
 
+#include "bounds.hh"
+#include "gl_type.hh"
+#include "gl_state.hh"
+#include "gl_usage.hh"
+#include "indices.hh"
+#include "mesh_optimizer.hh"
+#include "packing.hh"
+#include "streaming_buffer.hh"
 #include "tuple.hh"
 
+#include <array>
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <initializer_list>
-#include <iostream>
-#include <map>
-#include <sstream>
-#include <stdexcept>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <GL/glew.h>
@@ -56,7 +64,7 @@ struct Position : public VertexAttribute
 
     Position(Data data);
 
-    static const Metadata metadata;
+    static constexpr Metadata metadata{3, GL_FLOAT, false};
     Data m_data;
 };
 
@@ -70,7 +78,136 @@ struct Color : public VertexAttribute
 
     Color(Data data);
 
-    static const Metadata metadata;
+    static constexpr Metadata metadata{3, GL_FLOAT, false};
+    Data m_data;
+};
+
+// Packed attributes, converted from floats in bulk by pack() with the
+// kernels of packing.hh, or one at a time by from().
+
+// Position as four half-precision floats, w being 1, for half the size of
+// Position with 11 bits of precision.
+typedef struct HalfPosition HalfPosition;
+struct HalfPosition : public VertexAttribute
+{
+    typedef struct Data
+    {
+        GLhalf x, y, z, w;
+    } Data;
+
+    HalfPosition(Data data = {});
+
+    // Packs count vectors of four floats (x, y, z, w).
+    static void pack(const GLfloat* in, HalfPosition* out, size_t count);
+
+    static HalfPosition from(GLfloat x, GLfloat y, GLfloat z);
+
+    // Returns the position converted back into floats.
+    Position::Data unpack() const noexcept;
+
+    static constexpr Metadata metadata{4, GL_HALF_FLOAT, false};
+    Data m_data;
+};
+
+// Normal or tangent as signed normalized 10-10-10-2 values, w holding the
+// sign of a tangent's bitangent.
+typedef struct PackedNormal PackedNormal;
+struct PackedNormal : public VertexAttribute
+{
+    typedef GLuint Data;
+
+    PackedNormal(Data data = 0);
+
+    // Packs count vectors of four floats (x, y, z, w).
+    static void pack(const GLfloat* in, PackedNormal* out, size_t count);
+
+    static PackedNormal from(GLfloat x, GLfloat y, GLfloat z,
+                             GLfloat w = 0.0f);
+
+    static constexpr Metadata metadata{4, GL_INT_2_10_10_10_REV, true};
+    Data m_data;
+};
+
+// Color as four normalized unsigned bytes.
+typedef struct PackedColor PackedColor;
+struct PackedColor : public VertexAttribute
+{
+    typedef struct Data
+    {
+        GLubyte r, g, b, a;
+    } Data;
+
+    PackedColor(Data data = {});
+
+    // Packs count vectors of four floats (r, g, b, a).
+    static void pack(const GLfloat* in, PackedColor* out, size_t count);
+
+    static PackedColor from(GLfloat r, GLfloat g, GLfloat b,
+                            GLfloat a = 1.0f);
+
+    static constexpr Metadata metadata{4, GL_UNSIGNED_BYTE, true};
+    Data m_data;
+};
+
+// Texture coordinates in [0, 1] as two normalized unsigned shorts.
+typedef struct PackedTexCoord PackedTexCoord;
+struct PackedTexCoord : public VertexAttribute
+{
+    typedef struct Data
+    {
+        GLushort u, v;
+    } Data;
+
+    PackedTexCoord(Data data = {});
+
+    // Packs count vectors of two floats (u, v).
+    static void pack(const GLfloat* in, PackedTexCoord* out, size_t count);
+
+    static PackedTexCoord from(GLfloat u, GLfloat v);
+
+    static constexpr Metadata metadata{2, GL_UNSIGNED_SHORT, true};
+    Data m_data;
+};
+
+// Layer of an array texture, such as one packed by a TextureAtlas.
+typedef struct TexLayer TexLayer;
+struct TexLayer : public VertexAttribute
+{
+    typedef GLfloat Data;
+
+    TexLayer(Data data = 0.0f);
+
+    static constexpr Metadata metadata{1, GL_FLOAT, false};
+    Data m_data;
+};
+
+// Per-instance attributes.
+
+typedef struct Offset Offset;
+struct Offset : public VertexAttribute
+{
+    typedef struct Data
+    {
+        GLfloat x, y, z;
+    } Data;
+
+    Offset(Data data);
+
+    static constexpr Metadata metadata{3, GL_FLOAT, false};
+    Data m_data;
+};
+
+typedef struct Tint Tint;
+struct Tint : public VertexAttribute
+{
+    typedef struct Data
+    {
+        GLfloat r, g, b;
+    } Data;
+
+    Tint(Data data);
+
+    static constexpr Metadata metadata{3, GL_FLOAT, false};
     Data m_data;
 };
 
@@ -90,71 +227,123 @@ struct is_vertex_attribute<T>
     static const bool value = std::is_base_of<VertexAttribute, T>::value;
 };
 
-const std::map<GLenum, size_t> gl_type_sizes
-    {
-        {GL_BYTE, sizeof(GLbyte)},
-        {GL_UNSIGNED_BYTE, sizeof(GLubyte)},
-        {GL_SHORT, sizeof(GLshort)},
-        {GL_INT, sizeof(GLint)},
-        {GL_UNSIGNED_INT, sizeof(GLuint)},
-        {GL_HALF_FLOAT, sizeof(GLhalf)},
-        {GL_FLOAT, sizeof(GLfloat)},
-        {GL_DOUBLE, sizeof(GLdouble)},
-        {GL_FIXED, sizeof(GLfixed)},
-        {GL_INT_2_10_10_10_REV, sizeof(GLint)},
-        {GL_UNSIGNED_INT_2_10_10_10_REV, sizeof(GLuint)},
-        {GL_UNSIGNED_INT_10F_11F_11F_REV, sizeof(GLuint)}
-    };
-
-// Expected usage patterns of data stores. Castable to GLenum.
-enum class GlUsage
-{
-    STREAM_DRAW = GL_STREAM_DRAW,
-    STREAM_READ = GL_STREAM_READ,
-    STREAM_COPY = GL_STREAM_COPY,
-    STATIC_DRAW = GL_STATIC_DRAW,
-    STATIC_READ = GL_STATIC_READ,
-    STATIC_COPY = GL_STATIC_COPY,
-    DYNAMIC_DRAW = GL_DYNAMIC_DRAW,
-    DYNAMIC_READ = GL_DYNAMIC_READ,
-    DYNAMIC_COPY = GL_DYNAMIC_COPY
-};
-
-// Creates a usable set of vertices.
+// Index of the attribute of type T in a vertex tuple, or the number of
+// attributes of the vertex if it has none.
+template<typename T, typename Vertex>
+struct vertex_attribute_index;
+
+template<typename T>
+struct vertex_attribute_index<T, Tuple<>>
+{
+    static const size_t value = 0;
+};
+
+template<typename T, typename... Ts>
+struct vertex_attribute_index<T, Tuple<T, Ts...>>
+{
+    static const size_t value = 0;
+};
+
+template<typename T, typename U, typename... Ts>
+struct vertex_attribute_index<T, Tuple<U, Ts...>>
+{
+    static const size_t value = 1 + vertex_attribute_index<T, Tuple<Ts...>>
+        ::value;
+};
+
+// Returns the size in bytes of a vertex attribute described by metadata.
+constexpr size_t attribute_size(const VertexAttribute::Metadata& metadata)
+    noexcept
+{
+    return gl_attribute_size(metadata.size, metadata.type);
+}
+
+// Interleaved layout of a vertex made of a sequence of attributes, computed
+// at compile time from the attributes' metadata.
+template<typename... Attributes>
+struct VertexLayout
+{
+    static constexpr size_t count = sizeof...(Attributes);
+
+    static constexpr std::array<VertexAttribute::Metadata, count> metadata{
+        Attributes::metadata...};
+
+    static constexpr std::array<size_t, count> sizes{
+        attribute_size(Attributes::metadata)...};
+
+    // Byte offsets of each attribute from the start of a vertex.
+    static constexpr std::array<size_t, count> offsets = []()
+        {
+            std::array<size_t, count> result{};
+            for (size_t i = 1; i < count; ++i)
+                result[i] = result[i - 1] + sizes[i - 1];
+            return result;
+        }();
+
+    static constexpr GLsizei stride =
+        offsets[count - 1] + sizes[count - 1];
+};
+
+// Vertex storage policies.
+
+// Stores each vertex as one interleaved record in a single buffer (array of
+// structures).
+typedef struct InterleavedStorage
+{
+} InterleavedStorage;
+
+// Stores each attribute as a tightly packed stream in its own buffer
+// (structure of arrays), so that attributes can be uploaded and updated
+// independently of each other.
+typedef struct SeparateStorage
+{
+} SeparateStorage;
+
+// Creates a usable set of vertices, stored according to a storage policy.
+template<typename Storage, typename AttributeFirst, typename... AttributeRest>
+class BasicVertices;
+
+// Creates a usable set of vertices stored as interleaved records.
+template<typename AttributeFirst, typename... AttributeRest>
+using Vertices = BasicVertices<InterleavedStorage, AttributeFirst,
+                               AttributeRest...>;
+
+// Creates a usable set of vertices stored as one stream per attribute.
 template<typename AttributeFirst, typename... AttributeRest>
-class Vertices
+using SeparateVertices = BasicVertices<SeparateStorage, AttributeFirst,
+                                       AttributeRest...>;
+
+template<typename AttributeFirst, typename... AttributeRest>
+class BasicVertices<InterleavedStorage, AttributeFirst, AttributeRest...>
 {
 public:
     typedef Tuple<AttributeFirst, AttributeRest...> Vertex;
+    typedef VertexLayout<AttributeFirst, AttributeRest...> Layout;
+
+    static_assert(is_vertex_attribute<AttributeFirst, AttributeRest...>::value,
+                  "attributes must be derived from type 'VertexAttribute'");
 
     // Creates a set of vertices from a list of attribute data tuples and
     // an optional list of indices describing the order in which the vertices
-    // should be rendered.
-    Vertices(std::initializer_list<Vertex> data,
-             std::initializer_list<GLuint> indices = {})
-            : m_data{data}, m_indices{indices}
+    // should be rendered. The indices are packed into the narrowest type for
+    // the number of vertices, and may contain Indices::k_restart. Throws a
+    // BufferException if any other index is out of range.
+    BasicVertices(std::initializer_list<Vertex> data,
+                  std::initializer_list<GLuint> indices = {})
+            : m_data{data}, m_indices{indices, data.size()}
     {
-        static_assert(is_vertex_attribute<AttributeFirst, AttributeRest...
-                                         >::value,
-                      "attributes must be derived from type 'VertexAttribute'");
-
-        metadata = {AttributeFirst::metadata, AttributeRest::metadata...};
-        for (auto& attrib : metadata)
-        {
-            try
-            {
-                stride += attrib.size * gl_type_sizes.at(attrib.type);
-            }
-            catch (std::out_of_range)
-            {
-                std::stringstream msg;
-                msg << "Failed to initialize vertices: no size associated with \
-                        GL data type '" << attrib.type << "'.";
-                std::runtime_error(msg.str());
-            }
-        }
+        check_layout();
+        update_bounds();
+    }
 
-        buffer_size = sizeof(Vertex) * data.size();
+    // Creates a set of vertices from a vector of attribute data tuples and an
+    // optional vector of indices.
+    BasicVertices(std::vector<Vertex> data,
+                  const std::vector<GLuint>& indices = {})
+            : m_data{std::move(data)}, m_indices{indices, m_data.size()}
+    {
+        check_layout();
+        update_bounds();
     }
 
     // Copies vertex data into a Vertex Buffer Object, and links and enables
@@ -165,24 +354,15 @@ public:
         noexcept
     {
         // Copy data into VBO
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, buffer_size, m_data.data(),
-                     static_cast<GLenum>(usage));
+        update(vbo, usage);
 
         // Link and enable attributes
-        glBindVertexArray(vao);
-        for (int i = 0, ptr = 0; i < metadata.size(); ++i)
-        {
-            auto& attrib = metadata[i];
-            glVertexAttribPointer(i, attrib.size, attrib.type,
-                                  attrib.normalized, stride,
-                                  (void*) static_cast<intptr_t>(ptr));
-            glEnableVertexAttribArray(i);
-            ptr += attrib.size * gl_type_sizes.at(attrib.type);
-        }
+        GlState::current().bind_vertex_array(vao);
+        link_attributes(0, std::index_sequence_for<AttributeFirst,
+                                                   AttributeRest...>());
 
         // Unbind VAO for use
-        glBindVertexArray(0);
+        GlState::current().bind_vertex_array(0);
     }
 
     // Copies vertex data into a Vertex Buffer Object, links and enables
@@ -194,19 +374,472 @@ public:
         const noexcept
     {
         use(vao, vbo, usage);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_indices),
-                     m_indices.data(), static_cast<GLenum>(usage));
+
+        // The element buffer binding is part of the VAO's state
+        GlState::current().bind_vertex_array(vao);
+        m_indices.use(ebo, usage);
+        GlState::current().bind_vertex_array(0);
+    }
+
+    // Copies the vertex data into a Vertex Buffer Object again after it has
+    // been modified, replacing every attribute of every vertex.
+    void update(GLuint vbo, GlUsage usage = GlUsage::STREAM_DRAW) const
+        noexcept
+    {
+        GlState::current().bind_buffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * m_data.size(),
+                     m_data.data(), static_cast<GLenum>(usage));
+    }
+
+    // Writes the vertex data into the current region of a streaming buffer
+    // and links the attributes in a Vertex Array Object to it, avoiding the
+    // implicit synchronisation of update() for data written every frame.
+    void stream(GLuint vao, StreamingBuffer& buffer) const
+    {
+        GLintptr offset = buffer.write(m_data.data(),
+                                       sizeof(Vertex) * m_data.size());
+        GlState::current().bind_vertex_array(vao);
+        buffer.bind();
+        link_attributes(offset, std::index_sequence_for<AttributeFirst,
+                                                        AttributeRest...>());
+        GlState::current().bind_vertex_array(0);
+    }
+
+    // Merges identical vertices, then reorders the triangles for the
+    // post-transform vertex cache and the vertices for fetch locality, before
+    // the vertices are used. Returns statistics from before and after. Throws
+    // BufferException, leaving the vertices unchanged, unless they are a
+    // triangle list, indexed or not: strips and restart indices are rejected.
+    MeshOptimization optimize()
+    {
+        std::vector<GLuint> indices = m_indices.unpack();
+        MeshOptimization result = optimize_mesh(m_data, indices);
+        m_indices = Indices(indices, m_data.size());
+        return result;
+    }
+
+    // Returns the vertex data for modification.
+    inline std::vector<Vertex>& get_data() noexcept
+    {
+        return m_data;
+    }
+
+    // Returns the number of vertices.
+    inline GLsizei size() const noexcept
+    {
+        return m_data.size();
+    }
+
+    // Returns the box containing the positions of the vertices, computed
+    // when they were created, or an empty box if they have neither a Position
+    // nor a HalfPosition.
+    inline const Aabb& get_bounds() const noexcept
+    {
+        return m_bounds;
+    }
+
+    // Recomputes the bounds after the positions have been modified through
+    // get_data().
+    void update_bounds() noexcept
+    {
+        constexpr size_t position = vertex_attribute_index<Position, Vertex>
+            ::value;
+        constexpr size_t half_position =
+            vertex_attribute_index<HalfPosition, Vertex>::value;
+        m_bounds = Aabb();
+        if constexpr (position < Layout::count)
+        {
+            for (const Vertex& vertex : m_data)
+            {
+                const Position::Data& data = get<position>(vertex).m_data;
+                m_bounds.extend(data.x, data.y, data.z);
+            }
+        }
+        else if constexpr (half_position < Layout::count)
+        {
+            for (const Vertex& vertex : m_data)
+            {
+                Position::Data data = get<half_position>(vertex).unpack();
+                m_bounds.extend(data.x, data.y, data.z);
+            }
+        }
+    }
+
+    // Returns the packed indices.
+    inline const Indices& get_indices() const noexcept
+    {
+        return m_indices;
+    }
+
+    // Draws every vertex, or the indexed vertices if there are indices, as
+    // primitives of a mode in one call for each of a number of instances.
+    // The Vertex Array Object linked by use() must be bound.
+    void draw(GLenum mode, GLsizei instance_count = 1) const noexcept
+    {
+        if (!m_indices.empty())
+            m_indices.draw(mode, instance_count);
+        else if (instance_count == 1)
+            glDrawArrays(mode, 0, size());
+        else
+            glDrawArraysInstanced(mode, 0, size(), instance_count);
+    }
+
+    // Links and enables the attributes in the bound Vertex Array Object to
+    // interleaved vertices at a byte offset into the buffer bound to
+    // GL_ARRAY_BUFFER, for vertex data held elsewhere, such as a mapped
+    // MeshFile.
+    static void link(GLintptr base = 0) noexcept
+    {
+        link_attributes(base, std::index_sequence_for<AttributeFirst,
+                                                      AttributeRest...>());
     }
 
     static constexpr GlUsage USAGE_DEFAULT = GlUsage::STATIC_DRAW;
 
 private:
-    GLsizei stride = 0;
-    size_t buffer_size;
+    // Checks that vertex records match the computed layout.
+    void check_layout() const noexcept
+    {
+        static_assert(check_attribute_sizes(
+                          std::index_sequence_for<AttributeFirst,
+                                                  AttributeRest...>()),
+                      "attribute sizes must match their metadata");
+        static_assert(sizeof(Vertex) == Layout::stride,
+                      "vertex must be tightly packed in declaration order");
+
+        if (!m_data.empty())
+            assert(check_attribute_offsets(m_data.front(),
+                                           std::index_sequence_for<
+                                               AttributeFirst,
+                                               AttributeRest...>()));
+    }
+
+    // Returns whether the size of every attribute type matches the size
+    // given by its metadata.
+    template<size_t... Is>
+    static constexpr bool check_attribute_sizes(std::index_sequence<Is...>)
+        noexcept
+    {
+        return ((sizeof(typename tuple_element<Is, Vertex>::type)
+                 == Layout::sizes[Is]) && ...);
+    }
+
+    // Returns whether the attributes of a vertex lie at the offsets of the
+    // layout. Base subobject offsets are not constant expressions, so this
+    // is checked on a real vertex in debug builds.
+    template<size_t... Is>
+    static bool check_attribute_offsets(const Vertex& vertex,
+                                        std::index_sequence<Is...>) noexcept
+    {
+        auto base = reinterpret_cast<const char*>(&vertex);
+        return ((reinterpret_cast<const char*>(&get<Is>(vertex)) - base
+                 == static_cast<std::ptrdiff_t>(Layout::offsets[Is])) && ...);
+    }
+
+    // Links and enables every attribute in the bound Vertex Array Object to
+    // vertices starting at an offset in the bound buffer, as one unrolled
+    // sequence of GL calls.
+    template<size_t... Is>
+    static void link_attributes(GLintptr base, std::index_sequence<Is...>)
+        noexcept
+    {
+        ((glVertexAttribPointer(Is, Layout::metadata[Is].size,
+                                Layout::metadata[Is].type,
+                                Layout::metadata[Is].normalized,
+                                Layout::stride,
+                                reinterpret_cast<const void*>(
+                                    base + Layout::offsets[Is])),
+          glEnableVertexAttribArray(Is)), ...);
+    }
+
     std::vector<Vertex> m_data;
-    std::vector<GLuint> m_indices;
-    std::vector<VertexAttribute::Metadata> metadata;
+    Indices m_indices;
+    Aabb m_bounds;
+};
+
+template<typename AttributeFirst, typename... AttributeRest>
+class BasicVertices<SeparateStorage, AttributeFirst, AttributeRest...>
+{
+public:
+    typedef Tuple<AttributeFirst, AttributeRest...> Vertex;
+    typedef VertexLayout<AttributeFirst, AttributeRest...> Layout;
+
+    // Buffer Objects holding each attribute stream, in attribute order.
+    typedef std::array<GLuint, Layout::count> Buffers;
+
+    // Vector of the values of one attribute.
+    template<size_t I>
+    using Stream = std::vector<typename tuple_element<I, Vertex>::type>;
+
+    static_assert(is_vertex_attribute<AttributeFirst, AttributeRest...>::value,
+                  "attributes must be derived from type 'VertexAttribute'");
+
+    // Creates a set of vertices from a list of attribute data tuples, split
+    // into one stream per attribute, and an optional list of indices
+    // describing the order in which the vertices should be rendered.
+    BasicVertices(std::initializer_list<Vertex> data,
+                  std::initializer_list<GLuint> indices = {})
+            : m_indices{indices, data.size()}
+    {
+        scatter(data.begin(), data.end(), Indexes());
+        update_bounds();
+    }
+
+    // Creates a set of vertices from a vector of attribute data tuples and an
+    // optional vector of indices.
+    BasicVertices(const std::vector<Vertex>& data,
+                  const std::vector<GLuint>& indices = {})
+            : m_indices{indices, data.size()}
+    {
+        scatter(data.begin(), data.end(), Indexes());
+        update_bounds();
+    }
+
+    // Copies each attribute stream into its own Vertex Buffer Object, and
+    // links and enables the attributes in a Vertex Array Object for the set
+    // of vertices to be used in rendering. The expected usage pattern of each
+    // data store may optionally be specified.
+    void use(GLuint vao, const Buffers& vbos, GlUsage usage = USAGE_DEFAULT)
+        const noexcept
+    {
+        Usages usages;
+        usages.fill(usage);
+        use(vao, vbos, usages);
+    }
+
+    // Copies each attribute stream into its own Vertex Buffer Object with its
+    // own expected usage pattern, so that frequently updated streams can be
+    // hinted differently from static ones.
+    void use(GLuint vao, const Buffers& vbos,
+             const std::array<GlUsage, Layout::count>& usages) const noexcept
+    {
+        GlState::current().bind_vertex_array(vao);
+        link_attributes(vbos, usages, Indexes());
+        GlState::current().bind_vertex_array(0);
+    }
+
+    // Copies the attribute streams and indices into their buffers, and links
+    // and enables the attributes in a Vertex Array Object.
+    void use(GLuint vao, const Buffers& vbos, GLuint ebo,
+             GlUsage usage = USAGE_DEFAULT) const noexcept
+    {
+        use(vao, vbos, usage);
+        GlState::current().bind_vertex_array(vao);
+        m_indices.use(ebo, usage);
+        GlState::current().bind_vertex_array(0);
+    }
+
+    // Copies one attribute stream into its Vertex Buffer Object again after
+    // it has been modified, leaving the other streams untouched.
+    template<size_t I>
+    void update(GLuint vbo, GlUsage usage = GlUsage::STREAM_DRAW) const
+        noexcept
+    {
+        const Stream<I>& stream = std::get<I>(m_streams);
+        GlState::current().bind_buffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, Layout::sizes[I] * stream.size(),
+                     stream.data(), static_cast<GLenum>(usage));
+    }
+
+    // Writes one attribute stream into the current region of a streaming
+    // buffer and links its attribute in a Vertex Array Object to it, leaving
+    // the other streams in their own buffers.
+    template<size_t I>
+    void stream(GLuint vao, StreamingBuffer& buffer) const
+    {
+        const Stream<I>& stream = std::get<I>(m_streams);
+        GLintptr offset = buffer.write(stream.data(),
+                                       Layout::sizes[I] * stream.size());
+        GlState::current().bind_vertex_array(vao);
+        buffer.bind();
+        glVertexAttribPointer(I, Layout::metadata[I].size,
+                              Layout::metadata[I].type,
+                              Layout::metadata[I].normalized,
+                              Layout::sizes[I],
+                              reinterpret_cast<const void*>(offset));
+        GlState::current().bind_vertex_array(0);
+    }
+
+    // Returns an attribute stream for modification.
+    template<size_t I>
+    inline Stream<I>& get_stream() noexcept
+    {
+        return std::get<I>(m_streams);
+    }
+
+    // Returns the number of vertices.
+    inline GLsizei size() const noexcept
+    {
+        return std::get<0>(m_streams).size();
+    }
+
+    // Returns the box containing the positions of the vertices, computed
+    // when they were created, or an empty box if they have neither a Position
+    // nor a HalfPosition.
+    inline const Aabb& get_bounds() const noexcept
+    {
+        return m_bounds;
+    }
+
+    // Recomputes the bounds after the Position stream has been modified
+    // through get_stream().
+    void update_bounds() noexcept
+    {
+        constexpr size_t position = vertex_attribute_index<Position, Vertex>
+            ::value;
+        constexpr size_t half_position =
+            vertex_attribute_index<HalfPosition, Vertex>::value;
+        m_bounds = Aabb();
+        if constexpr (position < Layout::count)
+        {
+            for (const Position& value : std::get<position>(m_streams))
+                m_bounds.extend(value.m_data.x, value.m_data.y,
+                                value.m_data.z);
+        }
+        else if constexpr (half_position < Layout::count)
+        {
+            for (const HalfPosition& value : std::get<half_position>(m_streams))
+            {
+                Position::Data data = value.unpack();
+                m_bounds.extend(data.x, data.y, data.z);
+            }
+        }
+    }
+
+    // Returns the packed indices.
+    inline const Indices& get_indices() const noexcept
+    {
+        return m_indices;
+    }
+
+    // Draws every vertex, or the indexed vertices if there are indices, as
+    // primitives of a mode in one call for each of a number of instances.
+    // The Vertex Array Object linked by use() must be bound.
+    void draw(GLenum mode, GLsizei instance_count = 1) const noexcept
+    {
+        if (!m_indices.empty())
+            m_indices.draw(mode, instance_count);
+        else if (instance_count == 1)
+            glDrawArrays(mode, 0, size());
+        else
+            glDrawArraysInstanced(mode, 0, size(), instance_count);
+    }
+
+    static constexpr GlUsage USAGE_DEFAULT = GlUsage::STATIC_DRAW;
+
+private:
+    typedef std::index_sequence_for<AttributeFirst, AttributeRest...> Indexes;
+    typedef std::array<GlUsage, Layout::count> Usages;
+
+    // Copies each attribute of a range of vertices into its stream.
+    template<typename Iterator, size_t... Is>
+    void scatter(Iterator begin, Iterator end, std::index_sequence<Is...>)
+    {
+        static_assert(((sizeof(typename tuple_element<Is, Vertex>::type)
+                        == Layout::sizes[Is]) && ...),
+                      "attribute sizes must match their metadata");
+
+        (std::get<Is>(m_streams).reserve(end - begin), ...);
+        for (Iterator it = begin; it != end; ++it)
+            (std::get<Is>(m_streams).push_back(get<Is>(*it)), ...);
+    }
+
+    // Uploads each stream and links its attribute to its buffer, as one
+    // unrolled sequence of GL calls.
+    template<size_t... Is>
+    void link_attributes(const Buffers& vbos, const Usages& usages,
+                         std::index_sequence<Is...>) const noexcept
+    {
+        ((update<Is>(vbos[Is], usages[Is]),
+          glVertexAttribPointer(Is, Layout::metadata[Is].size,
+                                Layout::metadata[Is].type,
+                                Layout::metadata[Is].normalized,
+                                Layout::sizes[Is], nullptr),
+          glEnableVertexAttribArray(Is)), ...);
+    }
+
+    std::tuple<std::vector<AttributeFirst>, std::vector<AttributeRest>...>
+        m_streams;
+    Indices m_indices;
+    Aabb m_bounds;
+};
+
+// Creates a set of per-instance attributes, stored as interleaved records in
+// their own buffer and advanced once per instance rather than once per
+// vertex, to be drawn with the instanced draw calls of a set of vertices.
+template<typename AttributeFirst, typename... AttributeRest>
+class Instances
+{
+public:
+    typedef Tuple<AttributeFirst, AttributeRest...> Instance;
+    typedef VertexLayout<AttributeFirst, AttributeRest...> Layout;
+
+    static_assert(is_vertex_attribute<AttributeFirst, AttributeRest...>::value,
+                  "attributes must be derived from type 'VertexAttribute'");
+    static_assert(sizeof(Instance) == Layout::stride,
+                  "instance must be tightly packed in declaration order");
+
+    // Creates a set of instances from a vector of attribute data tuples.
+    Instances(std::vector<Instance> data)
+            : m_data{std::move(data)}
+    {
+    }
+
+    // Copies instance data into a Vertex Buffer Object, and links and
+    // enables the attributes in a Vertex Array Object at consecutive
+    // locations from first_location, following those of the vertices, with
+    // a divisor of 1. The expected usage pattern of the data store may
+    // optionally be specified.
+    void use(GLuint vao, GLuint vbo, GLuint first_location,
+             GlUsage usage = GlUsage::STATIC_DRAW) const noexcept
+    {
+        update(vbo, usage);
+        GlState::current().bind_vertex_array(vao);
+        link_attributes(first_location,
+                        std::index_sequence_for<AttributeFirst,
+                                                AttributeRest...>());
+        GlState::current().bind_vertex_array(0);
+    }
+
+    // Copies the instance data into a Vertex Buffer Object again after it
+    // has been modified.
+    void update(GLuint vbo, GlUsage usage = GlUsage::STREAM_DRAW) const
+        noexcept
+    {
+        GlState::current().bind_buffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * m_data.size(),
+                     m_data.data(), static_cast<GLenum>(usage));
+    }
+
+    // Returns the instance data for modification.
+    inline std::vector<Instance>& get_data() noexcept
+    {
+        return m_data;
+    }
+
+    // Returns the number of instances.
+    inline GLsizei size() const noexcept
+    {
+        return m_data.size();
+    }
+
+private:
+    template<size_t... Is>
+    static void link_attributes(GLuint first_location,
+                                std::index_sequence<Is...>) noexcept
+    {
+        ((glVertexAttribPointer(first_location + Is,
+                                Layout::metadata[Is].size,
+                                Layout::metadata[Is].type,
+                                Layout::metadata[Is].normalized,
+                                Layout::stride,
+                                reinterpret_cast<const void*>(
+                                    Layout::offsets[Is])),
+          glEnableVertexAttribArray(first_location + Is),
+          glVertexAttribDivisor(first_location + Is, 1)), ...);
+    }
+
+    std::vector<Instance> m_data;
 };
 
 // Vertices for a 2D triangle with only a position attribute.
@@ -225,6 +858,17 @@ const Vertices<Position, Color> vertices_color_2d_triangle({
         {{{  0.0f,  0.5f, 0.0f }},  {{ 0.0f, 0.0f, 1.0f }}}  // top
     });
 
+// Vertices for a 2D triangle with packed position and color attributes,
+// taking 12 rather than 24 bytes per vertex.
+const Vertices<HalfPosition, PackedColor> vertices_packed_color_2d_triangle({
+        { HalfPosition::from(  0.5f, -0.5f, 0.0f ),
+          PackedColor::from( 1.0f, 0.0f, 0.0f ) }, // bottom right
+        { HalfPosition::from( -0.5f, -0.5f, 0.0f ),
+          PackedColor::from( 0.0f, 1.0f, 0.0f ) }, // bottom left
+        { HalfPosition::from(  0.0f,  0.5f, 0.0f ),
+          PackedColor::from( 0.0f, 0.0f, 1.0f ) }  // top
+    });
+
 }; // namespace demonia
 
 #endif // DEMONIA_SRC_VERTICES_HH_
@@ -0,0 +1,115 @@
+// Lock-free work-stealing deque.
+// Copyright (C) 2022 Natalie Wiggins
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef DEMONIA_SRC_WORK_DEQUE_HH_
+#define DEMONIA_SRC_WORK_DEQUE_HH_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace demonia
+{
+
+// Fixed-capacity deque of values to which one owner thread pushes and from
+// which it pops at the bottom, while any thread may steal from the top
+// without locking (Chase and Lev, with the memory orderings of Lê et al.).
+// T must be trivially copyable and lock-free as an atomic; 'empty' is
+// returned when there is no value and must never be pushed. Capacity must
+// be a power of two.
+template<typename T, std::size_t Capacity, T Empty = T()>
+class WorkDeque
+{
+public:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "deque capacity must be a power of two");
+
+    // Appends a value at the bottom; returns false without blocking if the
+    // deque is full. Must only be called by the owner thread.
+    bool push(T value) noexcept
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_acquire);
+        if (bottom - top >= static_cast<int64_t>(Capacity))
+            return false;
+
+        m_data[bottom & (Capacity - 1)].store(value,
+                                              std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Removes the newest value; returns Empty if the deque is empty or the
+    // last value was stolen. Must only be called by the owner thread.
+    T pop() noexcept
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return Empty;
+        }
+
+        T value = m_data[bottom & (Capacity - 1)].load(
+                std::memory_order_relaxed);
+        if (top == bottom)
+        {
+            /// Last value: race thieves for it
+            if (!m_top.compare_exchange_strong(top, top + 1,
+                                               std::memory_order_seq_cst,
+                                               std::memory_order_relaxed))
+                value = Empty;
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    // Removes the oldest value; returns Empty if the deque is empty or
+    // another thread took the value first. May be called by any thread.
+    T steal() noexcept
+    {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom)
+            return Empty;
+
+        T value = m_data[top & (Capacity - 1)].load(
+                std::memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(top, top + 1,
+                                           std::memory_order_seq_cst,
+                                           std::memory_order_relaxed))
+            return Empty;
+        return value;
+    }
+
+private:
+    /// The owner and thieves work at opposite ends, kept on separate cache
+    /// lines
+    alignas(64) std::atomic<int64_t> m_top{0};
+    alignas(64) std::atomic<int64_t> m_bottom{0};
+    alignas(64) std::array<std::atomic<T>, Capacity> m_data;
+};
+
+}; // namespace demonia
+
+#endif // DEMONIA_SRC_WORK_DEQUE_HH_